@@ -16,43 +16,36 @@
 /* Logging includes. */
 #include "logging.h"
 
-/* CLI includes. */
-#include "FreeRTOS_CLI.h"
-
-/* Pcap capture includes. */
-#include "pcap_capture.h"
-
-/* FreeRTOS-tdlogger includes. */
-#include "FreeRTOS_TD_Logger.h"
+/* CLI server includes. */
+#include "cli_server.h"
 
 /* Exception info. */
 #include "expinfo.h"
 
 /* Demo definitions. */
-#define mainCLI_TASK_STACK_SIZE             512
+/* Stack of each CLI server task, in words. The commands run on it down to the
+ * vsnprintf() of FreeRTOS_CLIPrintf(), while the buffers of a request are kept
+ * in the workers. configCHECK_FOR_STACK_OVERFLOW catches an overflow on the
+ * board, the host build gives the tasks larger stacks. */
+#ifndef mainCLI_TASK_STACK_SIZE
+    #define mainCLI_TASK_STACK_SIZE         512
+#endif
+/* Priority of the bulk commands, the other CLI tasks run up to 3 levels
+ * above. */
 #define mainCLI_TASK_PRIORITY               tskIDLE_PRIORITY
 
 /* Logging module configuration. */
-#define mainLOGGING_TASK_STACK_SIZE         256
+#ifndef mainLOGGING_TASK_STACK_SIZE
+    #define mainLOGGING_TASK_STACK_SIZE     256
+#endif
 #define mainLOGGING_TASK_PRIORITY           tskIDLE_PRIORITY
 #define mainLOGGING_QUEUE_LENGTH            10
 
-#define mainMAX_UDP_RESPONSE_SIZE           1024
-/*-----------------------------------------------------------*/
-
-#include "pack_struct_start.h"
-struct xPacketHeader
-{
-    uint8_t ucStartMarker;
-    uint8_t ucPacketNumber;
-    uint16_t usPayloadLength;
-    uint8_t ucRequestId[4];
-}
-#include "pack_struct_end.h"
-typedef struct xPacketHeader PacketHeader_t;
-
-#define PACKET_HEADER_LENGTH    sizeof( PacketHeader_t )
-#define PACKET_START_MARKER     0x55
+/* Network interface driver. The host build selects the Linux or the loopback
+ * driver instead of the STM32H7 Ethernet MAC. */
+#ifndef mainFILL_INTERFACE_DESCRIPTOR
+    #define mainFILL_INTERFACE_DESCRIPTOR   pxSTM32H_FillInterfaceDescriptor
+#endif
 /*-----------------------------------------------------------*/
 
 uint32_t ulTim7Tick = 0;
@@ -65,36 +58,14 @@ static BaseType_t xTasksAlreadyCreated = pdFALSE;
 
 extern RNG_HandleTypeDef hrng;
 
-static char cInputCommandString[ configMAX_COMMAND_INPUT_SIZE + 1 ];
-
-static uint8_t ucUdpResponseBuffer[ mainMAX_UDP_RESPONSE_SIZE + PACKET_HEADER_LENGTH ];
-
 static NetworkInterface_t xInterfaces[ 1 ];
 
 static NetworkEndPoint_t xEndPoints[ 1 ];
 /*-----------------------------------------------------------*/
 
-static void prvCliTask( void * pvParameters );
-
 static void prvConfigureMPU( void );
 
 static void prvRegisterCLICommands( void );
-
-static BaseType_t prvIsValidRequest( const uint8_t * pucPacket, uint32_t ulPacketLength, uint8_t * pucRequestId );
-
-static BaseType_t prvSendCommandResponse( Socket_t xCLIServerSocket,
-                                          struct freertos_sockaddr * pxSourceAddress,
-                                          socklen_t xSourceAddressLength,
-                                          uint8_t *pucPacketNumber,
-                                          uint8_t *pucRequestId,
-                                          const uint8_t * pucResponse,
-                                          uint32_t ulResponseLength );
-
-static BaseType_t prvSendResponseEndMarker( Socket_t xCLIServerSocket,
-                                            struct freertos_sockaddr * pxSourceAddress,
-                                            socklen_t xSourceAddressLength,
-                                            uint8_t *pucPacketNumber,
-                                            uint8_t *pucRequestId );
 /*-----------------------------------------------------------*/
 
 void app_main( void )
@@ -107,6 +78,15 @@ void app_main( void )
 
     prvConfigureMPU();
 
+    /* Start the DWT cycle counter the CLI commands are profiled with. There
+     * is no DWT in the host build. */
+    #if defined( __arm__ )
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    #endif
+
     /* Register all the commands with the FreeRTOS+CLI command
      * interpreter. */
     prvRegisterCLICommands();
@@ -116,9 +96,9 @@ void app_main( void )
                                    mainLOGGING_QUEUE_LENGTH );
     configASSERT( xRet == pdPASS );
 
-    extern NetworkInterface_t * pxSTM32H_FillInterfaceDescriptor( BaseType_t xEMACIndex,
-                                                                  NetworkInterface_t * pxInterface );
-    pxSTM32H_FillInterfaceDescriptor( 0, &( xInterfaces[ 0 ] ) );
+    extern NetworkInterface_t * mainFILL_INTERFACE_DESCRIPTOR( BaseType_t xEMACIndex,
+                                                               NetworkInterface_t * pxInterface );
+    mainFILL_INTERFACE_DESCRIPTOR( 0, &( xInterfaces[ 0 ] ) );
     FreeRTOS_FillEndPoint( &( xInterfaces[ 0 ] ),
                            &( xEndPoints[ 0 ] ),
                            ucIPAddress,
@@ -126,7 +106,11 @@ void app_main( void )
                            ucGatewayAddress,
                            ucDNSServerAddress,
                            ucMACAddress );
-    xEndPoints[ 0 ].bits.bWantDHCP = pdTRUE;
+    #if ( ipconfigUSE_DHCP != 0 )
+    {
+        xEndPoints[ 0 ].bits.bWantDHCP = pdTRUE;
+    }
+    #endif
     memcpy( ipLOCAL_MAC_ADDRESS, ucMACAddress, sizeof( ucMACAddress ) );
     FreeRTOS_IPInit_Multi();
 
@@ -140,174 +124,6 @@ void app_main( void )
 }
 /*-----------------------------------------------------------*/
 
-static void prvCliTask( void *pvParameters )
-{
-    uint32_t ulResponseLength;
-    BaseType_t xCount, xResponseRemaining, xResponseSent;
-    Socket_t xCLIServerSocket = FREERTOS_INVALID_SOCKET;
-    struct freertos_sockaddr xSourceAddress, xServerAddress;
-    socklen_t xSourceAddressLength = sizeof( xSourceAddress );
-    TickType_t xCLIServerRecvTimeout = portMAX_DELAY;
-    char * pcOutputBuffer = FreeRTOS_CLIGetOutputBuffer();
-
-    ( void ) pvParameters;
-
-    xCLIServerSocket = FreeRTOS_socket( FREERTOS_AF_INET,
-                                        FREERTOS_SOCK_DGRAM,
-                                        FREERTOS_IPPROTO_UDP );
-    configASSERT( xCLIServerSocket != FREERTOS_INVALID_SOCKET );
-
-    /* No need to return from FreeRTOS_recvfrom until a message
-     * is received. */
-    FreeRTOS_setsockopt( xCLIServerSocket,
-                         0,
-                         FREERTOS_SO_RCVTIMEO,
-                         &( xCLIServerRecvTimeout ),
-                         sizeof( TickType_t ) );
-
-    xServerAddress.sin_port = FreeRTOS_htons( configCLI_SERVER_PORT );
-    xServerAddress.sin_family = FREERTOS_AF_INET;
-    xServerAddress.sin_address.ulIP_IPv4 = FreeRTOS_GetIPAddress();
-    FreeRTOS_bind( xCLIServerSocket, &( xServerAddress ), sizeof( xServerAddress ) );
-
-    configPRINTF( ( "Waiting for requests...\n" ) );
-
-    for( ;; )
-    {
-        uint8_t ucRequestId[ 4 ];
-
-        xCount = FreeRTOS_recvfrom( xCLIServerSocket,
-                                    ( void * )( &( cInputCommandString[ 0 ] ) ),
-                                    configMAX_COMMAND_INPUT_SIZE,
-                                    0,
-                                    &( xSourceAddress ),
-                                    &( xSourceAddressLength ) );
-
-        /* Since we set the receive timeout to portMAX_DELAY, the
-         * above call should only return when a command is received. */
-        configASSERT( xCount > 0 );
-        cInputCommandString[ xCount ] = '\0';
-
-        if( prvIsValidRequest( ( const uint8_t * ) &( cInputCommandString[ 0 ] ), xCount, &( ucRequestId[ 0 ] ) ) == pdTRUE )
-        {
-            uint8_t ucPacketNumber = 1;
-
-            configPRINTF( ( "Received command. IP:%x Port:%u Content:%s \n", xSourceAddress.sin_address.ulIP_IPv4,
-                                                                             xSourceAddress.sin_port,
-                                                                             &( cInputCommandString[ PACKET_HEADER_LENGTH ] ) ) );
-
-            do
-            {
-                /* Send the received command to the FreeRTOS+CLI. */
-                xResponseRemaining = FreeRTOS_CLIProcessCommand( &( cInputCommandString[ PACKET_HEADER_LENGTH ] ),
-                                                                    pcOutputBuffer,
-                                                                    configCOMMAND_INT_MAX_OUTPUT_SIZE - 1 );
-
-                /* Ensure null termination so that the strlen below does not
-                 * end up reading past bounds. */
-                pcOutputBuffer[ configCOMMAND_INT_MAX_OUTPUT_SIZE - 1 ] = '\0';
-
-                ulResponseLength = strlen( pcOutputBuffer );
-
-                /* HACK - Check if the output buffer contains one of our special
-                 * markers indicating the need of a special response and process
-                 * accordingly. */
-                if( strncmp( pcOutputBuffer, "PCAP-GET", ulResponseLength ) == 0 )
-                {
-                    const uint8_t * pucPcapData;
-                    size_t uxPcapDataLength;
-
-                    PcapCapture_GetCapturedData( &( pucPcapData ),
-                                                 &( uxPcapDataLength) );
-
-                    xResponseSent = prvSendCommandResponse( xCLIServerSocket,
-                                                            &( xSourceAddress ),
-                                                            xSourceAddressLength,
-                                                            &( ucPacketNumber ),
-                                                            &( ucRequestId [ 0 ] ),
-                                                            pucPcapData,
-                                                            uxPcapDataLength );
-
-                    /* Next fetch should not get the same capture but the capture
-                     * after this point. */
-                    PcapCapture_Reset();
-                }
-                else if( strncmp( pcOutputBuffer, "TRACE-GET", ulResponseLength ) == 0 )
-                {
-                    const uint8_t * pucTraceCapture;
-                    size_t xTraceCaptureLength;
-
-                    FreeRTOS_TD_Logger_GetTrace( &( pucTraceCapture ),
-                                                 &( xTraceCaptureLength) );
-
-                    xResponseSent = prvSendCommandResponse( xCLIServerSocket,
-                                                            &( xSourceAddress ),
-                                                            xSourceAddressLength,
-                                                            &( ucPacketNumber ),
-                                                            &( ucRequestId [ 0 ] ),
-                                                            pucTraceCapture,
-                                                            xTraceCaptureLength );
-
-                    /* Next fetch should not include this trace but the trace
-                     * after this point. */
-                    FreeRTOS_TD_Logger_Reset();
-                }
-                else if( strncmp( pcOutputBuffer, "COREDUMP-GET", ulResponseLength ) == 0 )
-                {
-                    const uint8_t * pucDumpAddress;
-                    uint32_t ulDumpLength;
-
-                    /* Get dump address/length. */
-                    if( ExpInfo_GetInfo( &pucDumpAddress, &ulDumpLength ) != pdFALSE )
-                    {
-                        /* Send dump address/length to host. */
-                        xResponseSent = prvSendCommandResponse( xCLIServerSocket,
-                                                                &( xSourceAddress ),
-                                                                xSourceAddressLength,
-                                                                &( ucPacketNumber ),
-                                                                &( ucRequestId [ 0 ] ),
-                                                                pucDumpAddress,
-                                                                ulDumpLength );
-                    }
-                }
-                else
-                {
-                    /* Send the command response. */
-                    xResponseSent = prvSendCommandResponse( xCLIServerSocket,
-                                                            &( xSourceAddress ),
-                                                            xSourceAddressLength,
-                                                            &( ucPacketNumber ),
-                                                            &( ucRequestId [ 0 ] ),
-                                                            ( const uint8_t * ) pcOutputBuffer,
-                                                            ulResponseLength );
-                }
-
-                if( xResponseSent == pdPASS )
-                {
-                    configPRINTF( ( "Response sent successfully. \n" ) );
-                }
-                else
-                {
-                    configPRINTF( ( "[ERROR] Failed to send response. \n" ) );
-                }
-            } while( xResponseRemaining == pdTRUE );
-
-            /* Send the last packet with zero payload length. */
-            ( void ) prvSendResponseEndMarker( xCLIServerSocket,
-                                               &( xSourceAddress ),
-                                               xSourceAddressLength,
-                                               &( ucPacketNumber ),
-                                               &( ucRequestId [ 0 ] ) );
-        }
-        else
-        {
-            configPRINTF( ( "[ERROR] Malformed request. IP:%x Port:%u Content:%s \n", xSourceAddress.sin_address.ulIP_IPv4,
-                                                                                      xSourceAddress.sin_port,
-                                                                                      cInputCommandString ) );
-        }
-    }
-}
-/*-----------------------------------------------------------*/
 
 static void prvRegisterCLICommands( void )
 {
@@ -318,6 +134,8 @@ extern void vRegisterTopCommand( void );
 extern void vRegisterTraceCommand( void );
 extern void vRegisterExceptionCommand( void );
 extern void vRegisterFirewallCommands( void );
+extern void vRegisterCliStatsCommand( void );
+extern void vRegisterBundleCommand( void );
 
     vRegisterPingCommand();
     vRegisterPcapCommand();
@@ -325,6 +143,8 @@ extern void vRegisterFirewallCommands( void );
     vRegisterTopCommand();
     vRegisterTraceCommand();
     vRegisterExceptionCommand();
+    vRegisterCliStatsCommand();
+    vRegisterBundleCommand();
 
     /* Add the following Firewall Commands
 
@@ -338,6 +158,15 @@ extern void vRegisterFirewallCommands( void );
     Example: firewall-remove 1
     */
     vRegisterFirewallCommands();
+
+    /* The health checks are served before, and above, the other commands.
+     * The long outputs are served last, the transfers of the pcap, trace and
+     * coredump commands are already declared as bulk by their opcodes, the
+     * health bundle as critical by its own. */
+    ( void ) xCliServerSetCommandClass( "ping", CLI_CLASS_CRITICAL );
+    ( void ) xCliServerSetCommandClass( "netstat", CLI_CLASS_CRITICAL );
+    ( void ) xCliServerSetCommandClass( "cli-stats", CLI_CLASS_CRITICAL );
+    ( void ) xCliServerSetCommandClass( "help", CLI_CLASS_BULK );
 }
 /*-----------------------------------------------------------*/
 
@@ -367,125 +196,6 @@ static void prvConfigureMPU( void )
 }
 /*-----------------------------------------------------------*/
 
-static BaseType_t prvIsValidRequest( const uint8_t * pucPacket, uint32_t ulPacketLength, uint8_t * pucRequestId )
-{
-    BaseType_t xValidRequest = pdFALSE;
-    PacketHeader_t * header;
-    uint16_t usPayloadLength;
-
-    if( ulPacketLength > PACKET_HEADER_LENGTH )
-    {
-        header = ( PacketHeader_t * )pucPacket;
-        usPayloadLength = FreeRTOS_ntohs( header->usPayloadLength );
-
-        if( ( header->ucStartMarker == PACKET_START_MARKER ) &&
-            ( header->ucPacketNumber == 1 ) &&
-            ( ( usPayloadLength + PACKET_HEADER_LENGTH ) == ulPacketLength ) )
-        {
-            xValidRequest = pdTRUE;
-            memcpy( pucRequestId, &( header->ucRequestId[ 0 ] ), 4 );
-        }
-    }
-
-    return xValidRequest;
-}
-/*-----------------------------------------------------------*/
-
-static BaseType_t prvSendResponseEndMarker( Socket_t xCLIServerSocket,
-                                            struct freertos_sockaddr * pxSourceAddress,
-                                            socklen_t xSourceAddressLength,
-                                            uint8_t *pucPacketNumber,
-                                            uint8_t *pucRequestId )
-{
-    BaseType_t ret;
-    PacketHeader_t header;
-    int32_t lBytesSent;
-
-    header.ucStartMarker = PACKET_START_MARKER;
-    header.ucPacketNumber = *pucPacketNumber;
-    header.usPayloadLength = 0U;
-    memcpy( &( header.ucRequestId[ 0 ] ), pucRequestId, 4 );
-
-    lBytesSent = FreeRTOS_sendto( xCLIServerSocket,
-                                  ( const void * ) &( header ),
-                                  sizeof( PacketHeader_t ),
-                                  0,
-                                  pxSourceAddress,
-                                  xSourceAddressLength );
-
-    if( lBytesSent != PACKET_HEADER_LENGTH )
-    {
-        configPRINTF( ("[ERROR] Failed to last response header.\n" ) );
-        ret = pdFAIL;
-    }
-
-    return ret;
-}
-/*-----------------------------------------------------------*/
-
-static BaseType_t prvSendCommandResponse( Socket_t xCLIServerSocket,
-                                          struct freertos_sockaddr * pxSourceAddress,
-                                          socklen_t xSourceAddressLength,
-                                          uint8_t *pucPacketNumber,
-                                          uint8_t *pucRequestId,
-                                          const uint8_t * pucResponse,
-                                          uint32_t ulResponseLength )
-{
-    BaseType_t ret = pdPASS;
-    PacketHeader_t header;
-    int32_t lBytesSent;
-    uint32_t ulBytesToSend, ulRemainingBytes, ulBytesSent;
-
-    ulRemainingBytes = ulResponseLength;
-    ulBytesSent = 0;
-
-    while( ulRemainingBytes > 0 )
-    {
-        ulBytesToSend = ulRemainingBytes;
-
-        if( ulBytesToSend > mainMAX_UDP_RESPONSE_SIZE )
-        {
-            ulBytesToSend = mainMAX_UDP_RESPONSE_SIZE;
-        }
-
-        /* Write header to the response buffer. */
-        header.ucStartMarker = PACKET_START_MARKER;
-        header.ucPacketNumber = *pucPacketNumber;
-        *pucPacketNumber = ( *pucPacketNumber ) + 1;
-        header.usPayloadLength = FreeRTOS_htons( ( uint16_t ) ulBytesToSend );
-        memcpy( &( header.ucRequestId[ 0 ] ), pucRequestId, 4 );
-
-        memcpy( &( ucUdpResponseBuffer[ 0 ] ),
-                &( header ),
-                PACKET_HEADER_LENGTH );
-
-        /* Write actual response to the buffer. */
-        memcpy( &( ucUdpResponseBuffer[ PACKET_HEADER_LENGTH] ),
-                &( pucResponse[ ulBytesSent ] ),
-                ulBytesToSend );
-
-        /* Send response. */
-        lBytesSent = FreeRTOS_sendto( xCLIServerSocket,
-                                      ( const void * ) &( ucUdpResponseBuffer[ 0 ] ),
-                                      ulBytesToSend + PACKET_HEADER_LENGTH,
-                                      0,
-                                      pxSourceAddress,
-                                      xSourceAddressLength );
-
-        if( lBytesSent != ( ulBytesToSend + PACKET_HEADER_LENGTH ) )
-        {
-            configPRINTF( ("[ERROR] Failed to send response.\n" ) );
-            ret = pdFAIL;
-            break;
-        }
-
-        ulRemainingBytes -= ulBytesToSend;
-        ulBytesSent += ulBytesToSend;
-    }
-
-    return ret;
-}
-/*-----------------------------------------------------------*/
 
 uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
                                              uint16_t usSourcePort,
@@ -521,12 +231,8 @@ void vApplicationIPNetworkEventHook_Multi( eIPCallbackEvent_t eNetworkEvent,
             xTasksAlreadyCreated = pdTRUE;
 
             /* Sockets, and tasks that use the TCP/IP stack can be created here. */
-            xTaskCreate( prvCliTask,
-                         "cli",
-                         mainCLI_TASK_STACK_SIZE,
-                         NULL,
-                         mainCLI_TASK_PRIORITY,
-                         NULL );
+            xCliServerInitialize( mainCLI_TASK_STACK_SIZE,
+                                  mainCLI_TASK_PRIORITY );
         }
 
         /* Print out the network configuration, which may have come from a DHCP
@@ -613,6 +319,16 @@ uint32_t ulGetTim7Tick( void )
 }
 /*-----------------------------------------------------------*/
 
+#if defined( __arm__ )
+
+uint32_t ulGetCycleCount( void )
+{
+    return DWT->CYCCNT;
+}
+/*-----------------------------------------------------------*/
+
+#endif
+
 void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
 {
     /* If configCHECK_FOR_STACK_OVERFLOW is set to either 1 or 2 then this
@@ -0,0 +1,154 @@
+import sys
+import math
+import time
+import random
+import argparse
+import threading
+
+from cli_client import CliClient, CliTcpClient, CLI_SERVER_PORT, MAX_PAYLOAD
+
+# Commands run by default, with their relative weights. The bulk gets return
+# the packet capture and the trace collected since the previous get.
+DEFAULT_MIX = 'ping:10,netstat:5,top:2,pcap get:1,trace get:1'
+
+def parse_mix( mix ):
+    """ Returns the ( command, weight ) pairs of a "command:weight,..." list. """
+    pairs = []
+
+    for entry in mix.split( ',' ):
+        command, _, weight = entry.rpartition( ':' )
+
+        if not command:
+            command, weight = weight, '1'
+
+        pairs.append( ( command.strip(), int( weight ) ) )
+
+    return pairs
+
+def percentile( sorted_values, fraction ):
+    """ Nearest-rank percentile of an already sorted list. """
+    if not sorted_values:
+        return 0.0
+
+    # Rounded first so that 0.99 * 100 is 99, not 99.00000000000001.
+    rank = math.ceil( round( fraction * len( sorted_values ), 9 ) ) - 1
+
+    return sorted_values[ min( max( rank, 0 ), len( sorted_values ) - 1 ) ]
+
+class Results:
+    """ Latencies and byte counts of the requests, per command. """
+    def __init__( self ):
+        self.lock = threading.Lock()
+        self.latencies = {}
+        self.bytes = {}
+        self.errors = {}
+
+    def record( self, command, latency, length ):
+        with self.lock:
+            self.latencies.setdefault( command, [] ).append( latency )
+            self.bytes[ command ] = self.bytes.get( command, 0 ) + length
+
+    def record_error( self, command ):
+        with self.lock:
+            self.errors[ command ] = self.errors.get( command, 0 ) + 1
+
+    def report( self, elapsed ):
+        print( '%-16s %8s %6s %10s %10s %10s %10s %10s' % ( 'command', 'requests', 'errors', 'p50 ms', 'p99 ms',
+                                                             'p999 ms', 'req/s', 'MB/s' ) )
+        commands = sorted( set( self.latencies ) | set( self.errors ) )
+        everything = []
+
+        for command in commands:
+            latencies = sorted( self.latencies.get( command, [] ) )
+            everything.extend( latencies )
+            self.print_line( command, latencies, self.errors.get( command, 0 ), self.bytes.get( command, 0 ), elapsed )
+
+        self.print_line( 'total', sorted( everything ), sum( self.errors.values() ), sum( self.bytes.values() ), elapsed )
+
+    @staticmethod
+    def print_line( name, latencies, errors, length, elapsed ):
+        print( '%-16s %8d %6d %10.2f %10.2f %10.2f %10.1f %10.3f' % ( name, len( latencies ), errors,
+                                                                       percentile( latencies, 0.50 ) * 1000,
+                                                                       percentile( latencies, 0.99 ) * 1000,
+                                                                       percentile( latencies, 0.999 ) * 1000,
+                                                                       len( latencies ) / elapsed,
+                                                                       length / elapsed / 1e6 ) )
+
+def worker( args, mix, results, deadline, remaining ):
+    if args.tcp:
+        client = CliTcpClient( args.address, args.port, args.timeout )
+    else:
+        client = CliClient( args.address, args.port, args.window, args.timeout, args.max_payload, args.compress,
+                            args.checksum )
+
+    commands = [ command for command, _ in mix ]
+    weights = [ weight for _, weight in mix ]
+
+    while time.time() < deadline:
+        # A fixed number of requests is shared by the workers.
+        if remaining is not None:
+            with remaining[ 'lock' ]:
+                if remaining[ 'count' ] == 0:
+                    break
+
+                remaining[ 'count' ] -= 1
+
+        command = random.choices( commands, weights )[ 0 ]
+        start = time.perf_counter()
+
+        try:
+            response = client.run( command )
+        except Exception as e:
+            print( '%s: %s' % ( command, e ), file = sys.stderr )
+            results.record_error( command )
+            continue
+
+        results.record( command, time.perf_counter() - start, len( response ) )
+
+def main():
+    parser = argparse.ArgumentParser( description = 'Measure the request rate, the latency and the throughput of the CLI server. '
+                                                    'Runs against a device or a local stand-in, such as the demo built '
+                                                    'for the FreeRTOS POSIX port.' )
+    parser.add_argument( 'address', nargs = '?', default = '127.0.0.1', help = 'IP address of the device.' )
+    parser.add_argument( '--port', type = int, default = CLI_SERVER_PORT )
+    parser.add_argument( '--mix', default = DEFAULT_MIX, help = 'Commands to run with their weights, default "%s".' % DEFAULT_MIX )
+    parser.add_argument( '--concurrency', type = int, default = 1, help = 'Number of clients sending requests at the same time.' )
+    parser.add_argument( '--duration', type = float, default = 10.0, help = 'Length of the run in seconds.' )
+    parser.add_argument( '--requests', type = int, help = 'Stop after this many requests instead of after the duration.' )
+    parser.add_argument( '--warmup', type = float, default = 1.0, help = 'Time to run before measuring, in seconds.' )
+    parser.add_argument( '--window', type = int, default = 8, help = 'Receive window in packets, 0 to disable ACKs.' )
+    parser.add_argument( '--max-payload', type = int, default = MAX_PAYLOAD,
+                         help = 'Largest DATA payload to accept, 0 for the device default.' )
+    parser.add_argument( '--timeout', type = float, default = 5.0, help = 'Receive timeout in seconds.' )
+    parser.add_argument( '--compress', action = 'store_true', help = 'Ask the device to compress the responses.' )
+    parser.add_argument( '--checksum', action = 'store_true', help = 'Ask the device for the CRC32 of the responses.' )
+    parser.add_argument( '--tcp', action = 'store_true', help = 'Use the TCP stream instead of UDP.' )
+    args = parser.parse_args()
+
+    mix = parse_mix( args.mix )
+
+    if args.warmup > 0:
+        worker( args, mix, Results(), time.time() + args.warmup, None )
+
+    results = Results()
+    remaining = None
+    duration = args.duration
+
+    if args.requests is not None:
+        remaining = { 'lock' : threading.Lock(), 'count' : args.requests }
+        duration = float( 'inf' )
+
+    start = time.time()
+    threads = [ threading.Thread( target = worker, args = ( args, mix, results, start + duration, remaining ) )
+                for _ in range( args.concurrency ) ]
+
+    for thread in threads:
+        thread.start()
+
+    for thread in threads:
+        thread.join()
+
+    results.report( time.time() - start )
+
+if __name__ == '__main__':
+    main()
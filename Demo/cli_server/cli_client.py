@@ -0,0 +1,705 @@
+import sys
+import time
+import zlib
+import socket
+import struct
+import random
+import argparse
+
+import cli_schema
+
+CLI_SERVER_PORT = 1234
+
+# Must match PacketHeaderV2_t in cli_protocol.h.
+HEADER_FORMAT = '!BBBB4sIIHH'
+HEADER_LENGTH = struct.calcsize( HEADER_FORMAT )
+
+START_MARKER_V2 = 0x5A
+VERSION_2 = 2
+
+TYPE_REQUEST = 1
+TYPE_DATA = 2
+TYPE_END = 3
+TYPE_ACK = 4
+TYPE_RESEND = 5
+TYPE_STREAM = 6
+TYPE_INVOKE = 7
+TYPE_TELEMETRY = 8
+TYPE_DISCOVER = 9
+
+FLAG_TRUNCATED = 0x01
+FLAG_UNAVAILABLE = 0x02
+FLAG_ABORTED = 0x04
+FLAG_BUSY = 0x08
+FLAG_FAILED = 0x10
+FLAG_COMPRESSED = 0x20
+FLAG_CHECKSUM = 0x40
+
+# Must match CLI_CHECKSUM_LENGTH in cli_protocol.h.
+CHECKSUM = struct.Struct( '!I' )
+
+# Must match CLI_OPCODE_* and CLI_TLV_* in cli_protocol.h.
+OPCODES = {
+    'command' : 0x0001,
+    'batch' : 0x0002,
+    'pcap-get' : 0x0100,
+    'trace-get' : 0x0101,
+    'coredump-get' : 0x0102,
+    'bundle' : 0x0103,
+    'netstat-delta' : 0x0104,
+}
+
+TLV_TEXT = 1
+TLV_UINT32 = 2
+TLV_BYTES = 3
+
+# Must match BatchResultHeader_t in cli_protocol.h.
+BATCH_RESULT_HEADER = struct.Struct( '!BBI' )
+
+# Must match CLI_DISCOVERY_GROUP, CLI_CAPABILITY_* and DiscoveryInfo_t in
+# cli_protocol.h.
+DISCOVERY_GROUP = '239.255.67.76'
+DISCOVERY_INFO = struct.Struct( '!B6sxIHHII16s' )
+
+CAPABILITIES = {
+    0x00000001 : 'tcp',
+    0x00000002 : 'compression',
+    0x00000004 : 'batch',
+    0x00000008 : 'telemetry',
+    0x00000010 : 'multicast',
+    0x00000020 : 'checksum',
+    0x00000100 : 'pcap',
+    0x00000200 : 'trace',
+    0x00000400 : 'coredump',
+    0x00000800 : 'bundle',
+    0x00001000 : 'netstat-delta',
+}
+
+# Must match CLI_STREAM_* and the Telemetry*_t structures in cli_protocol.h.
+STREAM_NETSTAT = 0x01
+STREAM_TASKS = 0x02
+STREAM_HEAP = 0x04
+
+TELEMETRY_RECORD_HEADER = struct.Struct( '!BBH' )
+TELEMETRY_NETSTAT = struct.Struct( '!18I4I' )
+TELEMETRY_TASK = struct.Struct( '!BBBxII16s' )
+TELEMETRY_HEAP = struct.Struct( '!II' )
+
+PROTOCOL_FIELDS = ( 'rx_packets', 'tx_packets', 'rx_bytes', 'tx_bytes', 'rx_dropped', 'tx_dropped' )
+
+# Largest DATA payload which fits in one Ethernet frame after the IP, UDP and
+# version 2 headers.
+MAX_PAYLOAD = 1500 - 20 - 8 - HEADER_LENGTH
+
+MAX_RESEND_ROUNDS = 5
+MAX_REQUEST_RETRIES = 3
+BUSY_RETRY_DELAY = 0.1
+
+def decompress_block( block, raw_length ):
+    """ Decodes a DATA payload compressed by xCliCompressBlock - a sequence of
+    LZ4 style tokens, literals and matches. """
+    out = bytearray()
+    position = 0
+
+    def read_length( length ):
+        nonlocal position
+
+        if length == 15:
+            while True:
+                byte = block[ position ]
+                position += 1
+                length += byte
+
+                if byte != 255:
+                    break
+
+        return length
+
+    while position < len( block ):
+        token = block[ position ]
+        position += 1
+
+        literal_length = read_length( token >> 4 )
+        out += block[ position:position + literal_length ]
+        position += literal_length
+
+        # The last sequence may end after the literals.
+        if position >= len( block ):
+            break
+
+        offset = block[ position ] | ( block[ position + 1 ] << 8 )
+        position += 2
+        match_length = read_length( token & 0x0F ) + 4
+
+        if offset == 0 or offset > len( out ):
+            raise RuntimeError( 'Corrupt compressed payload.' )
+
+        # A match may overlap the bytes it produces.
+        for _ in range( match_length ):
+            out.append( out[ -offset ] )
+
+    if len( out ) != raw_length:
+        raise RuntimeError( 'Compressed payload decodes to %d bytes instead of %d.' % ( len( out ), raw_length ) )
+
+    return bytes( out )
+
+def build_request( command, opcode, arguments = None ):
+    """ Returns the packet type and the payload of a request. With an opcode,
+    the command, if any, is sent as a TEXT argument unless arguments gives the
+    ( tag, value ) of the arguments. A batch carries one TEXT argument per
+    command, the commands being separated by ';'. """
+    if opcode is None:
+        return TYPE_REQUEST, command.encode()
+
+    payload = struct.pack( '!H', opcode )
+
+    if arguments is not None:
+        for tag, value in arguments:
+            payload += struct.pack( '!BH', tag, len( value ) ) + value
+
+        return TYPE_INVOKE, payload
+
+    if opcode == OPCODES[ 'batch' ]:
+        arguments = [ c.strip() for c in command.split( ';' ) if c.strip() ]
+    else:
+        arguments = [ command ] if command else []
+
+    for argument in arguments:
+        text = argument.encode()
+        payload += struct.pack( '!BH', TLV_TEXT, len( text ) ) + text
+
+    return TYPE_INVOKE, payload
+
+def split_batch_response( response ):
+    """ Returns the ( index, flags, output ) results of a batch response. """
+    results = []
+    offset = 0
+
+    while offset + BATCH_RESULT_HEADER.size <= len( response ):
+        index, flags, length = BATCH_RESULT_HEADER.unpack_from( response, offset )
+        offset += BATCH_RESULT_HEADER.size
+        results.append( ( index, flags, response[ offset : offset + length ] ) )
+        offset += length
+
+    return results
+
+def parse_telemetry( payload ):
+    """ Returns the snapshot carried by a TELEMETRY packet as a dictionary. """
+    snapshot = {}
+    offset = 0
+
+    while offset + TELEMETRY_RECORD_HEADER.size <= len( payload ):
+        stream, count, length = TELEMETRY_RECORD_HEADER.unpack_from( payload, offset )
+        offset += TELEMETRY_RECORD_HEADER.size
+        body = payload[ offset : offset + length ]
+        offset += length
+
+        if stream == STREAM_NETSTAT and len( body ) >= TELEMETRY_NETSTAT.size:
+            values = TELEMETRY_NETSTAT.unpack_from( body )
+            snapshot[ 'netstat' ] = {
+                protocol : dict( zip( PROTOCOL_FIELDS, values[ index * 6 : index * 6 + 6 ] ) )
+                for index, protocol in enumerate( ( 'tcp', 'udp', 'icmp' ) )
+            }
+            snapshot[ 'netstat' ][ 'rx_latency' ] = ( values[ 18 ] << 32 ) | values[ 19 ]
+            snapshot[ 'netstat' ][ 'tx_latency' ] = ( values[ 20 ] << 32 ) | values[ 21 ]
+        elif stream == STREAM_TASKS:
+            snapshot[ 'tasks' ] = []
+
+            for index in range( min( count, len( body ) // TELEMETRY_TASK.size ) ):
+                number, state, priority, run_time, stack, name = TELEMETRY_TASK.unpack_from( body, index * TELEMETRY_TASK.size )
+                snapshot[ 'tasks' ].append( { 'number' : number, 'state' : state, 'priority' : priority,
+                                              'run_time' : run_time, 'stack_high_water_mark' : stack,
+                                              'name' : name.rstrip( b'\0' ).decode( errors = 'replace' ) } )
+        elif stream == STREAM_HEAP and len( body ) >= TELEMETRY_HEAP.size:
+            free, minimum = TELEMETRY_HEAP.unpack_from( body )
+            snapshot[ 'heap' ] = { 'free' : free, 'minimum_ever_free' : minimum }
+
+    return snapshot
+
+def parse_health_bundle( response ):
+    """ Returns the HealthBundle_t of a bundle response as a dictionary, with
+    the layout of cli_protocol.h. """
+    schema = cli_schema.Schema()
+    bundle = schema[ 'HealthBundle_t' ].unpack( response )
+
+    if bundle[ 'ucVersion' ] != schema.constants[ 'HEALTH_BUNDLE_VERSION' ]:
+        print( 'Warning: health bundle version %d, expected %d.' %
+               ( bundle[ 'ucVersion' ], schema.constants[ 'HEALTH_BUNDLE_VERSION' ] ), file = sys.stderr )
+
+    bundle[ 'xTasks' ] = bundle[ 'xTasks' ][ : bundle[ 'ucTaskCount' ] ]
+
+    return bundle
+
+class NetstatDeltaDecoder:
+    """ Keeps the baseline of the netstat counters of a device and applies
+    the responses of CLI_OPCODE_NETSTAT_DELTA to it, with the layout of
+    cli_protocol.h. """
+
+    def __init__( self ):
+        self.schema = cli_schema.Schema()
+        self.header = self.schema[ 'NetstatDeltaHeader_t' ]
+        self.client_id = random.getrandbits( 32 ) or 1
+        self.sequence = 0
+        self.counters = [ 0 ] * self.schema.constants[ 'NETSTAT_DELTA_COUNTERS' ]
+
+    def arguments( self, keyframe = False ):
+        """ Returns the arguments of the next request, a baseline of 0 asks
+        for a keyframe. """
+        baseline = 0 if keyframe else self.sequence
+        return [ ( TLV_UINT32, struct.pack( '!I', self.client_id ) ), ( TLV_UINT32, struct.pack( '!I', baseline ) ) ]
+
+    def update( self, response ):
+        """ Applies a response and returns the counters, in the order of the
+        netstat command. """
+        header = self.header.unpack( response )
+        offset = self.header.size
+
+        if header[ 'ucFlags' ] & self.schema.constants[ 'NETSTAT_DELTA_FLAG_KEYFRAME' ]:
+            self.counters = [ 0 ] * len( self.counters )
+
+        for index in range( len( self.counters ) ):
+            if not header[ 'ucChanged' ][ index // 8 ] & ( 1 << ( index % 8 ) ):
+                continue
+
+            value = 0
+            shift = 0
+
+            while True:
+                byte = response[ offset ]
+                offset += 1
+                value |= ( byte & 0x7F ) << shift
+                shift += 7
+
+                if not byte & 0x80:
+                    break
+
+            delta = ( value >> 1 ) ^ -( value & 1 )
+            self.counters[ index ] = ( self.counters[ index ] + delta ) & 0xFFFFFFFF
+
+        self.sequence = header[ 'ulSequence' ]
+
+        return list( self.counters )
+
+def parse_discovery_info( payload ):
+    """ Returns the DiscoveryInfo_t of a DISCOVER response as a dictionary. """
+    version, mac, ip, port, max_payload, capabilities, uptime, hostname = DISCOVERY_INFO.unpack_from( payload )
+
+    return {
+        'hostname' : hostname.rstrip( b'\0' ).decode( errors = 'replace' ),
+        'mac' : ':'.join( '%02x' % b for b in mac ),
+        'ip' : socket.inet_ntoa( struct.pack( '!I', ip ) ),
+        'port' : port,
+        'max_payload' : max_payload,
+        'capabilities' : [ name for bit, name in sorted( CAPABILITIES.items() ) if capabilities & bit ],
+        'uptime_ms' : uptime,
+    }
+
+def check_flags( flags ):
+    if flags & FLAG_FAILED:
+        print( 'Warning: the device reported a failure.', file = sys.stderr )
+
+    if flags & FLAG_TRUNCATED:
+        print( 'Warning: the response was truncated by the device.', file = sys.stderr )
+
+class CliClient:
+    def __init__( self, address, port, window, timeout, max_payload = MAX_PAYLOAD, compress = False, checksum = False ):
+        self.address = ( address, port )
+        self.window = window
+        self.max_payload = max_payload
+        self.compress = compress
+        self.checksum = checksum
+        self.bad_chunks = 0
+        self.sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM )
+        self.sock.settimeout( timeout )
+
+    def send_packet( self, packet_type, request_id, offset = 0, length = 0, payload = b'', window = 0, flags = 0 ):
+        header = struct.pack( HEADER_FORMAT, START_MARKER_V2, VERSION_2, packet_type, flags,
+                              request_id, offset, length, len( payload ), window )
+        self.sock.sendto( header + payload, self.address )
+
+    def receive_packet( self, request_id ):
+        while True:
+            packet, _ = self.sock.recvfrom( 65536 )
+
+            if len( packet ) < HEADER_LENGTH:
+                continue
+
+            marker, version, packet_type, flags, rid, offset, length, payload_length, window = \
+                struct.unpack( HEADER_FORMAT, packet[ :HEADER_LENGTH ] )
+
+            # Drop packets of earlier requests.
+            if marker != START_MARKER_V2 or version != VERSION_2 or rid != request_id:
+                continue
+
+            payload = packet[ HEADER_LENGTH:HEADER_LENGTH + payload_length ]
+
+            # The CRC32 of a DATA payload comes before it. A corrupted chunk
+            # is dropped and recovered like a lost one.
+            if packet_type == TYPE_DATA and ( flags & FLAG_CHECKSUM ):
+                crc, = CHECKSUM.unpack_from( packet, HEADER_LENGTH )
+                payload = packet[ HEADER_LENGTH + CHECKSUM.size:HEADER_LENGTH + CHECKSUM.size + payload_length ]
+
+                if len( payload ) != payload_length or zlib.crc32( payload ) != crc:
+                    print( 'Dropping corrupted chunk at offset %d.' % offset, file = sys.stderr )
+                    self.bad_chunks += 1
+                    continue
+
+            # The window field of a compressed DATA packet is the raw length.
+            if packet_type == TYPE_DATA and ( flags & FLAG_COMPRESSED ):
+                payload = decompress_block( payload, window )
+
+            return packet_type, flags, offset, length, payload
+
+    def receive_response( self, request_id, chunks ):
+        """ Receive DATA packets till the END packet. Returns the END flags, the
+        total response length and the digest of the response, None if the END
+        packet does not carry one. """
+        next_offset = 0
+
+        while True:
+            packet_type, flags, offset, length, payload = self.receive_packet( request_id )
+
+            if packet_type == TYPE_DATA:
+                chunks[ offset ] = payload
+
+                # ACKs are cumulative.
+                while next_offset in chunks and len( chunks[ next_offset ] ) > 0:
+                    next_offset += len( chunks[ next_offset ] )
+
+                if self.window > 0:
+                    self.send_packet( TYPE_ACK, request_id, offset = next_offset, window = self.window )
+
+            elif packet_type == TYPE_END:
+                digest = None
+
+                if ( flags & FLAG_CHECKSUM ) and len( payload ) == CHECKSUM.size:
+                    digest, = CHECKSUM.unpack( payload )
+
+                return flags, length, digest
+
+    @staticmethod
+    def find_holes( chunks, total_length ):
+        holes = []
+        offset = 0
+
+        for start in sorted( chunks ):
+            if start > offset:
+                holes.append( ( offset, start - offset ) )
+            offset = max( offset, start + len( chunks[ start ] ) )
+
+        if offset < total_length:
+            holes.append( ( offset, total_length - offset ) )
+
+        return holes
+
+    def run( self, command, opcode = None, request_id = None, arguments = None ):
+        if request_id is None:
+            request_id = struct.pack( '!I', random.getrandbits( 32 ) )
+
+        request_type, request_payload = build_request( command, opcode, arguments )
+        request_flags = ( FLAG_COMPRESSED if self.compress else 0 ) | ( FLAG_CHECKSUM if self.checksum else 0 )
+        chunks = {}
+
+        # Retries keep the request ID so that the device answers them from its
+        # response cache instead of running the command again.
+        for attempt in range( MAX_REQUEST_RETRIES + 1 ):
+            self.send_packet( request_type, request_id, length = self.max_payload,
+                              payload = request_payload, window = self.window,
+                              flags = request_flags )
+
+            try:
+                flags, total_length, digest = self.receive_response( request_id, chunks )
+            except socket.timeout:
+                print( 'No response, retrying.', file = sys.stderr )
+                continue
+
+            if not ( flags & FLAG_BUSY ):
+                break
+
+            print( 'Device busy, retrying.', file = sys.stderr )
+            time.sleep( BUSY_RETRY_DELAY * ( attempt + 1 ) )
+        else:
+            raise RuntimeError( 'Device busy or not responding.' )
+
+        flags = self.recover_holes( request_id, chunks, flags, total_length )
+        response = b''.join( chunks[ offset ] for offset in sorted( chunks ) )[ :total_length ]
+
+        # The chunks all matched their CRC32 but the whole may still be wrong,
+        # for instance if a chunk was decompressed wrongly. Get it again as a
+        # whole from the retained response.
+        if digest is not None and zlib.crc32( response ) != digest:
+            print( 'Response digest mismatch, requesting the whole response again.', file = sys.stderr )
+            chunks.clear()
+            self.send_packet( TYPE_RESEND, request_id )
+            flags |= self.receive_response( request_id, chunks )[ 0 ]
+            flags = self.recover_holes( request_id, chunks, flags, total_length )
+            response = b''.join( chunks[ offset ] for offset in sorted( chunks ) )[ :total_length ]
+
+            if zlib.crc32( response ) != digest:
+                raise RuntimeError( 'Response digest mismatch.' )
+
+        check_flags( flags )
+
+        return response
+
+    def recover_holes( self, request_id, chunks, flags, total_length ):
+        """ Ask for the missing ranges without running the command again.
+        Returns the flags of the END packets. """
+        for _ in range( MAX_RESEND_ROUNDS ):
+            holes = self.find_holes( chunks, total_length )
+
+            if not holes or ( flags & FLAG_UNAVAILABLE ):
+                break
+
+            for offset, length in holes:
+                print( 'Requesting resend of %d bytes at offset %d.' % ( length, offset ), file = sys.stderr )
+                self.send_packet( TYPE_RESEND, request_id, offset = offset, length = length )
+                flags |= self.receive_response( request_id, chunks )[ 0 ]
+
+        if self.find_holes( chunks, total_length ):
+            raise RuntimeError( 'Incomplete response.' )
+
+        return flags
+
+    def watch( self, streams, interval_ms, lease_ms ):
+        """ Subscribe to telemetry streams and print the snapshots till
+        interrupted. The subscription is renewed halfway through the lease. """
+        command = 'subscribe %s %d %d' % ( streams, interval_ms, lease_ms )
+
+        try:
+            while True:
+                # Every renewal takes a new request ID as the device would
+                # otherwise answer it from its response cache.
+                request_id = struct.pack( '!I', random.getrandbits( 32 ) )
+                sys.stderr.write( self.run( command, request_id = request_id ).decode( errors = 'replace' ) )
+                renew_at = time.time() + lease_ms / 2000.0
+
+                while time.time() < renew_at:
+                    try:
+                        packet_type, flags, sequence, lease_left, payload = self.receive_packet( request_id )
+                    except socket.timeout:
+                        continue
+
+                    if packet_type == TYPE_TELEMETRY:
+                        print( '#%d %r' % ( sequence, parse_telemetry( payload ) ) )
+        except KeyboardInterrupt:
+            self.run( 'unsubscribe' )
+
+def poll_netstat( client, interval_ms, keyframe_every ):
+    """ Polls the netstat counters with CLI_OPCODE_NETSTAT_DELTA and prints
+    them till interrupted, with the size of every response. """
+    decoder = NetstatDeltaDecoder()
+    polls = 0
+
+    try:
+        while True:
+            keyframe = keyframe_every > 0 and polls % keyframe_every == 0
+            response = client.run( '', OPCODES[ 'netstat-delta' ], arguments = decoder.arguments( keyframe ) )
+            counters = decoder.update( response )
+            print( '%s (%d bytes)' % ( ','.join( str( c ) for c in counters ), len( response ) ) )
+            polls += 1
+            time.sleep( interval_ms / 1000.0 )
+    except KeyboardInterrupt:
+        pass
+
+class CliCollector:
+    """ Sends one request to a group of devices, through the discovery
+    multicast group or a subnet broadcast, and gathers the responses of all
+    the devices. """
+    def __init__( self, address, port, timeout, spread_ms ):
+        self.address = ( address, port )
+        self.timeout = timeout
+        self.spread_ms = spread_ms
+        self.sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM )
+        self.sock.setsockopt( socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1 )
+        self.sock.setsockopt( socket.SOL_SOCKET, socket.SO_BROADCAST, 1 )
+
+    def send_packet( self, address, packet_type, request_id, offset = 0, length = 0, payload = b'' ):
+        # A zero window as the collector does not acknowledge the responses.
+        header = struct.pack( HEADER_FORMAT, START_MARKER_V2, VERSION_2, packet_type, 0,
+                              request_id, offset, length, len( payload ), 0 )
+        self.sock.sendto( header + payload, address )
+
+    def collect( self, request_id, responses, duration ):
+        deadline = time.time() + duration
+
+        while True:
+            remaining = deadline - time.time()
+
+            if remaining <= 0:
+                break
+
+            self.sock.settimeout( remaining )
+
+            try:
+                packet, source = self.sock.recvfrom( 65536 )
+            except socket.timeout:
+                break
+
+            if len( packet ) < HEADER_LENGTH:
+                continue
+
+            marker, version, packet_type, flags, rid, offset, length, payload_length, window = \
+                struct.unpack( HEADER_FORMAT, packet[ :HEADER_LENGTH ] )
+
+            if marker != START_MARKER_V2 or version != VERSION_2 or rid != request_id:
+                continue
+
+            response = responses.setdefault( source, { 'chunks' : {}, 'length' : None, 'flags' : 0 } )
+
+            if packet_type == TYPE_DATA:
+                response[ 'chunks' ][ offset ] = packet[ HEADER_LENGTH:HEADER_LENGTH + payload_length ]
+            elif packet_type == TYPE_END:
+                response[ 'length' ] = length
+                response[ 'flags' ] |= flags
+
+    def sweep( self, packet_type, payload = b'' ):
+        """ Returns a dictionary of the ( flags, response ) of every device
+        which answered, keyed by the device address. """
+        request_id = struct.pack( '!I', random.getrandbits( 32 ) )
+        responses = {}
+
+        self.send_packet( self.address, packet_type, request_id, offset = self.spread_ms,
+                          length = MAX_PAYLOAD, payload = payload )
+        self.collect( request_id, responses, self.spread_ms / 1000.0 + self.timeout )
+
+        # Recover the lost packets from each device on its own.
+        for source, response in responses.items():
+            if response[ 'length' ] is None:
+                continue
+
+            for offset, length in CliClient.find_holes( response[ 'chunks' ], response[ 'length' ] ):
+                self.send_packet( source, TYPE_RESEND, request_id, offset = offset, length = length )
+
+        self.collect( request_id, responses, self.timeout )
+
+        results = {}
+
+        for source, response in responses.items():
+            if response[ 'length' ] is None or CliClient.find_holes( response[ 'chunks' ], response[ 'length' ] ):
+                print( 'Incomplete response from %s.' % source[ 0 ], file = sys.stderr )
+                continue
+
+            data = b''.join( response[ 'chunks' ][ offset ] for offset in sorted( response[ 'chunks' ] ) )
+            results[ source[ 0 ] ] = ( response[ 'flags' ], data[ :response[ 'length' ] ] )
+
+        return results
+
+class CliTcpClient:
+    def __init__( self, address, port, timeout ):
+        self.sock = socket.create_connection( ( address, port ), timeout )
+
+    def receive_exact( self, length ):
+        data = bytearray()
+
+        while len( data ) < length:
+            chunk = self.sock.recv( length - len( data ) )
+
+            if not chunk:
+                raise RuntimeError( 'Connection closed by the device.' )
+
+            data += chunk
+
+        return bytes( data )
+
+    def run( self, command, opcode = None, arguments = None ):
+        request_id = struct.pack( '!I', random.getrandbits( 32 ) )
+        request_type, payload = build_request( command, opcode, arguments )
+        header = struct.pack( HEADER_FORMAT, START_MARKER_V2, VERSION_2, request_type, 0,
+                              request_id, 0, 0, len( payload ), 0 )
+        self.sock.sendall( header + payload )
+
+        marker, version, packet_type, flags, rid, _, length, _, _ = \
+            struct.unpack( HEADER_FORMAT, self.receive_exact( HEADER_LENGTH ) )
+
+        if marker != START_MARKER_V2 or packet_type != TYPE_STREAM or rid != request_id:
+            raise RuntimeError( 'Unexpected response header.' )
+
+        check_flags( flags )
+
+        # The TCP window takes care of the pacing and retransmissions.
+        return self.receive_exact( length )
+
+def main():
+    parser = argparse.ArgumentParser( description = 'Send a command to the CLI server.' )
+    parser.add_argument( 'address', help = 'IP address of the device, or with --discover and --fleet, of the group '
+                                           '(%s or a subnet broadcast address).' % DISCOVERY_GROUP )
+    parser.add_argument( 'command', nargs = '?', default = '', help = 'Command to run, e.g. "pcap get".' )
+    parser.add_argument( '--opcode', help = 'Send a binary request with this opcode - a name among %s or a number. '
+                                            'The command, if any, is sent as a text argument.' % ', '.join( OPCODES ) )
+    parser.add_argument( '-o', '--output', help = 'Write the response to this file instead of stdout.' )
+    parser.add_argument( '--port', type = int, default = CLI_SERVER_PORT )
+    parser.add_argument( '--window', type = int, default = 8, help = 'Receive window in packets, 0 to disable ACKs.' )
+    parser.add_argument( '--max-payload', type = int, default = MAX_PAYLOAD,
+                         help = 'Largest DATA payload to accept, 0 for the device default.' )
+    parser.add_argument( '--timeout', type = float, default = 5.0, help = 'Receive timeout in seconds.' )
+    parser.add_argument( '--compress', action = 'store_true', help = 'Ask the device to compress the response.' )
+    parser.add_argument( '--checksum', action = 'store_true',
+                         help = 'Ask the device for the CRC32 of every chunk and of the whole response.' )
+    parser.add_argument( '--tcp', action = 'store_true', help = 'Use the TCP stream instead of UDP.' )
+    parser.add_argument( '--subscribe', metavar = 'STREAMS',
+                         help = 'Print the telemetry snapshots of these streams, e.g. "netstat,heap" or "all".' )
+    parser.add_argument( '--interval', type = int, default = 1000, help = 'Interval between snapshots or polls in milliseconds.' )
+    parser.add_argument( '--lease', type = int, default = 30000, help = 'Lease of the subscription in milliseconds.' )
+    parser.add_argument( '--poll-netstat', action = 'store_true',
+                         help = 'Print the netstat counters every interval, fetched as deltas.' )
+    parser.add_argument( '--keyframe-every', type = int, default = 0,
+                         help = 'With --poll-netstat, ask for a keyframe every this many polls, 0 to leave it to the device.' )
+    parser.add_argument( '--discover', action = 'store_true', help = 'List the devices answering on the address.' )
+    parser.add_argument( '--fleet', action = 'store_true', help = 'Run the command on all the devices answering on the address.' )
+    parser.add_argument( '--spread', type = int, default = 500,
+                         help = 'Time over which the devices spread their responses, in milliseconds.' )
+    args = parser.parse_args()
+
+    if args.discover or args.fleet:
+        collector = CliCollector( args.address, args.port, args.timeout, args.spread )
+
+        if args.discover:
+            for address, ( flags, response ) in sorted( collector.sweep( TYPE_DISCOVER ).items() ):
+                print( '%s %r' % ( address, parse_discovery_info( response ) ) )
+        else:
+            request_type, payload = build_request( args.command, None )
+
+            for address, ( flags, response ) in sorted( collector.sweep( request_type, payload ).items() ):
+                check_flags( flags )
+                sys.stdout.write( '[%s]\n%s\n' % ( address, response.decode( errors = 'replace' ) ) )
+        return
+
+    if args.tcp:
+        client = CliTcpClient( args.address, args.port, args.timeout )
+    else:
+        client = CliClient( args.address, args.port, args.window, args.timeout, args.max_payload, args.compress,
+                            args.checksum )
+
+    if args.subscribe:
+        if args.tcp:
+            parser.error( '--subscribe is only available over UDP.' )
+
+        client.watch( args.subscribe, args.interval, args.lease )
+        return
+
+    if args.poll_netstat:
+        poll_netstat( client, args.interval, args.keyframe_every )
+        return
+
+    opcode = None
+
+    if args.opcode:
+        opcode = OPCODES[ args.opcode ] if args.opcode in OPCODES else int( args.opcode, 0 )
+
+    response = client.run( args.command, opcode )
+
+    if args.output:
+        with open( args.output, 'wb' ) as f:
+            f.write( response )
+    elif opcode == OPCODES[ 'bundle' ] or ( opcode is None and args.command.strip() == 'bundle' ):
+        print( parse_health_bundle( response ) )
+    elif opcode == OPCODES[ 'batch' ]:
+        for index, flags, output in split_batch_response( response ):
+            status = ' (failed)' if flags & FLAG_FAILED else ''
+            sys.stdout.write( '[%d]%s\n%s' % ( index, status, output.decode( errors = 'replace' ) ) )
+    else:
+        sys.stdout.write( response.decode( errors = 'replace' ) )
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,155 @@
+/* Standard includes. */
+#include <string.h>
+
+/* Interface includes. */
+#include "cli_compress.h"
+
+/*-----------------------------------------------------------*/
+
+#define compressMIN_MATCH       4U
+
+/* Bytes taken by the extension of a length stored in a 4-bit field. */
+#define compressEXTENSION_LENGTH( xLength ) \
+    ( ( ( xLength ) < 15U ) ? 0U : ( ( ( ( xLength ) - 15U ) / 255U ) + 1U ) )
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRead32( const uint8_t * pucData );
+
+static uint32_t prvHash( uint32_t ulValue );
+
+static uint8_t * prvWriteExtension( uint8_t * pucOutput,
+                                    size_t xLength );
+
+/*-----------------------------------------------------------*/
+
+size_t xCliCompressBlock( CliCompressState_t * pxState,
+                          const uint8_t * pucInput,
+                          size_t xInputLength,
+                          uint8_t * pucOutput,
+                          size_t xOutputLength,
+                          size_t * pxConsumed )
+{
+    size_t xInput = 0, xAnchor = 0, xOutput = 0;
+    size_t xReference, xMatchLength, xLiteralLength, xSequenceLength;
+    uint32_t ulHash;
+    uint8_t * pucCursor;
+
+    if( xInputLength > CLI_COMPRESS_MAX_INPUT )
+    {
+        xInputLength = CLI_COMPRESS_MAX_INPUT;
+    }
+
+    /* Positions are stored plus one so that zero means "no entry". */
+    memset( pxState->usHashTable, 0, sizeof( pxState->usHashTable ) );
+
+    while( ( xInput + compressMIN_MATCH ) <= xInputLength )
+    {
+        ulHash = prvHash( prvRead32( &( pucInput[ xInput ] ) ) );
+        xReference = pxState->usHashTable[ ulHash ];
+        pxState->usHashTable[ ulHash ] = ( uint16_t ) ( xInput + 1U );
+
+        if( ( xReference == 0U ) ||
+            ( prvRead32( &( pucInput[ xReference - 1U ] ) ) != prvRead32( &( pucInput[ xInput ] ) ) ) )
+        {
+            xInput++;
+            continue;
+        }
+
+        xReference--;
+        xMatchLength = compressMIN_MATCH;
+
+        while( ( ( xInput + xMatchLength ) < xInputLength ) &&
+               ( pucInput[ xReference + xMatchLength ] == pucInput[ xInput + xMatchLength ] ) )
+        {
+            xMatchLength++;
+        }
+
+        xLiteralLength = xInput - xAnchor;
+        xSequenceLength = 1U + compressEXTENSION_LENGTH( xLiteralLength ) + xLiteralLength +
+                          2U + compressEXTENSION_LENGTH( xMatchLength - compressMIN_MATCH );
+
+        /* Stop once the output is full. The rest of the input is left for
+         * the next block. */
+        if( ( xOutput + xSequenceLength ) > xOutputLength )
+        {
+            break;
+        }
+
+        pucCursor = &( pucOutput[ xOutput ] );
+        *pucCursor = ( uint8_t ) ( ( ( xLiteralLength < 15U ) ? xLiteralLength : 15U ) << 4 );
+        *pucCursor |= ( uint8_t ) ( ( ( xMatchLength - compressMIN_MATCH ) < 15U ) ? ( xMatchLength - compressMIN_MATCH ) : 15U );
+        pucCursor++;
+        pucCursor = prvWriteExtension( pucCursor, xLiteralLength );
+        memcpy( pucCursor, &( pucInput[ xAnchor ] ), xLiteralLength );
+        pucCursor += xLiteralLength;
+        *pucCursor++ = ( uint8_t ) ( ( xInput - xReference ) & 0xFFU );
+        *pucCursor++ = ( uint8_t ) ( ( xInput - xReference ) >> 8 );
+        pucCursor = prvWriteExtension( pucCursor, xMatchLength - compressMIN_MATCH );
+
+        xOutput += xSequenceLength;
+        xInput += xMatchLength;
+        xAnchor = xInput;
+    }
+
+    /* Close the block with as many of the pending literals as fit. */
+    xLiteralLength = xInputLength - xAnchor;
+
+    while( ( xLiteralLength > 0U ) &&
+           ( ( xOutput + 1U + compressEXTENSION_LENGTH( xLiteralLength ) + xLiteralLength ) > xOutputLength ) )
+    {
+        xLiteralLength--;
+    }
+
+    if( xLiteralLength > 0U )
+    {
+        pucCursor = &( pucOutput[ xOutput ] );
+        *pucCursor++ = ( uint8_t ) ( ( ( xLiteralLength < 15U ) ? xLiteralLength : 15U ) << 4 );
+        pucCursor = prvWriteExtension( pucCursor, xLiteralLength );
+        memcpy( pucCursor, &( pucInput[ xAnchor ] ), xLiteralLength );
+
+        xOutput += 1U + compressEXTENSION_LENGTH( xLiteralLength ) + xLiteralLength;
+    }
+
+    *pxConsumed = xAnchor + xLiteralLength;
+
+    return xOutput;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRead32( const uint8_t * pucData )
+{
+    uint32_t ulValue;
+
+    memcpy( &( ulValue ), pucData, sizeof( ulValue ) );
+
+    return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHash( uint32_t ulValue )
+{
+    /* Multiplicative hash, keeping the well mixed middle bits. */
+    return ( ( ulValue * 2654435761U ) >> 16 ) & ( CLI_COMPRESS_HASH_SIZE - 1U );
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t * prvWriteExtension( uint8_t * pucOutput,
+                                    size_t xLength )
+{
+    if( xLength >= 15U )
+    {
+        xLength -= 15U;
+
+        while( xLength >= 255U )
+        {
+            *pucOutput++ = 255U;
+            xLength -= 255U;
+        }
+
+        *pucOutput++ = ( uint8_t ) xLength;
+    }
+
+    return pucOutput;
+}
+/*-----------------------------------------------------------*/
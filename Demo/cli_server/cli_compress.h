@@ -0,0 +1,57 @@
+#ifndef CLI_COMPRESS_H
+#define CLI_COMPRESS_H
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Block compressor for the CLI server responses.
+ *
+ * The output uses the sequence format of LZ4 blocks: a token with the
+ * literal length in the high nibble and the match length minus 4 in the low
+ * nibble, the literal length extension, the literals, a 16-bit little endian
+ * match offset and the match length extension. Length extensions are a run
+ * of 255 bytes terminated by a byte smaller than 255. The last sequence may
+ * or may not have a match. Every block is independent so that a lost packet
+ * does not prevent decoding the others.
+ */
+
+/*-----------------------------------------------------------*/
+
+/* Number of entries of the match finder hash table. Must be a power of 2. */
+#define CLI_COMPRESS_HASH_SIZE      1024
+
+/* Largest input of one block, as match offsets are 16-bit. */
+#define CLI_COMPRESS_MAX_INPUT      65535U
+
+typedef struct CliCompressState
+{
+    uint16_t usHashTable[ CLI_COMPRESS_HASH_SIZE ];
+} CliCompressState_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compress as much of the input as fits in the output buffer.
+ *
+ * @param pxState Working memory of the compressor.
+ * @param pucInput Data to compress.
+ * @param xInputLength Length of pucInput, at most CLI_COMPRESS_MAX_INPUT.
+ * @param pucOutput Buffer to write the compressed block in.
+ * @param xOutputLength Size of pucOutput.
+ * @param pxConsumed Output parameter to return the number of input bytes
+ * encoded in the block.
+ *
+ * @return The length of the compressed block.
+ */
+size_t xCliCompressBlock( CliCompressState_t * pxState,
+                          const uint8_t * pucInput,
+                          size_t xInputLength,
+                          uint8_t * pucOutput,
+                          size_t xOutputLength,
+                          size_t * pxConsumed );
+
+/*-----------------------------------------------------------*/
+
+#endif /* CLI_COMPRESS_H */
@@ -0,0 +1,217 @@
+/* Standard includes. */
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* STM includes. */
+#include "stm32h7xx_hal.h"
+
+/* Interface includes. */
+#include "cli_crc.h"
+
+/*-----------------------------------------------------------*/
+
+/* Set to 1 to compute the CRC32 with the CRC unit, which is shared by the
+ * callers under a critical section. Defaults to 1 when the device has one,
+ * the host build uses the software implementation. */
+#ifndef crcUSE_HARDWARE
+    #if defined( CRC ) && defined( CRC_CR_REV_OUT )
+        #define crcUSE_HARDWARE         1
+    #else
+        #define crcUSE_HARDWARE         0
+    #endif
+#endif
+
+/* Normal and reflected polynomials of the CRC32. */
+#define crcPOLYNOMIAL               0x04C11DB7UL
+#define crcPOLYNOMIAL_REFLECTED     0xEDB88320UL
+
+/* Bytes fed to the CRC unit in one critical section, so that a long digest
+ * does not hold up the interrupts. */
+#define crcHARDWARE_BLOCK_LENGTH    256U
+
+/*-----------------------------------------------------------*/
+
+#if ( crcUSE_HARDWARE == 1 )
+
+static uint32_t prvCrc32Hardware( uint32_t ulCrc,
+                                  const uint8_t * pucData,
+                                  size_t xLength );
+
+static BaseType_t xCrcClockEnabled = pdFALSE;
+
+#else
+
+static void prvBuildTables( void );
+
+static uint32_t prvRead32( const uint8_t * pucData );
+
+static uint32_t prvCrc32Software( uint32_t ulCrc,
+                                  const uint8_t * pucData,
+                                  size_t xLength );
+
+/* Slice-by-8 tables, built on first use. Table 0 is the byte-wise table and
+ * table N gives the CRC of a byte followed by N zero bytes. */
+static uint32_t ulCrcTables[ 8 ][ 256 ];
+static volatile BaseType_t xCrcTablesReady = pdFALSE;
+
+#endif /* crcUSE_HARDWARE */
+
+/*-----------------------------------------------------------*/
+
+uint32_t ulCliCrc32( uint32_t ulCrc,
+                     const uint8_t * pucData,
+                     size_t xLength )
+{
+    #if ( crcUSE_HARDWARE == 1 )
+    {
+        ulCrc = prvCrc32Hardware( ulCrc, pucData, xLength );
+    }
+    #else
+    {
+        ulCrc = prvCrc32Software( ulCrc, pucData, xLength );
+    }
+    #endif
+
+    return ulCrc;
+}
+/*-----------------------------------------------------------*/
+
+#if ( crcUSE_HARDWARE == 1 )
+
+static uint32_t prvCrc32Hardware( uint32_t ulCrc,
+                                  const uint8_t * pucData,
+                                  size_t xLength )
+{
+    size_t xBlockLength;
+    uint32_t ulWord;
+
+    while( xLength > 0 )
+    {
+        xBlockLength = ( xLength < crcHARDWARE_BLOCK_LENGTH ) ? xLength : crcHARDWARE_BLOCK_LENGTH;
+        xLength -= xBlockLength;
+
+        taskENTER_CRITICAL();
+        {
+            if( xCrcClockEnabled == pdFALSE )
+            {
+                __HAL_RCC_CRC_CLK_ENABLE();
+                xCrcClockEnabled = pdTRUE;
+            }
+
+            /* Resume from the CRC so far. The unit holds it bit reversed and
+             * without the final XOR. The input is reversed by byte, so the
+             * words are written most significant byte first. */
+            CRC->POL = crcPOLYNOMIAL;
+            CRC->INIT = __RBIT( ~ulCrc );
+            CRC->CR = CRC_CR_REV_IN_0 | CRC_CR_REV_OUT | CRC_CR_RESET;
+
+            for( ; xBlockLength >= 4U; xBlockLength -= 4U )
+            {
+                memcpy( &( ulWord ), pucData, sizeof( ulWord ) );
+                CRC->DR = __REV( ulWord );
+                pucData += 4;
+            }
+
+            for( ; xBlockLength > 0U; xBlockLength-- )
+            {
+                *( ( volatile uint8_t * ) &( CRC->DR ) ) = *pucData;
+                pucData++;
+            }
+
+            ulCrc = ~( CRC->DR );
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    return ulCrc;
+}
+/*-----------------------------------------------------------*/
+
+#else /* crcUSE_HARDWARE */
+
+static void prvBuildTables( void )
+{
+    uint32_t ulIndex, ulCrc;
+    UBaseType_t uxBit, uxTable;
+
+    for( ulIndex = 0; ulIndex < 256U; ulIndex++ )
+    {
+        ulCrc = ulIndex;
+
+        for( uxBit = 0; uxBit < 8U; uxBit++ )
+        {
+            ulCrc = ( ( ulCrc & 1U ) != 0U ) ? ( ( ulCrc >> 1 ) ^ crcPOLYNOMIAL_REFLECTED ) : ( ulCrc >> 1 );
+        }
+
+        ulCrcTables[ 0 ][ ulIndex ] = ulCrc;
+    }
+
+    for( ulIndex = 0; ulIndex < 256U; ulIndex++ )
+    {
+        for( uxTable = 1; uxTable < 8U; uxTable++ )
+        {
+            ulCrc = ulCrcTables[ uxTable - 1U ][ ulIndex ];
+            ulCrcTables[ uxTable ][ ulIndex ] = ( ulCrc >> 8 ) ^ ulCrcTables[ 0 ][ ulCrc & 0xFFU ];
+        }
+    }
+
+    /* Concurrent callers may build the tables at the same time, they write
+     * the same values. */
+    xCrcTablesReady = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRead32( const uint8_t * pucData )
+{
+    return ( ( uint32_t ) pucData[ 0 ] ) |
+           ( ( uint32_t ) pucData[ 1 ] << 8 ) |
+           ( ( uint32_t ) pucData[ 2 ] << 16 ) |
+           ( ( uint32_t ) pucData[ 3 ] << 24 );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCrc32Software( uint32_t ulCrc,
+                                  const uint8_t * pucData,
+                                  size_t xLength )
+{
+    uint32_t ulLow, ulHigh;
+
+    if( xCrcTablesReady == pdFALSE )
+    {
+        prvBuildTables();
+    }
+
+    ulCrc = ~ulCrc;
+
+    while( xLength >= 8U )
+    {
+        ulLow = prvRead32( pucData ) ^ ulCrc;
+        ulHigh = prvRead32( &( pucData[ 4 ] ) );
+
+        ulCrc = ulCrcTables[ 7 ][ ulLow & 0xFFU ] ^
+                ulCrcTables[ 6 ][ ( ulLow >> 8 ) & 0xFFU ] ^
+                ulCrcTables[ 5 ][ ( ulLow >> 16 ) & 0xFFU ] ^
+                ulCrcTables[ 4 ][ ulLow >> 24 ] ^
+                ulCrcTables[ 3 ][ ulHigh & 0xFFU ] ^
+                ulCrcTables[ 2 ][ ( ulHigh >> 8 ) & 0xFFU ] ^
+                ulCrcTables[ 1 ][ ( ulHigh >> 16 ) & 0xFFU ] ^
+                ulCrcTables[ 0 ][ ulHigh >> 24 ];
+
+        pucData += 8;
+        xLength -= 8U;
+    }
+
+    for( ; xLength > 0U; xLength-- )
+    {
+        ulCrc = ( ulCrc >> 8 ) ^ ulCrcTables[ 0 ][ ( ulCrc ^ *pucData ) & 0xFFU ];
+        pucData++;
+    }
+
+    return ~ulCrc;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* crcUSE_HARDWARE */
@@ -0,0 +1,34 @@
+#ifndef CLI_CRC_H
+#define CLI_CRC_H
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CRC32 of the CLI server responses.
+ *
+ * The CRC32 is the one of IEEE 802.3 and zlib: polynomial 0x04C11DB7,
+ * reflected, initial value and final XOR 0xFFFFFFFF. It is computed by the
+ * CRC unit of the STM32H7 when available and by a slice-by-8 software
+ * implementation otherwise.
+ */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Update a CRC32 with more data.
+ *
+ * @param ulCrc CRC32 of the data so far, 0 to start.
+ * @param pucData Data to add.
+ * @param xLength Length of pucData.
+ *
+ * @return The CRC32 of the data so far followed by pucData.
+ */
+uint32_t ulCliCrc32( uint32_t ulCrc,
+                     const uint8_t * pucData,
+                     size_t xLength );
+
+/*-----------------------------------------------------------*/
+
+#endif /* CLI_CRC_H */
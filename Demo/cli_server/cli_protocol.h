@@ -0,0 +1,404 @@
+#ifndef CLI_PROTOCOL_H
+#define CLI_PROTOCOL_H
+
+/* Standard includes. */
+#include <stdint.h>
+
+/*
+ * Wire format of the CLI server. All multi-byte fields are in network byte
+ * order.
+ *
+ * Version 1
+ * ---------
+ * The client sends a request with ucPacketNumber set to 1 and the command
+ * string as payload. The response is a sequence of packets with incrementing
+ * packet numbers, terminated by a packet with zero payload length. The packet
+ * number is 8 bits wide and therefore, wraps for responses longer than 255
+ * packets. There is no recovery for lost packets.
+ *
+ * Version 2
+ * ---------
+ * Every packet starts with PacketHeaderV2_t. The fields are interpreted
+ * according to ucType:
+ *
+ * +-----------------------+-----------------------+------------------------+-----------------------------+
+ * | ucType                | ulOffset              | ulLength               | usWindow                    |
+ * +-----------------------+-----------------------+------------------------+-----------------------------+
+ * | REQUEST (client)      | Largest random delay  | Largest DATA payload   | Receive window in packets.  |
+ * |                       | before answering, in  | accepted, 0 for 1024.  |                             |
+ * |                       | ms, 0 for none.       |                        |                             |
+ * | INVOKE (client)       | Same as REQUEST.      | Same as REQUEST.       | Receive window in packets.  |
+ * | DISCOVER (client)     | Same as REQUEST.      | Same as REQUEST.       | Receive window in packets.  |
+ * | DATA (server)         | Offset of the payload | Total response length. | Length of the payload once  |
+ * |                       | in the response.      |                        | decompressed if COMPRESSED. |
+ * | END (server)          | Total response length,| Total response length. | -                           |
+ * |                       | or the payload bytes  |                        |                             |
+ * |                       | sent if COMPRESSED.   |                        |                             |
+ * | ACK (client)          | Next expected offset. | -                      | Receive window in packets.  |
+ * | RESEND (client)       | Start of the range.   | Length of the range,   | -                           |
+ * |                       |                       | 0 for "till the end".  |                             |
+ * | STREAM (server, TCP)  | 0                     | Length of the body.    | -                           |
+ * | TELEMETRY (server)    | Sequence number.      | Time left on the lease | Streams in the snapshot.    |
+ * |                       |                       | in milliseconds.       |                             |
+ * +-----------------------+-----------------------+------------------------+-----------------------------+
+ *
+ * The server fills every DATA packet up to the payload size advertised in the
+ * request, limited to what fits in one frame of the endpoint MTU after the
+ * IP, UDP and version 2 headers.
+ *
+ * A client sets PACKET_FLAG_COMPRESSED in the request to accept compressed
+ * DATA packets. The server then compresses every DATA payload on its own, in
+ * the block format described in cli_compress.h, and sets the flag in the
+ * packets it compressed. Data which does not compress is sent as it is. The
+ * offsets, ACKs and RESEND ranges always refer to the uncompressed response.
+ *
+ * When the request carries a non-zero window, the server keeps at most that
+ * many DATA packets un-acknowledged and goes back to the last acknowledged
+ * offset if no ACK arrives in time. With a zero window, the server sends the
+ * whole response without waiting and the client recovers the missing ranges
+ * with RESEND requests after the END packet, for as long as the response is
+ * retained, whatever it is made of. If all the workers are busy,
+ * the server answers the request with an END packet carrying
+ * PACKET_FLAG_BUSY.
+ *
+ * The server retains the recent responses in a small cache keyed by the
+ * client address, the client port and the request ID, evicting the least
+ * recently used one first. RESEND requests and requests retried with the same
+ * request ID are served from the cache without re-running the command. A
+ * retry received while the response is still being sent is ignored. The
+ * packet capture and the trace are released when their response is evicted
+ * or when they are fetched again. A retry of such a response after that only
+ * gets the END packet with PACKET_FLAG_UNAVAILABLE.
+ *
+ * A REQUEST carries a FreeRTOS+CLI command string. An INVOKE carries a
+ * binary request instead: a 16-bit opcode followed by TLV arguments, each
+ * made of an 8-bit tag, a 16-bit length and the value. Both are answered
+ * the same way. PACKET_FLAG_FAILED is set in the END packet if the opcode is
+ * unknown, the arguments are malformed or the handler failed.
+ *
+ * The command "subscribe <streams> <interval_ms> [lease_ms]" subscribes the
+ * client address and port to telemetry streams, <streams> being a comma
+ * separated list of "netstat", "tasks" and "heap", or "all". The server then
+ * sends a TELEMETRY packet every <interval_ms> till the lease expires or the
+ * client sends "unsubscribe". The packets carry the request ID of the
+ * subscribe request and their payload is a sequence of records, each made
+ * of TelemetryRecordHeader_t followed by ucCount entries of the stream.
+ * Subscribing again changes the streams and the interval and renews the
+ * lease. Subscriptions are not available over TCP.
+ *
+ * A client sets PACKET_FLAG_CHECKSUM in the request to get checksums. Every
+ * DATA packet then carries the flag and the CRC32 of its payload, as sent,
+ * in CLI_CHECKSUM_LENGTH bytes between the header and the payload.
+ * usPayloadLength does not count them. The END packet carries the flag and
+ * the CRC32 of the whole response, uncompressed, as its payload. The CRC32
+ * is the one of IEEE 802.3 and zlib, in network byte order. A client drops a
+ * DATA packet whose CRC32 does not match as if it was lost and gets it again
+ * through the window or a RESEND request. A response whose digest does not
+ * match is requested again as a whole.
+ *
+ * Discovery
+ * ---------
+ * The server also receives the packets sent to the CLI_DISCOVERY_GROUP
+ * multicast group on the same port, if the TCP/IP stack supports multicast,
+ * and the packets broadcast on the subnet. A DISCOVER packet is answered
+ * like a REQUEST, with a DiscoveryInfo_t as response. A REQUEST or an INVOKE
+ * sent to the group is answered by every device. A collector sets ulOffset
+ * in these requests so that the devices spread their responses over a
+ * random delay instead of answering all at once, and sets a zero window as
+ * it cannot acknowledge a group of devices. The responses are sent to the
+ * collector address and told apart by their source address.
+ *
+ * TCP
+ * ---
+ * The same port also accepts TCP connections. A client sends version 2
+ * REQUEST or INVOKE packets on the connection and every response is a single STREAM
+ * header, with ulLength set to the length of the body, followed by the body
+ * itself. usPayloadLength is zero in the STREAM header. The connection stays
+ * open for further requests till the client closes it. A few connections are
+ * served at the same time, further ones wait to be accepted.
+ */
+
+/*-----------------------------------------------------------*/
+
+#include "pack_struct_start.h"
+struct xPacketHeader
+{
+    uint8_t ucStartMarker;
+    uint8_t ucPacketNumber;
+    uint16_t usPayloadLength;
+    uint8_t ucRequestId[4];
+}
+#include "pack_struct_end.h"
+typedef struct xPacketHeader PacketHeader_t;
+
+#define PACKET_HEADER_LENGTH        sizeof( PacketHeader_t )
+#define PACKET_START_MARKER         0x55
+
+/*-----------------------------------------------------------*/
+
+#include "pack_struct_start.h"
+struct xPacketHeaderV2
+{
+    uint8_t ucStartMarker;      /* PACKET_START_MARKER_V2. */
+    uint8_t ucVersion;          /* PACKET_VERSION_2. */
+    uint8_t ucType;             /* One of PACKET_TYPE_*. */
+    uint8_t ucFlags;            /* Bitwise OR of PACKET_FLAG_*. */
+    uint8_t ucRequestId[ 4 ];   /* Chosen by the client, echoed in every packet. */
+    uint32_t ulOffset;
+    uint32_t ulLength;
+    uint16_t usPayloadLength;   /* Length of the payload following the header. */
+    uint16_t usWindow;
+}
+#include "pack_struct_end.h"
+typedef struct xPacketHeaderV2 PacketHeaderV2_t;
+
+#define PACKET_HEADER_V2_LENGTH     sizeof( PacketHeaderV2_t )
+#define PACKET_START_MARKER_V2      0x5A
+#define PACKET_VERSION_2            2
+
+/* Packet types. */
+#define PACKET_TYPE_REQUEST         1
+#define PACKET_TYPE_DATA            2
+#define PACKET_TYPE_END             3
+#define PACKET_TYPE_ACK             4
+#define PACKET_TYPE_RESEND          5
+#define PACKET_TYPE_STREAM          6
+#define PACKET_TYPE_INVOKE          7
+#define PACKET_TYPE_TELEMETRY       8
+#define PACKET_TYPE_DISCOVER        9
+
+/* Flags carried by END and STREAM packets. PACKET_FLAG_COMPRESSED and
+ * PACKET_FLAG_CHECKSUM are also carried by requests and DATA packets. */
+#define PACKET_FLAG_TRUNCATED       0x01    /* The command produced more output than could be retained. */
+#define PACKET_FLAG_UNAVAILABLE     0x02    /* The requested range can no longer be sent. */
+#define PACKET_FLAG_ABORTED         0x04    /* The client stopped acknowledging the response, or the server could not send it. */
+#define PACKET_FLAG_BUSY            0x08    /* The request was not served, retry later. */
+#define PACKET_FLAG_FAILED          0x10    /* The opcode is unknown or its handler failed. */
+#define PACKET_FLAG_COMPRESSED      0x20    /* Compressed DATA is accepted, or the payload is compressed. */
+#define PACKET_FLAG_CHECKSUM        0x40    /* Checksums are requested, or the packet carries one. */
+
+/* Length of the CRC32 carried by the packets with PACKET_FLAG_CHECKSUM. */
+#define CLI_CHECKSUM_LENGTH         4
+
+/*-----------------------------------------------------------*/
+
+/* Opcodes of INVOKE requests. */
+#define CLI_OPCODE_COMMAND          0x0001  /* Runs the FreeRTOS+CLI command given in a CLI_TLV_TEXT argument. */
+#define CLI_OPCODE_BATCH            0x0002  /* Runs the commands given in CLI_TLV_TEXT arguments, in order. */
+#define CLI_OPCODE_PCAP_GET         0x0100  /* Gets the packet capture. */
+#define CLI_OPCODE_TRACE_GET        0x0101  /* Gets the trace. */
+#define CLI_OPCODE_COREDUMP_GET     0x0102  /* Gets the coredump. */
+#define CLI_OPCODE_BUNDLE_GET       0x0103  /* Gets the HealthBundle_t of the device. */
+#define CLI_OPCODE_NETSTAT_DELTA    0x0104  /* Gets the network statistics changed since a baseline. */
+
+/* Tags of the TLV arguments. */
+#define CLI_TLV_TEXT                1       /* A string, not NULL terminated. */
+#define CLI_TLV_UINT32              2       /* A 32-bit unsigned integer in network byte order. */
+#define CLI_TLV_BYTES               3       /* Raw bytes. */
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The response to a CLI_OPCODE_BATCH request is the concatenation of the
+ * results of the commands, each made of BatchResultHeader_t followed by the
+ * output of the command. The results come in the order of the arguments,
+ * and a result carries the index of its argument. If the response runs out
+ * of space, the remaining commands are not run and PACKET_FLAG_TRUNCATED is
+ * set in the END packet.
+ */
+#include "pack_struct_start.h"
+struct xBatchResultHeader
+{
+    uint8_t ucIndex;            /* Index of the command in the request. */
+    uint8_t ucFlags;            /* PACKET_FLAG_TRUNCATED and PACKET_FLAG_FAILED of this command. */
+    uint32_t ulLength;          /* Length of the output which follows. */
+}
+#include "pack_struct_end.h"
+typedef struct xBatchResultHeader BatchResultHeader_t;
+
+#define BATCH_RESULT_HEADER_LENGTH  sizeof( BatchResultHeader_t )
+
+/*-----------------------------------------------------------*/
+
+/* Multicast group of the discovery, 239.255.67.76 ("CL"). */
+#define CLI_DISCOVERY_GROUP         "239.255.67.76"
+
+/* Capabilities of a device, reported in DiscoveryInfo_t. */
+#define CLI_CAPABILITY_TCP          0x00000001UL    /* Requests over TCP. */
+#define CLI_CAPABILITY_COMPRESSION  0x00000002UL    /* Compressed DATA packets. */
+#define CLI_CAPABILITY_BATCH        0x00000004UL    /* CLI_OPCODE_BATCH. */
+#define CLI_CAPABILITY_TELEMETRY    0x00000008UL    /* Telemetry subscriptions. */
+#define CLI_CAPABILITY_MULTICAST    0x00000010UL    /* Member of CLI_DISCOVERY_GROUP. */
+#define CLI_CAPABILITY_CHECKSUM     0x00000020UL    /* CRC32 of the DATA packets and of the response. */
+#define CLI_CAPABILITY_PCAP         0x00000100UL    /* CLI_OPCODE_PCAP_GET. */
+#define CLI_CAPABILITY_TRACE        0x00000200UL    /* CLI_OPCODE_TRACE_GET. */
+#define CLI_CAPABILITY_COREDUMP     0x00000400UL    /* CLI_OPCODE_COREDUMP_GET. */
+#define CLI_CAPABILITY_BUNDLE       0x00000800UL    /* CLI_OPCODE_BUNDLE_GET. */
+#define CLI_CAPABILITY_NETSTAT_DELTA 0x00001000UL   /* CLI_OPCODE_NETSTAT_DELTA. */
+
+#define DISCOVERY_INFO_VERSION      1
+#define DISCOVERY_HOSTNAME_LENGTH   16
+
+#include "pack_struct_start.h"
+struct xDiscoveryInfo
+{
+    uint8_t ucVersion;          /* DISCOVERY_INFO_VERSION. */
+    uint8_t ucMACAddress[ 6 ];
+    uint8_t ucReserved;
+    uint32_t ulIPAddress;
+    uint16_t usPort;            /* Port of the CLI server. */
+    uint16_t usMaxPayloadSize;  /* Largest DATA payload the device sends. */
+    uint32_t ulCapabilities;    /* Bitwise OR of CLI_CAPABILITY_*. */
+    uint32_t ulUptimeMs;
+    char cHostname[ DISCOVERY_HOSTNAME_LENGTH ]; /* NULL padded. */
+}
+#include "pack_struct_end.h"
+typedef struct xDiscoveryInfo DiscoveryInfo_t;
+
+/*-----------------------------------------------------------*/
+
+/* Telemetry streams. */
+#define CLI_STREAM_NETSTAT          0x01    /* One TelemetryNetstat_t. */
+#define CLI_STREAM_TASKS            0x02    /* One TelemetryTask_t per task. */
+#define CLI_STREAM_HEAP             0x04    /* One TelemetryHeap_t. */
+#define CLI_STREAM_ALL              ( CLI_STREAM_NETSTAT | CLI_STREAM_TASKS | CLI_STREAM_HEAP )
+
+#include "pack_struct_start.h"
+struct xTelemetryRecordHeader
+{
+    uint8_t ucStream;           /* One of CLI_STREAM_*. */
+    uint8_t ucCount;            /* Number of entries which follow. */
+    uint16_t usLength;          /* Length of the entries. */
+}
+#include "pack_struct_end.h"
+typedef struct xTelemetryRecordHeader TelemetryRecordHeader_t;
+
+#include "pack_struct_start.h"
+struct xTelemetryProtocol
+{
+    uint32_t ulRxPackets;
+    uint32_t ulTxPackets;
+    uint32_t ulRxBytes;
+    uint32_t ulTxBytes;
+    uint32_t ulRxDropped;
+    uint32_t ulTxDropped;
+}
+#include "pack_struct_end.h"
+typedef struct xTelemetryProtocol TelemetryProtocol_t;
+
+#include "pack_struct_start.h"
+struct xTelemetryNetstat
+{
+    TelemetryProtocol_t xTcp;
+    TelemetryProtocol_t xUdp;
+    TelemetryProtocol_t xIcmp;
+    uint32_t ulRxLatencyHigh;   /* 64-bit latencies in microseconds, split in two. */
+    uint32_t ulRxLatencyLow;
+    uint32_t ulTxLatencyHigh;
+    uint32_t ulTxLatencyLow;
+}
+#include "pack_struct_end.h"
+typedef struct xTelemetryNetstat TelemetryNetstat_t;
+
+#define TELEMETRY_TASK_NAME_LENGTH  16
+
+#include "pack_struct_start.h"
+struct xTelemetryTask
+{
+    uint8_t ucNumber;           /* Task number given by the kernel. */
+    uint8_t ucState;            /* eTaskState of the task. */
+    uint8_t ucPriority;         /* Current priority. */
+    uint8_t ucReserved;
+    uint32_t ulRunTimeCounter;  /* Run time, in ticks of the run time stats clock. */
+    uint32_t ulStackHighWaterMark; /* Minimum free stack ever, in words. */
+    char cName[ TELEMETRY_TASK_NAME_LENGTH ]; /* NULL padded. */
+}
+#include "pack_struct_end.h"
+typedef struct xTelemetryTask TelemetryTask_t;
+
+#include "pack_struct_start.h"
+struct xTelemetryHeap
+{
+    uint32_t ulFreeBytes;
+    uint32_t ulMinimumEverFreeBytes;
+}
+#include "pack_struct_end.h"
+typedef struct xTelemetryHeap TelemetryHeap_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The response to a CLI_OPCODE_BUNDLE_GET request is one HealthBundle_t,
+ * filled in one pass and small enough for one DATA packet of the default
+ * payload size. The layout is fixed for a version: all the task entries are
+ * sent and only the first ucTaskCount are valid. A new version only appends
+ * members, so that older clients can still read the bundle. The host schema
+ * is generated from this header by cli_schema.py.
+ */
+#define HEALTH_BUNDLE_VERSION       1
+#define HEALTH_BUNDLE_MAX_TASKS     24
+
+/* Flags of a health bundle. */
+#define HEALTH_BUNDLE_FLAG_COREDUMP 0x01    /* A coredump exists, ExpInfo_InfoExist(). */
+#define HEALTH_BUNDLE_FLAG_NETSTAT  0x02    /* xNetstat is valid. */
+#define HEALTH_BUNDLE_FLAG_TASKS_TRUNCATED 0x04 /* Not all the tasks are in xTasks. */
+
+#include "pack_struct_start.h"
+struct xHealthBundle
+{
+    uint8_t ucVersion;          /* HEALTH_BUNDLE_VERSION. */
+    uint8_t ucFlags;            /* Bitwise OR of HEALTH_BUNDLE_FLAG_*. */
+    uint8_t ucTaskCount;        /* Valid entries of xTasks. */
+    uint8_t ucReserved;
+    uint32_t ulUptimeMs;
+    TelemetryNetstat_t xNetstat;    /* NetworkStats_t of the netstat capture. */
+    TelemetryHeap_t xHeap;
+    TelemetryTask_t xTasks[ HEALTH_BUNDLE_MAX_TASKS ];
+}
+#include "pack_struct_end.h"
+typedef struct xHealthBundle HealthBundle_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * A CLI_OPCODE_NETSTAT_DELTA request carries two CLI_TLV_UINT32 arguments:
+ * an ID chosen by the client, not 0, and the ulSequence of the last response
+ * the client decoded, its baseline. The device keeps the baseline of a few
+ * clients and answers with the counters which changed since then.
+ *
+ * The response is NetstatDeltaHeader_t followed, for every counter whose bit
+ * is set in ucChanged, by the difference from the baseline as a signed 32-bit
+ * value, zigzag encoded then written as a varint: 7 bits per byte, least
+ * significant first, bit 7 set on all but the last byte. The counters are
+ * those of the netstat command, in the same order:
+ * - UDP, TCP then ICMP rx packets, tx packets, rx dropped, tx dropped,
+ *   rx bytes and tx bytes.
+ * - The rx latency then the tx latency, high then low 32 bits.
+ *
+ * A keyframe has NETSTAT_DELTA_FLAG_KEYFRAME set and its baseline is all
+ * zeros. It is sent when the baseline of the request is 0, unknown or not
+ * the last one sent to the client, and every few responses. A request without
+ * arguments gets a keyframe and leaves no baseline behind.
+ */
+#define NETSTAT_DELTA_VERSION       1
+#define NETSTAT_DELTA_COUNTERS      22
+#define NETSTAT_DELTA_BITMAP_LENGTH 3       /* ( NETSTAT_DELTA_COUNTERS + 7 ) / 8 */
+
+#define NETSTAT_DELTA_FLAG_KEYFRAME 0x01    /* The baseline is all zeros. */
+
+#include "pack_struct_start.h"
+struct xNetstatDeltaHeader
+{
+    uint8_t ucVersion;          /* NETSTAT_DELTA_VERSION. */
+    uint8_t ucFlags;            /* Bitwise OR of NETSTAT_DELTA_FLAG_*. */
+    uint8_t ucCounters;         /* NETSTAT_DELTA_COUNTERS. */
+    uint8_t ucReserved;
+    uint32_t ulSequence;        /* Baseline of the next request. */
+    uint8_t ucChanged[ NETSTAT_DELTA_BITMAP_LENGTH ]; /* Bit N % 8 of byte N / 8 is set if counter N follows. */
+}
+#include "pack_struct_end.h"
+typedef struct xNetstatDeltaHeader NetstatDeltaHeader_t;
+
+/*-----------------------------------------------------------*/
+
+#endif /* CLI_PROTOCOL_H */
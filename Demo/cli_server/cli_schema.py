@@ -0,0 +1,122 @@
+""" Host schema of the packed structures of cli_protocol.h.
+
+The structures are read from the header itself, so that the client decodes
+them with the layout the device is built with. Run on its own, prints the
+struct format of every structure:
+
+    python3 cli_schema.py [cli_protocol.h]
+"""
+
+import os
+import re
+import sys
+import struct
+
+PROTOCOL_HEADER = os.path.join( os.path.dirname( os.path.abspath( __file__ ) ), 'cli_protocol.h' )
+
+# Format characters of the scalar types, all the values are in network byte
+# order.
+SCALAR_FORMATS = {
+    'uint8_t' : 'B',
+    'int8_t' : 'b',
+    'uint16_t' : 'H',
+    'int16_t' : 'h',
+    'uint32_t' : 'I',
+    'int32_t' : 'i',
+    'uint64_t' : 'Q',
+    'int64_t' : 'q',
+    'char' : 's',
+}
+
+COMMENT = re.compile( r'/\*.*?\*/|//[^\n]*', re.DOTALL )
+DEFINE = re.compile( r'^\s*#define\s+(\w+)\s+\(?\s*(0x[0-9A-Fa-f]+|\d+)[uUlL]*\s*\)?\s*$', re.MULTILINE )
+STRUCT = re.compile( r'struct\s+(\w+)\s*\{(.*?)\}', re.DOTALL )
+TYPEDEF = re.compile( r'typedef\s+struct\s+(\w+)\s+(\w+)\s*;' )
+MEMBER = re.compile( r'(\w+)\s+(\w+)\s*(?:\[\s*(\w+)\s*\])?\s*;' )
+
+class Layout:
+    """ A packed structure: its members are ( name, type, count ) where type
+    is a scalar format character or a nested Layout, and count is None for a
+    member which is not an array. """
+
+    def __init__( self, name, members ):
+        self.name = name
+        self.members = members
+        self.struct = struct.Struct( '!' + self.body() )
+        self.size = self.struct.size
+
+    def body( self ):
+        parts = []
+
+        for name, kind, count in self.members:
+            if isinstance( kind, Layout ):
+                parts.append( kind.body() * ( count or 1 ) )
+            elif kind == 's':
+                parts.append( '%ds' % ( count or 1 ) )
+            else:
+                parts.append( '%d%s' % ( count, kind ) if count else kind )
+
+        return ''.join( parts )
+
+    def unpack( self, data, offset = 0 ):
+        """ Returns the structure at offset of data as a dictionary keyed by
+        the member names. """
+        return self.build( iter( self.struct.unpack_from( data, offset ) ) )
+
+    def build( self, values ):
+        result = {}
+
+        for name, kind, count in self.members:
+            if isinstance( kind, Layout ):
+                items = [ kind.build( values ) for _ in range( count or 1 ) ]
+            elif kind == 's':
+                items = [ next( values ).rstrip( b'\0' ).decode( errors = 'replace' ) ]
+                count = None
+            else:
+                items = [ next( values ) for _ in range( count or 1 ) ]
+
+            result[ name ] = items if count else items[ 0 ]
+
+        return result
+
+class Schema:
+    """ The #define constants and the structures of a header. """
+
+    def __init__( self, path = PROTOCOL_HEADER ):
+        with open( path ) as f:
+            source = COMMENT.sub( '', f.read() )
+
+        self.constants = { name : int( value, 0 ) for name, value in DEFINE.findall( source ) }
+        self.layouts = {}
+
+        typedefs = dict( TYPEDEF.findall( source ) )
+
+        # The structures come in order of dependency in the header.
+        for tag, body in STRUCT.findall( source ):
+            members = []
+
+            for type_name, name, count in MEMBER.findall( body ):
+                if type_name in SCALAR_FORMATS:
+                    kind = SCALAR_FORMATS[ type_name ]
+                else:
+                    kind = self.layouts[ type_name ]
+
+                if count:
+                    count = self.constants[ count ] if count in self.constants else int( count, 0 )
+
+                members.append( ( name, kind, count or None ) )
+
+            name = typedefs.get( tag, tag )
+            self.layouts[ name ] = Layout( name, members )
+
+    def __getitem__( self, name ):
+        return self.layouts[ name ]
+
+def main():
+    schema = Schema( sys.argv[ 1 ] if len( sys.argv ) > 1 else PROTOCOL_HEADER )
+
+    for name, layout in schema.layouts.items():
+        print( "%s = struct.Struct( '%s' )  # %d bytes" % ( name, layout.struct.format, layout.size ) )
+
+if __name__ == '__main__':
+    main()
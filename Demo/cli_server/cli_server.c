@@ -0,0 +1,3623 @@
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "queue.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "NetworkBufferManagement.h"
+
+/* CLI includes. */
+#include "FreeRTOS_CLI.h"
+
+/* Interface includes. */
+#include "cli_protocol.h"
+#include "cli_server.h"
+#include "cli_compress.h"
+#include "cli_crc.h"
+#include "cli_telemetry.h"
+
+/*-----------------------------------------------------------*/
+
+/* Largest payload of a response packet which still fits in one frame of the
+ * endpoint without IP fragmentation. */
+#define cliserverMAX_UDP_PAYLOAD_SIZE       ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER - ipSIZE_OF_UDP_HEADER - PACKET_HEADER_V2_LENGTH )
+
+/* Payload of the response packets for the clients which do not advertise the
+ * largest payload they accept, which includes all version 1 clients. */
+#define cliserverDEFAULT_UDP_PAYLOAD_SIZE   1024
+
+/* Lower bound on an advertised payload size, to keep the number of packets of
+ * a bulk transfer reasonable. */
+#define cliserverMIN_UDP_PAYLOAD_SIZE       256
+
+/* Set to 1 to compress the DATA packets of the clients which ask for it.
+ * Costs CLI_COMPRESS_HASH_SIZE 16-bit words and one payload of RAM, shared
+ * by the workers. */
+#define cliserverUSE_COMPRESSION            1
+
+/* Set to 1 to write the responses directly into the network buffers obtained
+ * from the IP stack and send them with FREERTOS_ZERO_COPY. Set to 0 to stage
+ * every packet in ucUdpResponseBuffer and let FreeRTOS_sendto copy it - useful
+ * to compare the throughput of the two paths. */
+#define cliserverUSE_ZERO_COPY_TX           1
+
+/* Response packets are sent without blocking, so that neither the dispatcher
+ * nor a worker holding the compressor waits for the IP stack on behalf of
+ * another client. A worker holds back a packet the IP stack could not take
+ * and sends it again once network buffers are free, for at most this time
+ * before the response fails. */
+#define cliserverSEND_DEFER_TIMEOUT_MS      ( ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS * portTICK_PERIOD_MS )
+
+/* A UDP packet is only built while at least this many network buffers are
+ * free. The buffers are obtained without blocking and a failed allocation
+ * asserts on the board, so the free count is checked instead. The margin
+ * covers the buffers the IP task may take between the check and the
+ * allocation. */
+#define cliserverSEND_MIN_FREE_BUFFERS      2
+
+/* Default rate limit of the response data sent over UDP, shared by all the
+ * workers. Can be changed with vCliServerSetRateLimit, 0 disables it. */
+#define cliserverPACER_RATE_BYTES_PER_SECOND    ( 4U * 1024U * 1024U )
+
+/* Size of the token bucket - the largest burst sent at line rate. */
+#define cliserverPACER_BURST_BYTES          ( 8U * cliserverMAX_UDP_PAYLOAD_SIZE )
+
+/* A DATA packet is held back while fewer network buffers are free so that the
+ * rest of the stack is never starved by a bulk transfer. The response is
+ * aborted if they stay short for cliserverSEND_DEFER_TIMEOUT_MS. */
+#define cliserverPACER_MIN_FREE_BUFFERS     CLI_MIN_FREE_NETWORK_BUFFERS
+
+/* The largest request accepted - a version 2 header followed by the command. */
+#define cliserverMAX_REQUEST_SIZE           ( PACKET_HEADER_V2_LENGTH + configMAX_COMMAND_INPUT_SIZE )
+
+/* The text output of a command is retained in a buffer of this size so that
+ * it can be sent again. A command writes to it through a CLI writer whose
+ * chunk is all the space left, up to the end of the buffer. The output which
+ * does not fit is dropped and the response is marked truncated. */
+#define cliserverTEXT_BUFFER_SIZE           ( 2 * configCOMMAND_INT_MAX_OUTPUT_SIZE )
+
+/* Maximum number of memory segments a response can be made of. */
+#define cliserverMAX_SEGMENTS               4
+
+/* Upper limit on the number of un-acknowledged packets in flight. */
+#define cliserverMAX_WINDOW                 16
+
+/* Time to wait for an ACK once the send window is full, and the number of
+ * consecutive timeouts after which the client is considered gone. */
+#define cliserverACK_TIMEOUT_MS             200
+#define cliserverMAX_ACK_RETRIES            5
+
+/* Number of worker tasks serving the UDP requests. A request is handed to
+ * an idle worker so that a bulk transfer does not hold up the short commands
+ * from other clients. */
+#define cliserverWORKER_COUNT               3
+
+/* Depth of the queue through which the dispatcher passes the requests, ACKs
+ * and RESEND requests to a worker. */
+#define cliserverWORKER_QUEUE_LENGTH        4
+
+/* Worker reserved for the CLI_CLASS_CRITICAL requests, so that a health check
+ * never waits for a bulk transfer to complete. The critical requests go to the
+ * other workers as well when it is busy. */
+#define cliserverCRITICAL_WORKER            0
+
+/* Priorities of the CLI tasks above the priority given to
+ * xCliServerInitialize. The dispatcher runs above the workers so that a new
+ * request is handed out while the workers are busy sending. */
+#define cliserverBULK_PRIORITY_OFFSET       0
+#define cliserverNORMAL_PRIORITY_OFFSET     1
+#define cliserverCRITICAL_PRIORITY_OFFSET   2
+#define cliserverDISPATCHER_PRIORITY_OFFSET 3
+
+/* Number of responses retained so that retried requests and RESEND requests
+ * are served without running the command again. The least recently used
+ * response is evicted first. Must be larger than the number of workers so
+ * that an idle worker always finds a response to evict. */
+#define cliserverRESPONSE_CACHE_SIZE        ( cliserverWORKER_COUNT + 2 )
+
+/* States of a response in the cache. */
+#define cliserverTRANSFER_FREE              0
+#define cliserverTRANSFER_ACTIVE            1   /* Being built or sent by a worker. */
+#define cliserverTRANSFER_RETAINED          2   /* Sent, kept for retries. */
+
+/* What a worker does with a message from the dispatcher. */
+#define cliserverACTION_FORWARD             0   /* An ACK or RESEND request for the response being sent. */
+#define cliserverACTION_BUILD               1   /* Run the request and send the response. */
+#define cliserverACTION_REPLAY              2   /* Send the retained response again for a retried request. */
+#define cliserverACTION_RESEND              3   /* Serve a RESEND request from the retained response. */
+
+/* Set to 1 to also serve the commands over TCP on configCLI_SERVER_PORT. The
+ * response is streamed as one length-prefixed body and the TCP window takes
+ * care of the pacing and retransmissions. */
+#define cliserverUSE_TCP                    ipconfigUSE_TCP
+
+/* Buffer and window sizes of the TCP connections. Bulk data flows from the
+ * device to the host, so most of the space goes to the TX side. Buffer sizes
+ * are in bytes, window sizes in MSS. */
+#define cliserverTCP_TX_BUFFER_SIZE         ( 12 * ipconfigTCP_MSS )
+#define cliserverTCP_TX_WINDOW_SIZE         6
+#define cliserverTCP_RX_BUFFER_SIZE         ( 2 * ipconfigTCP_MSS )
+#define cliserverTCP_RX_WINDOW_SIZE         2
+
+/* Time to wait for space in the TX buffer before the connection is closed. */
+#define cliserverTCP_SEND_TIMEOUT_MS        5000
+
+/* Maximum number of TCP connections served at the same time. The task
+ * multiplexes them with FreeRTOS_select and never blocks on one, so a client
+ * which does not read its response only holds up its own connection. */
+#define cliserverTCP_MAX_SESSIONS           2
+
+/* Period at which the sessions waiting for TX space or for the peer to close
+ * are checked for a timeout. */
+#define cliserverTCP_POLL_INTERVAL_MS       100
+
+/* Time to wait for the peer to close the connection after a shutdown. */
+#define cliserverTCP_SHUTDOWN_TIMEOUT_MS    2000
+
+/* The server joins CLI_DISCOVERY_GROUP if the TCP/IP stack supports
+ * multicast. Subnet broadcasts are received either way. */
+#if defined( ipconfigSUPPORT_IP_MULTICAST ) && ( ipconfigSUPPORT_IP_MULTICAST != 0 )
+    #define cliserverUSE_MULTICAST          1
+#else
+    #define cliserverUSE_MULTICAST          0
+#endif
+
+/* Longest random delay a client can ask for before a response is sent. */
+#define cliserverMAX_RESPONSE_DELAY_MS      2000
+
+/* Maximum number of opcodes which can be registered. */
+#define cliserverMAX_OPCODES                16
+
+/* Maximum number of commands which can be given a latency class. */
+#define cliserverMAX_COMMAND_CLASSES        16
+
+/* Maximum number of TLV arguments in an INVOKE request. */
+#define cliserverMAX_ARGUMENTS              8
+
+/* Words of "subscribe <streams> <interval_ms> [lease_ms]". */
+#define cliserverSUBSCRIBE_MAX_WORDS        4
+
+/* Version of a request received in the version 1 format. */
+#define cliserverREQUEST_VERSION_1          1
+
+/* States of a TCP session. */
+#define cliserverSESSION_FREE               0
+#define cliserverSESSION_RECEIVING          1   /* Waiting for a complete request. */
+#define cliserverSESSION_SENDING            2   /* Waiting for TX space to send the rest of the response. */
+#define cliserverSESSION_CLOSING            3   /* Shut down, waiting for the peer to close. */
+
+#if ( cliserverUSE_TCP == 1 ) && ( ipconfigSUPPORT_SELECT_FUNCTION != 1 )
+    #error The TCP sessions of the CLI server are multiplexed with FreeRTOS_select, set ipconfigSUPPORT_SELECT_FUNCTION to 1.
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* A contiguous piece of a response. */
+typedef struct CliSegment
+{
+    const uint8_t * pucData;                /* NULL once the data has been released. */
+    uint32_t ulLength;
+    CliReleaseHook_t pxReleaseHook;         /* Called once the response leaves the cache. */
+    const CliOpcodeDefinition_t * pxOpcode; /* The opcode which added the data, if released by a hook. */
+} CliSegment_t;
+
+/* The response to a request. It is retained in the response cache after it
+ * has been sent so that retried requests and RESEND requests can be served
+ * without running the command again. */
+typedef struct CliTransfer
+{
+    /* Cache bookkeeping. The key, the worker and the LRU clock are only
+     * written by the dispatcher. */
+    volatile uint8_t ucState;               /* Set to ACTIVE by the dispatcher, set to RETAINED by the worker. */
+    struct CliWorker * pxWorker;            /* Worker serving the response while ACTIVE. */
+    uint32_t ulLastUsed;                    /* Value of the cache clock when last requested. */
+    struct freertos_sockaddr xClientAddress;
+    uint8_t ucRequestId[ 4 ];
+
+    uint8_t ucClass;                        /* CLI_CLASS_* of the request, set by the dispatcher. */
+    BaseType_t xIsUdp;                      /* Built for a UDP client, in the response cache. */
+    uint8_t ucFlags;                        /* PACKET_FLAG_* to report in the END packet. */
+    uint16_t usPayloadSize;                 /* Payload of the DATA packets, negotiated with the client. */
+    BaseType_t xCompress;                   /* The DATA packets are compressed. */
+    BaseType_t xChecksum;                   /* The DATA and END packets carry CRC32s. */
+    BaseType_t xDigestValid;                /* ulDigest is computed. */
+    uint32_t ulDigest;                      /* CRC32 of the whole response. */
+    uint32_t ulSentOffset;                  /* End of the data sent so far, to tell apart retransmissions. */
+    uint32_t ulWireLength;                  /* Payload bytes sent for the response, retransmissions excluded. */
+    uint32_t ulDatagrams;                   /* DATA packets sent for the response, retransmissions included. */
+    uint32_t ulTotalLength;
+    UBaseType_t uxSegmentCount;
+    CliSegment_t xSegments[ cliserverMAX_SEGMENTS ];
+    uint32_t ulTextLength;
+    char cText[ cliserverTEXT_BUFFER_SIZE ];
+    struct CliScratch * pxScratch;          /* Working buffers of the task building the response. */
+    const CliOpcodeDefinition_t * pxOpcode; /* The opcode whose handler is running, NULL otherwise. */
+} CliTransfer_t;
+
+/* The response given to an output handler. */
+struct CliOutput
+{
+    CliTransfer_t * pxTransfer;
+};
+
+/* A request received from a client. */
+typedef struct CliRequest
+{
+    uint8_t ucVersion;
+    uint8_t ucType;
+    uint8_t ucFlags;
+    uint8_t ucRequestId[ 4 ];
+    uint32_t ulOffset;
+    uint32_t ulLength;
+    uint16_t usWindow;
+    uint16_t usOpcode;                      /* INVOKE requests only. */
+    const uint8_t * pucPayload;
+    uint16_t usPayloadLength;
+    const char * pcCommand;                 /* REQUEST only - NULL terminated pucPayload. */
+} CliRequest_t;
+
+/* A packet passed from the dispatcher to a worker. */
+typedef struct CliMessage
+{
+    uint8_t ucAction;                       /* One of cliserverACTION_*. */
+    uint8_t ucClass;                        /* CLI_CLASS_* to serve the packet with. */
+    TickType_t xPostedTick;                 /* Tick count when posted, to measure the queueing delay. */
+    CliTransfer_t * pxTransfer;             /* The response the packet is for. */
+    struct freertos_sockaddr xSourceAddress;
+    CliRequest_t xRequest;                  /* The pointers are not valid after the copy through the queue. */
+    uint8_t ucPayload[ configMAX_COMMAND_INPUT_SIZE + 1 ];
+} CliMessage_t;
+
+/* The working buffers of a task building responses. They are kept out of
+ * the stack of the task, which the commands run on. */
+typedef struct CliScratch
+{
+    CliArgument_t xArguments[ cliserverMAX_ARGUMENTS ];   /* The arguments of an INVOKE request. */
+    char cCommand[ configMAX_COMMAND_INPUT_SIZE + 1 ];  /* A text command taken from the arguments, NUL terminated. */
+    char cWords[ configMAX_COMMAND_INPUT_SIZE + 1 ];    /* The words of a subscribe command. */
+    CLI_Context_t xContext;                 /* State of the FreeRTOS+CLI command being run. */
+    CLI_Writer_t xWriter;
+} CliScratch_t;
+
+/* A worker serving one UDP request at a time. The response is built in a
+ * slot of the response cache assigned by the dispatcher. */
+typedef struct CliWorker
+{
+    QueueHandle_t xQueue;
+    volatile BaseType_t xBusy;              /* Set by the dispatcher, cleared by the worker. */
+    CliScratch_t xScratch;
+} CliWorker_t;
+
+/* A TCP connection. The response is built at once and copied in the TX
+ * buffer of the socket as space frees up. */
+typedef struct CliTcpSession
+{
+    uint8_t ucState;                        /* One of cliserverSESSION_*. */
+    Socket_t xSocket;
+    struct freertos_sockaddr xClientAddress;
+    TickType_t xWaitStartTick;              /* Start of the wait for TX space or for the peer to close. */
+    TickType_t xResponseStartTick;
+    uint32_t ulReceived;                    /* Bytes of the request received so far. */
+    uint32_t ulSentLength;                  /* Bytes of the response sent so far, header included. */
+    PacketHeaderV2_t xStreamHeader;
+    uint8_t ucRequest[ cliserverMAX_REQUEST_SIZE + 1 ];
+    CliTransfer_t xTransfer;
+} CliTcpSession_t;
+
+/* The latency class of a FreeRTOS+CLI command. */
+typedef struct CliCommandClass
+{
+    const char * pcCommand;
+    uint8_t ucClass;
+} CliCommandClass_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvCliDispatcherTask( void * pvParameters );
+
+static void prvCliWorkerTask( void * pvParameters );
+
+static void prvDispatchPacket( const CliRequest_t * pxRequest,
+                               const struct freertos_sockaddr * pxSourceAddress );
+
+static BaseType_t prvStartJob( CliTransfer_t * pxTransfer,
+                               uint8_t ucAction,
+                               const CliRequest_t * pxRequest,
+                               const struct freertos_sockaddr * pxSourceAddress );
+
+static CliTransfer_t * prvFindTransfer( const struct freertos_sockaddr * pxAddress,
+                                        const uint8_t * pucRequestId );
+
+static CliTransfer_t * prvAllocateTransfer( void );
+
+static CliWorker_t * prvSelectWorker( uint8_t ucClass );
+
+static uint8_t prvGetRequestClass( const CliRequest_t * pxRequest,
+                                   CliArgument_t * pxArguments );
+
+static uint8_t prvGetCommandClass( const char * pcCommand,
+                                   size_t uxLength );
+
+static void prvSetClassPriority( uint8_t ucClass );
+
+static void prvUpdateClassStats( uint8_t ucClass,
+                                 TickType_t xQueueDelay );
+
+static BaseType_t prvPostMessage( CliWorker_t * pxWorker,
+                                  uint8_t ucAction,
+                                  CliTransfer_t * pxTransfer,
+                                  const CliRequest_t * pxRequest,
+                                  const struct freertos_sockaddr * pxSourceAddress );
+
+static BaseType_t prvParseRequest( const uint8_t * pucPacket,
+                                   uint32_t ulPacketLength,
+                                   CliRequest_t * pxRequest );
+
+static void prvServeRequest( CliWorker_t * pxWorker,
+                             CliTransfer_t * pxTransfer,
+                             const CliRequest_t * pxRequest,
+                             const struct freertos_sockaddr * pxSourceAddress,
+                             BaseType_t xReplay );
+
+static void prvServeResend( CliTransfer_t * pxTransfer,
+                            const CliRequest_t * pxRequest );
+
+static void prvResetTransfer( CliTransfer_t * pxTransfer );
+
+static uint16_t prvNegotiatePayloadSize( const CliRequest_t * pxRequest );
+
+static void prvDelayResponse( uint32_t ulMaxDelayMs );
+
+static void prvBuildDiscovery( CliTransfer_t * pxTransfer );
+
+static uint32_t prvGetCapabilities( void );
+
+static void prvBuildTransfer( CliTransfer_t * pxTransfer,
+                              const CliRequest_t * pxRequest );
+
+static void prvRunText( CliTransfer_t * pxTransfer,
+                        const char * pcCommand );
+
+static void prvRunBatch( CliTransfer_t * pxTransfer,
+                         const CliArgument_t * pxArguments,
+                         UBaseType_t uxArgumentCount );
+
+static BaseType_t prvRunSubscription( CliTransfer_t * pxTransfer,
+                                      const char * pcCommand );
+
+static uint8_t prvParseStreams( const char * pcStreams,
+                                BaseType_t xLength );
+
+static void prvAddText( CliTransfer_t * pxTransfer,
+                        const char * pcText );
+
+static void prvRunCommand( CliTransfer_t * pxTransfer,
+                           const char * pcCommand );
+
+static void prvFlushCommandOutput( CLI_Writer_t * pxWriter );
+
+static void prvRunOpcode( CliTransfer_t * pxTransfer,
+                          const CliOpcodeDefinition_t * pxOpcode,
+                          const CliArgument_t * pxArguments,
+                          UBaseType_t uxArgumentCount );
+
+static BaseType_t prvParseArguments( const CliRequest_t * pxRequest,
+                                     CliArgument_t * pxArguments,
+                                     UBaseType_t * puxArgumentCount );
+
+static const CliOpcodeDefinition_t * prvFindOpcode( uint16_t usOpcode,
+                                                    const char * pcAlias );
+
+static BaseType_t prvAddSegment( CliTransfer_t * pxTransfer,
+                                 const uint8_t * pucData,
+                                 uint32_t ulLength,
+                                 CliReleaseHook_t pxReleaseHook );
+
+static void prvReleaseSegments( CliTransfer_t * pxTransfer );
+
+static void prvReleaseOpcodeData( const CliTransfer_t * pxTransfer,
+                                  const CliOpcodeDefinition_t * pxOpcode );
+
+static BaseType_t prvCopyTransferData( const CliTransfer_t * pxTransfer,
+                                       uint32_t ulOffset,
+                                       uint8_t * pucDestination,
+                                       uint32_t ulLength );
+
+static BaseType_t prvIsTransferClient( const CliTransfer_t * pxTransfer,
+                                       const struct freertos_sockaddr * pxAddress,
+                                       const uint8_t * pucRequestId );
+
+static BaseType_t prvGetTransferSpan( const CliTransfer_t * pxTransfer,
+                                      uint32_t ulOffset,
+                                      const uint8_t ** ppucData,
+                                      uint32_t * pulLength );
+
+static BaseType_t prvSendPacket( const struct freertos_sockaddr * pxAddress,
+                                 const void * pvHeader,
+                                 size_t uxHeaderLength,
+                                 const CliTransfer_t * pxTransfer,
+                                 uint32_t ulOffset,
+                                 const uint8_t * pucPayload,
+                                 uint32_t ulPayloadLength,
+                                 BaseType_t xChecksum );
+
+static void prvComputeDigest( CliTransfer_t * pxTransfer );
+
+static BaseType_t prvPaceData( uint32_t ulLength );
+
+static void prvRefundPacer( uint32_t ulLength );
+
+static BaseType_t prvDeferSend( TickType_t xDeferStartTick );
+
+static BaseType_t prvSendResponseV1( CliTransfer_t * pxTransfer );
+
+static BaseType_t prvSendResponseV2( CliWorker_t * pxWorker,
+                                     CliTransfer_t * pxTransfer,
+                                     uint16_t usWindow );
+
+static uint32_t prvSendDataV2( CliTransfer_t * pxTransfer,
+                               uint32_t ulOffset,
+                               uint32_t ulEnd );
+
+static uint32_t prvTrySendDataV2( CliTransfer_t * pxTransfer,
+                                  uint32_t ulOffset,
+                                  uint32_t ulEnd );
+
+#if ( cliserverUSE_COMPRESSION == 1 )
+    static BaseType_t prvCompressData( const CliTransfer_t * pxTransfer,
+                                       uint32_t ulOffset,
+                                       uint32_t ulEnd,
+                                       uint32_t * pulRawLength,
+                                       uint32_t * pulCompressedLength );
+#endif
+
+static BaseType_t prvSendEndV2( const uint8_t * pucRequestId,
+                                const struct freertos_sockaddr * pxAddress,
+                                uint32_t ulTotalLength,
+                                uint8_t ucFlags );
+
+static BaseType_t prvSendTransferEndV2( const CliTransfer_t * pxTransfer,
+                                        uint8_t ucFlags );
+
+static void prvFillHeaderV2( PacketHeaderV2_t * pxHeader,
+                             uint8_t ucType,
+                             uint8_t ucFlags,
+                             const uint8_t * pucRequestId,
+                             uint32_t ulOffset,
+                             uint32_t ulLength,
+                             uint16_t usPayloadLength );
+
+static BaseType_t prvWaitForAck( CliWorker_t * pxWorker,
+                                 CliTransfer_t * pxTransfer,
+                                 uint32_t * pulAckedOffset );
+
+static void prvUpdateThroughputStats( uint32_t ulResponseBytes,
+                                      uint32_t ulDatagrams,
+                                      uint16_t usPayloadSize,
+                                      TickType_t xElapsedTicks );
+
+#if ( cliserverUSE_TCP == 1 )
+    static void prvCliServerTcpTask( void * pvParameters );
+
+    static void prvAcceptTcpSession( Socket_t xListeningSocket,
+                                     CliTcpSession_t * pxSession );
+
+    static void prvServeTcpSession( CliTcpSession_t * pxSession );
+
+    static BaseType_t prvReceiveTcpRequest( CliTcpSession_t * pxSession,
+                                            BaseType_t * pxComplete );
+
+    static BaseType_t prvStartTcpResponse( CliTcpSession_t * pxSession );
+
+    static BaseType_t prvSendTcpResponse( CliTcpSession_t * pxSession );
+
+    static void prvShutdownTcpSession( CliTcpSession_t * pxSession );
+
+    static void prvWatchTcpSession( const CliTcpSession_t * pxSession );
+#endif
+
+/*-----------------------------------------------------------*/
+
+static Socket_t xCLIServerSocket = FREERTOS_INVALID_SOCKET;
+
+static char cInputCommandString[ cliserverMAX_REQUEST_SIZE + 1 ];
+
+#if ( cliserverUSE_ZERO_COPY_TX == 0 )
+    static uint8_t ucUdpResponseBuffer[ cliserverMAX_UDP_PAYLOAD_SIZE + PACKET_HEADER_V2_LENGTH ];
+
+    /* The workers share the staging buffer. */
+    static SemaphoreHandle_t xResponseBufferMutex = NULL;
+#endif
+
+static CliWorker_t xWorkers[ cliserverWORKER_COUNT ];
+
+static CliTransfer_t xTransfers[ cliserverRESPONSE_CACHE_SIZE ];
+
+/* Used by the dispatcher only. */
+static CliMessage_t xDispatchMessage;
+static CliArgument_t xDispatchArguments[ cliserverMAX_ARGUMENTS ];
+static UBaseType_t uxNextWorker = 0;
+static uint32_t ulCacheClock = 0;
+
+/* Serialises the calls into the command and opcode handlers, which share
+ * state.  The state of a command across the calls is kept in a context of the
+ * worker running it, so the mutex is only held for one call at a time. */
+static SemaphoreHandle_t xInterpreterMutex = NULL;
+
+/* Receives an output of a command written into a buffer when it does not fit
+ * in what is left of the text buffer of the response, from which it is copied
+ * as far as it fits. Only used with xInterpreterMutex held. */
+static char cCommandOutput[ configCOMMAND_INT_MAX_OUTPUT_SIZE ];
+
+#if ( cliserverUSE_TCP == 1 )
+    static CliTcpSession_t xTcpSessions[ cliserverTCP_MAX_SESSIONS ];
+
+    /* Used by the TCP task only. */
+    static SocketSet_t xTcpSocketSet = NULL;
+    static CliScratch_t xTcpScratch;
+#endif
+
+static CliServerStats_t xStats;
+
+/* Token bucket of the pacer, shared by the workers and only accessed in a
+ * critical section. */
+static uint32_t ulPacerRate = cliserverPACER_RATE_BYTES_PER_SECOND;
+static uint32_t ulPacerTokens = cliserverPACER_BURST_BYTES;
+static TickType_t xPacerLastTick = 0;
+
+#if ( cliserverUSE_COMPRESSION == 1 )
+    /* The workers share the compressor. The mutex is held from compressing
+     * a payload till it has been sent. */
+    static SemaphoreHandle_t xCompressorMutex = NULL;
+    static CliCompressState_t xCompressState;
+    static uint8_t ucCompressBuffer[ cliserverMAX_UDP_PAYLOAD_SIZE ];
+#endif
+
+/* Registered before the server is started and read-only afterwards. */
+static const CliOpcodeDefinition_t * pxOpcodes[ cliserverMAX_OPCODES ];
+static UBaseType_t uxOpcodeCount = 0;
+
+static CliCommandClass_t xCommandClasses[ cliserverMAX_COMMAND_CLASSES ];
+static UBaseType_t uxCommandClassCount = 0;
+
+/* Priority of the CLI_CLASS_BULK requests, the other classes run above. */
+static UBaseType_t uxBasePriority = tskIDLE_PRIORITY;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliServerInitialize( uint16_t usStackSize,
+                                 UBaseType_t uxPriority )
+{
+    BaseType_t xReturn = pdFAIL;
+    UBaseType_t uxWorker;
+    char cTaskName[ configMAX_TASK_NAME_LEN ];
+
+    uxBasePriority = uxPriority;
+    xInterpreterMutex = xSemaphoreCreateMutex();
+
+    #if ( cliserverUSE_ZERO_COPY_TX == 0 )
+    {
+        xResponseBufferMutex = xSemaphoreCreateMutex();
+        configASSERT( xResponseBufferMutex != NULL );
+    }
+    #endif
+
+    #if ( cliserverUSE_COMPRESSION == 1 )
+    {
+        xCompressorMutex = xSemaphoreCreateMutex();
+        configASSERT( xCompressorMutex != NULL );
+    }
+    #endif
+
+    if( xInterpreterMutex != NULL )
+    {
+        xReturn = pdPASS;
+    }
+
+    for( uxWorker = 0; ( uxWorker < cliserverWORKER_COUNT ) && ( xReturn == pdPASS ); uxWorker++ )
+    {
+        xWorkers[ uxWorker ].xQueue = xQueueCreate( cliserverWORKER_QUEUE_LENGTH, sizeof( CliMessage_t ) );
+
+        if( xWorkers[ uxWorker ].xQueue == NULL )
+        {
+            xReturn = pdFAIL;
+        }
+        else
+        {
+            /* The workers serve each request at the priority of its class
+             * and wait for the next one at the priority of the requests they
+             * mostly serve. */
+            snprintf( cTaskName, sizeof( cTaskName ), "cli-w%u", ( unsigned ) uxWorker );
+            xReturn = xTaskCreate( prvCliWorkerTask,
+                                   cTaskName,
+                                   usStackSize,
+                                   &( xWorkers[ uxWorker ] ),
+                                   uxPriority + ( ( uxWorker == cliserverCRITICAL_WORKER ) ? cliserverCRITICAL_PRIORITY_OFFSET : cliserverNORMAL_PRIORITY_OFFSET ),
+                                   NULL );
+        }
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = xTaskCreate( prvCliDispatcherTask,
+                               "cli",
+                               usStackSize,
+                               NULL,
+                               uxPriority + cliserverDISPATCHER_PRIORITY_OFFSET,
+                               NULL );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = xCliTelemetryInitialize( usStackSize, uxPriority + cliserverNORMAL_PRIORITY_OFFSET );
+    }
+
+    #if ( cliserverUSE_TCP == 1 )
+    {
+        if( xReturn == pdPASS )
+        {
+            xReturn = xTaskCreate( prvCliServerTcpTask,
+                                   "cli-tcp",
+                                   usStackSize,
+                                   NULL,
+                                   uxPriority + cliserverNORMAL_PRIORITY_OFFSET,
+                                   NULL );
+        }
+    }
+    #endif
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliServerRegisterOpcode( const CliOpcodeDefinition_t * pxDefinition )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    configASSERT( pxDefinition != NULL );
+    configASSERT( ( pxDefinition->pxHandler != NULL ) || ( pxDefinition->pxOutputHandler != NULL ) );
+
+    if( uxOpcodeCount < cliserverMAX_OPCODES )
+    {
+        pxOpcodes[ uxOpcodeCount ] = pxDefinition;
+        uxOpcodeCount++;
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliServerSetCommandClass( const char * pcCommand,
+                                      uint8_t ucClass )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    configASSERT( pcCommand != NULL );
+    configASSERT( ucClass < CLI_CLASS_COUNT );
+
+    if( uxCommandClassCount < cliserverMAX_COMMAND_CLASSES )
+    {
+        xCommandClasses[ uxCommandClassCount ].pcCommand = pcCommand;
+        xCommandClasses[ uxCommandClassCount ].ucClass = ucClass;
+        uxCommandClassCount++;
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vCliServerGetStats( CliServerStats_t * pxStats )
+{
+    configASSERT( pxStats != NULL );
+
+    memcpy( pxStats, &( xStats ), sizeof( CliServerStats_t ) );
+    pxStats->ulRateLimit = ulPacerRate;
+}
+/*-----------------------------------------------------------*/
+
+void vCliServerSetRateLimit( uint32_t ulBytesPerSecond )
+{
+    taskENTER_CRITICAL();
+    {
+        ulPacerRate = ulBytesPerSecond;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliOutputAddText( CliOutput_t * pxOutput,
+                              const char * pcText )
+{
+    size_t uxLength = strlen( pcText );
+    void * pvBuffer = pvCliOutputReserve( pxOutput, uxLength );
+    BaseType_t xReturn = pdFAIL;
+
+    if( pvBuffer != NULL )
+    {
+        memcpy( pvBuffer, pcText, uxLength );
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void * pvCliOutputReserve( CliOutput_t * pxOutput,
+                           size_t uxLength )
+{
+    CliTransfer_t * pxTransfer = pxOutput->pxTransfer;
+    char * pcBuffer = &( pxTransfer->cText[ pxTransfer->ulTextLength ] );
+    void * pvReturn = NULL;
+
+    if( uxLength > ( sizeof( pxTransfer->cText ) - pxTransfer->ulTextLength ) )
+    {
+        pxTransfer->ucFlags |= PACKET_FLAG_TRUNCATED;
+    }
+    else if( prvAddSegment( pxTransfer,
+                            ( const uint8_t * ) pcBuffer,
+                            ( uint32_t ) uxLength,
+                            NULL ) == pdPASS )
+    {
+        /* The segment is only sent once the handler has returned, so it can
+         * be filled after being added. */
+        pxTransfer->ulTextLength += uxLength;
+        pvReturn = pcBuffer;
+    }
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliOutputAddMemory( CliOutput_t * pxOutput,
+                                const uint8_t * pucData,
+                                uint32_t ulLength,
+                                CliReleaseHook_t pxReleaseHook )
+{
+    return prvAddSegment( pxOutput->pxTransfer, pucData, ulLength, pxReleaseHook );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCliDispatcherTask( void * pvParameters )
+{
+    int32_t lCount;
+    struct freertos_sockaddr xSourceAddress, xServerAddress;
+    socklen_t xSourceAddressLength = sizeof( xSourceAddress );
+    TickType_t xCLIServerRecvTimeout = portMAX_DELAY;
+    CliRequest_t xRequest;
+
+    ( void ) pvParameters;
+
+    xCLIServerSocket = FreeRTOS_socket( FREERTOS_AF_INET,
+                                        FREERTOS_SOCK_DGRAM,
+                                        FREERTOS_IPPROTO_UDP );
+    configASSERT( xCLIServerSocket != FREERTOS_INVALID_SOCKET );
+
+    /* No need to return from FreeRTOS_recvfrom until a message
+     * is received. */
+    FreeRTOS_setsockopt( xCLIServerSocket,
+                         0,
+                         FREERTOS_SO_RCVTIMEO,
+                         &( xCLIServerRecvTimeout ),
+                         sizeof( TickType_t ) );
+
+    xServerAddress.sin_port = FreeRTOS_htons( configCLI_SERVER_PORT );
+    xServerAddress.sin_family = FREERTOS_AF_INET;
+    xServerAddress.sin_address.ulIP_IPv4 = FreeRTOS_GetIPAddress();
+    FreeRTOS_bind( xCLIServerSocket, &( xServerAddress ), sizeof( xServerAddress ) );
+
+    #if ( cliserverUSE_MULTICAST == 1 )
+    {
+        struct freertos_ip_mreq xMembership;
+
+        xMembership.imr_multiaddr.s_addr = FreeRTOS_inet_addr( CLI_DISCOVERY_GROUP );
+        xMembership.imr_interface.s_addr = FreeRTOS_GetIPAddress();
+
+        if( FreeRTOS_setsockopt( xCLIServerSocket,
+                                 0,
+                                 FREERTOS_SO_IP_ADD_MEMBERSHIP,
+                                 &( xMembership ),
+                                 sizeof( xMembership ) ) != 0 )
+        {
+            configPRINTF( ( "[ERROR] Failed to join the discovery group.\n" ) );
+        }
+    }
+    #endif
+
+    configPRINTF( ( "Waiting for requests...\n" ) );
+
+    for( ;; )
+    {
+        lCount = FreeRTOS_recvfrom( xCLIServerSocket,
+                                    ( void * )( &( cInputCommandString[ 0 ] ) ),
+                                    cliserverMAX_REQUEST_SIZE,
+                                    0,
+                                    &( xSourceAddress ),
+                                    &( xSourceAddressLength ) );
+
+        /* Since we set the receive timeout to portMAX_DELAY, the
+         * above call should only return when a command is received. */
+        configASSERT( lCount > 0 );
+        cInputCommandString[ lCount ] = '\0';
+
+        if( prvParseRequest( ( const uint8_t * ) &( cInputCommandString[ 0 ] ), ( uint32_t ) lCount, &( xRequest ) ) == pdTRUE )
+        {
+            prvDispatchPacket( &( xRequest ), &( xSourceAddress ) );
+        }
+        else
+        {
+            configPRINTF( ( "[ERROR] Malformed request. IP:%x Port:%u Content:%s \n", xSourceAddress.sin_address.ulIP_IPv4,
+                                                                                      xSourceAddress.sin_port,
+                                                                                      cInputCommandString ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvCliWorkerTask( void * pvParameters )
+{
+    CliWorker_t * pxWorker = ( CliWorker_t * ) pvParameters;
+    CliMessage_t xMessage;
+    CliTransfer_t * pxTransfer;
+
+    for( ;; )
+    {
+        if( xQueueReceive( pxWorker->xQueue, &( xMessage ), portMAX_DELAY ) == pdPASS )
+        {
+            xMessage.xRequest.pucPayload = &( xMessage.ucPayload[ 0 ] );
+            xMessage.xRequest.pcCommand = ( const char * ) &( xMessage.ucPayload[ 0 ] );
+            pxTransfer = xMessage.pxTransfer;
+
+            if( xMessage.ucAction == cliserverACTION_FORWARD )
+            {
+                /* An ACK or a RESEND request which arrived while the response
+                 * was still being sent. The worker is idle and the response
+                 * may already be evicted, so it is dropped. The client sends
+                 * the RESEND request again, which the dispatcher then hands
+                 * to a worker with prvStartJob(). */
+            }
+            else
+            {
+                prvSetClassPriority( xMessage.ucClass );
+                prvUpdateClassStats( xMessage.ucClass, xTaskGetTickCount() - xMessage.xPostedTick );
+
+                if( xMessage.ucAction == cliserverACTION_RESEND )
+                {
+                    prvServeResend( pxTransfer, &( xMessage.xRequest ) );
+                }
+                else
+                {
+                    prvServeRequest( pxWorker,
+                                     pxTransfer,
+                                     &( xMessage.xRequest ),
+                                     &( xMessage.xSourceAddress ),
+                                     ( xMessage.ucAction == cliserverACTION_REPLAY ) ? pdTRUE : pdFALSE );
+                }
+
+                /* A worker left at the priority of a bulk request would be
+                 * slow to pick up the next one. */
+                prvSetClassPriority( ( pxWorker == &( xWorkers[ cliserverCRITICAL_WORKER ] ) ) ? CLI_CLASS_CRITICAL : CLI_CLASS_NORMAL );
+
+                /* Keep the response for retries. It is marked as retained
+                 * before the worker is marked as idle so that the dispatcher
+                 * never sees an idle worker without a slot to evict. */
+                pxTransfer->ucState = cliserverTRANSFER_RETAINED;
+                pxWorker->xBusy = pdFALSE;
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvDispatchPacket( const CliRequest_t * pxRequest,
+                               const struct freertos_sockaddr * pxSourceAddress )
+{
+    CliTransfer_t * pxTransfer = prvFindTransfer( pxSourceAddress, &( pxRequest->ucRequestId[ 0 ] ) );
+    BaseType_t xIsRequest = pdFALSE;
+
+    if( ( pxRequest->ucType == PACKET_TYPE_REQUEST ) ||
+        ( pxRequest->ucType == PACKET_TYPE_INVOKE ) ||
+        ( pxRequest->ucType == PACKET_TYPE_DISCOVER ) )
+    {
+        xIsRequest = pdTRUE;
+    }
+
+    if( pxTransfer == NULL )
+    {
+        if( xIsRequest == pdTRUE )
+        {
+            ( void ) prvStartJob( NULL, cliserverACTION_BUILD, pxRequest, pxSourceAddress );
+        }
+        else if( pxRequest->ucType == PACKET_TYPE_RESEND )
+        {
+            /* The response is not retained anymore. */
+            ( void ) prvSendEndV2( &( pxRequest->ucRequestId[ 0 ] ),
+                                   pxSourceAddress,
+                                   0,
+                                   PACKET_FLAG_UNAVAILABLE );
+        }
+        else
+        {
+            /* A late ACK for a response which is not retained. */
+        }
+    }
+    else if( pxTransfer->ucState == cliserverTRANSFER_ACTIVE )
+    {
+        if( xIsRequest == pdTRUE )
+        {
+            /* The client retried before the response was complete. The
+             * worker is already sending it. */
+            configPRINTF( ( "Retried request ignored, the response is being sent. IP:%x Port:%u\n", pxSourceAddress->sin_address.ulIP_IPv4,
+                                                                                                      pxSourceAddress->sin_port ) );
+        }
+        else
+        {
+            /* ACKs and RESEND requests go to the worker sending the
+             * response. */
+            ( void ) prvPostMessage( pxTransfer->pxWorker, cliserverACTION_FORWARD, pxTransfer, pxRequest, pxSourceAddress );
+        }
+    }
+    else if( xIsRequest == pdTRUE )
+    {
+        /* A retried request is answered with the retained response. Running
+         * the command again would take a new snapshot of the data or consume
+         * the packet capture or the trace a second time. */
+        if( prvStartJob( pxTransfer, cliserverACTION_REPLAY, pxRequest, pxSourceAddress ) == pdPASS )
+        {
+            xStats.ulCacheHits++;
+        }
+    }
+    else if( pxRequest->ucType == PACKET_TYPE_RESEND )
+    {
+        ( void ) prvStartJob( pxTransfer, cliserverACTION_RESEND, pxRequest, pxSourceAddress );
+    }
+    else
+    {
+        /* A late ACK for a response which is already complete. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStartJob( CliTransfer_t * pxTransfer,
+                               uint8_t ucAction,
+                               const CliRequest_t * pxRequest,
+                               const struct freertos_sockaddr * pxSourceAddress )
+{
+    BaseType_t xReturn = pdFAIL;
+    CliWorker_t * pxWorker;
+    uint8_t ucPreviousState = cliserverTRANSFER_RETAINED;
+    uint8_t ucClass;
+
+    /* A RESEND request continues the response it is for. */
+    if( ucAction == cliserverACTION_RESEND )
+    {
+        ucClass = pxTransfer->ucClass;
+    }
+    else
+    {
+        ucClass = prvGetRequestClass( pxRequest, &( xDispatchArguments[ 0 ] ) );
+    }
+
+    pxWorker = prvSelectWorker( ucClass );
+
+    if( pxWorker == NULL )
+    {
+        configPRINTF( ( "[WARN] All CLI workers are busy. IP:%x Port:%u\n", pxSourceAddress->sin_address.ulIP_IPv4,
+                                                                            pxSourceAddress->sin_port ) );
+        xStats.ulBusyRejections++;
+        xStats.xClasses[ ucClass ].ulBusyRejections++;
+
+        /* Let version 2 clients know that the request can be retried. */
+        if( pxRequest->ucVersion == PACKET_VERSION_2 )
+        {
+            ( void ) prvSendEndV2( &( pxRequest->ucRequestId[ 0 ] ),
+                                   pxSourceAddress,
+                                   0,
+                                   PACKET_FLAG_BUSY );
+        }
+    }
+    else
+    {
+        if( pxTransfer == NULL )
+        {
+            pxTransfer = prvAllocateTransfer();
+            ucPreviousState = cliserverTRANSFER_FREE;
+            memcpy( &( pxTransfer->xClientAddress ), pxSourceAddress, sizeof( struct freertos_sockaddr ) );
+            memcpy( &( pxTransfer->ucRequestId[ 0 ] ), &( pxRequest->ucRequestId[ 0 ] ), 4 );
+        }
+
+        ulCacheClock++;
+        pxTransfer->ulLastUsed = ulCacheClock;
+        pxTransfer->ucClass = ucClass;
+        pxTransfer->pxWorker = pxWorker;
+        pxTransfer->ucState = cliserverTRANSFER_ACTIVE;
+        pxWorker->xBusy = pdTRUE;
+
+        xReturn = prvPostMessage( pxWorker, ucAction, pxTransfer, pxRequest, pxSourceAddress );
+
+        if( xReturn != pdPASS )
+        {
+            pxTransfer->ucState = ucPreviousState;
+            pxWorker->xBusy = pdFALSE;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static CliTransfer_t * prvFindTransfer( const struct freertos_sockaddr * pxAddress,
+                                        const uint8_t * pucRequestId )
+{
+    CliTransfer_t * pxTransfer = NULL;
+    UBaseType_t uxIndex;
+
+    for( uxIndex = 0; uxIndex < cliserverRESPONSE_CACHE_SIZE; uxIndex++ )
+    {
+        if( prvIsTransferClient( &( xTransfers[ uxIndex ] ), pxAddress, pucRequestId ) == pdTRUE )
+        {
+            pxTransfer = &( xTransfers[ uxIndex ] );
+            break;
+        }
+    }
+
+    return pxTransfer;
+}
+/*-----------------------------------------------------------*/
+
+static CliTransfer_t * prvAllocateTransfer( void )
+{
+    CliTransfer_t * pxTransfer = NULL;
+    UBaseType_t uxIndex;
+
+    /* Use a free slot if any, otherwise evict the least recently used
+     * response which is not being sent. */
+    for( uxIndex = 0; uxIndex < cliserverRESPONSE_CACHE_SIZE; uxIndex++ )
+    {
+        if( xTransfers[ uxIndex ].ucState == cliserverTRANSFER_FREE )
+        {
+            pxTransfer = &( xTransfers[ uxIndex ] );
+            break;
+        }
+
+        if( ( xTransfers[ uxIndex ].ucState == cliserverTRANSFER_RETAINED ) &&
+            ( ( pxTransfer == NULL ) || ( xTransfers[ uxIndex ].ulLastUsed < pxTransfer->ulLastUsed ) ) )
+        {
+            pxTransfer = &( xTransfers[ uxIndex ] );
+        }
+    }
+
+    /* There are more slots than workers and every ACTIVE slot has a busy
+     * worker. */
+    configASSERT( pxTransfer != NULL );
+
+    if( pxTransfer->ucState == cliserverTRANSFER_RETAINED )
+    {
+        xStats.ulCacheEvictions++;
+    }
+
+    return pxTransfer;
+}
+/*-----------------------------------------------------------*/
+
+static CliWorker_t * prvSelectWorker( uint8_t ucClass )
+{
+    CliWorker_t * pxWorker = NULL;
+    UBaseType_t uxCount, uxWorker;
+
+    if( ( ucClass == CLI_CLASS_CRITICAL ) &&
+        ( xWorkers[ cliserverCRITICAL_WORKER ].xBusy == pdFALSE ) )
+    {
+        pxWorker = &( xWorkers[ cliserverCRITICAL_WORKER ] );
+    }
+    else
+    {
+        /* The other workers take turns. */
+        for( uxCount = 0; uxCount < cliserverWORKER_COUNT; uxCount++ )
+        {
+            uxWorker = ( uxNextWorker + uxCount ) % cliserverWORKER_COUNT;
+
+            if( ( uxWorker != cliserverCRITICAL_WORKER ) &&
+                ( xWorkers[ uxWorker ].xBusy == pdFALSE ) )
+            {
+                pxWorker = &( xWorkers[ uxWorker ] );
+                uxNextWorker = ( uxWorker + 1 ) % cliserverWORKER_COUNT;
+                break;
+            }
+        }
+    }
+
+    return pxWorker;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvGetRequestClass( const CliRequest_t * pxRequest,
+                                   CliArgument_t * pxArguments )
+{
+    uint8_t ucClass = CLI_CLASS_NORMAL;
+    const CliOpcodeDefinition_t * pxOpcode;
+    UBaseType_t uxArgumentCount;
+
+    if( pxRequest->ucType == PACKET_TYPE_DISCOVER )
+    {
+        ucClass = CLI_CLASS_CRITICAL;
+    }
+    else if( pxRequest->ucType == PACKET_TYPE_INVOKE )
+    {
+        pxOpcode = prvFindOpcode( pxRequest->usOpcode, NULL );
+
+        if( pxOpcode != NULL )
+        {
+            ucClass = pxOpcode->ucClass;
+        }
+        else if( ( pxRequest->usOpcode == CLI_OPCODE_COMMAND ) &&
+                 ( prvParseArguments( pxRequest, pxArguments, &( uxArgumentCount ) ) == pdPASS ) &&
+                 ( uxArgumentCount == 1 ) &&
+                 ( pxArguments[ 0 ].ucTag == CLI_TLV_TEXT ) )
+        {
+            ucClass = prvGetCommandClass( ( const char * ) pxArguments[ 0 ].pucValue, pxArguments[ 0 ].usLength );
+        }
+        else
+        {
+            /* Batches, and malformed requests which fail at once. */
+        }
+    }
+    else if( pxRequest->ucType == PACKET_TYPE_REQUEST )
+    {
+        pxOpcode = prvFindOpcode( 0, pxRequest->pcCommand );
+
+        if( pxOpcode != NULL )
+        {
+            ucClass = pxOpcode->ucClass;
+        }
+        else
+        {
+            ucClass = prvGetCommandClass( pxRequest->pcCommand, strlen( pxRequest->pcCommand ) );
+        }
+    }
+    else
+    {
+        /* ACK and RESEND requests belong to a response. */
+    }
+
+    configASSERT( ucClass < CLI_CLASS_COUNT );
+
+    return ucClass;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvGetCommandClass( const char * pcCommand,
+                                   size_t uxLength )
+{
+    uint8_t ucClass = CLI_CLASS_NORMAL;
+    size_t uxCommandLength = 0;
+    UBaseType_t uxIndex;
+
+    /* The class is set for the command, whatever its parameters. */
+    while( ( uxCommandLength < uxLength ) && ( pcCommand[ uxCommandLength ] != ' ' ) )
+    {
+        uxCommandLength++;
+    }
+
+    for( uxIndex = 0; uxIndex < uxCommandClassCount; uxIndex++ )
+    {
+        if( ( strlen( xCommandClasses[ uxIndex ].pcCommand ) == uxCommandLength ) &&
+            ( strncmp( xCommandClasses[ uxIndex ].pcCommand, pcCommand, uxCommandLength ) == 0 ) )
+        {
+            ucClass = xCommandClasses[ uxIndex ].ucClass;
+            break;
+        }
+    }
+
+    return ucClass;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetClassPriority( uint8_t ucClass )
+{
+    UBaseType_t uxPriority;
+
+    if( ucClass == CLI_CLASS_CRITICAL )
+    {
+        uxPriority = uxBasePriority + cliserverCRITICAL_PRIORITY_OFFSET;
+    }
+    else if( ucClass == CLI_CLASS_BULK )
+    {
+        uxPriority = uxBasePriority + cliserverBULK_PRIORITY_OFFSET;
+    }
+    else
+    {
+        uxPriority = uxBasePriority + cliserverNORMAL_PRIORITY_OFFSET;
+    }
+
+    /* The handlers run under xInterpreterMutex, so a bulk command holding it
+     * inherits the priority of a critical command waiting for it until the
+     * end of its current call. */
+    if( uxTaskPriorityGet( NULL ) != uxPriority )
+    {
+        vTaskPrioritySet( NULL, uxPriority );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvUpdateClassStats( uint8_t ucClass,
+                                 TickType_t xQueueDelay )
+{
+    CliClassStats_t * pxClassStats = &( xStats.xClasses[ ucClass ] );
+    uint32_t ulQueueDelayMs = ( uint32_t ) ( xQueueDelay * portTICK_PERIOD_MS );
+
+    /* The workers update the statistics of the classes concurrently. */
+    taskENTER_CRITICAL();
+    {
+        pxClassStats->ulRequests++;
+        pxClassStats->ulTotalQueueDelayMs += ulQueueDelayMs;
+        pxClassStats->ulLastQueueDelayMs = ulQueueDelayMs;
+
+        if( ulQueueDelayMs > pxClassStats->ulMaxQueueDelayMs )
+        {
+            pxClassStats->ulMaxQueueDelayMs = ulQueueDelayMs;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPostMessage( CliWorker_t * pxWorker,
+                                  uint8_t ucAction,
+                                  CliTransfer_t * pxTransfer,
+                                  const CliRequest_t * pxRequest,
+                                  const struct freertos_sockaddr * pxSourceAddress )
+{
+    BaseType_t xReturn;
+
+    xDispatchMessage.ucAction = ucAction;
+    xDispatchMessage.ucClass = pxTransfer->ucClass;
+    xDispatchMessage.xPostedTick = xTaskGetTickCount();
+    xDispatchMessage.pxTransfer = pxTransfer;
+    memcpy( &( xDispatchMessage.xSourceAddress ), pxSourceAddress, sizeof( struct freertos_sockaddr ) );
+    memcpy( &( xDispatchMessage.xRequest ), pxRequest, sizeof( CliRequest_t ) );
+
+    /* The length of the payload is checked by prvParseRequest. */
+    memcpy( &( xDispatchMessage.ucPayload[ 0 ] ), pxRequest->pucPayload, pxRequest->usPayloadLength );
+    xDispatchMessage.ucPayload[ pxRequest->usPayloadLength ] = '\0';
+
+    /* Never block the dispatcher - a lost ACK or RESEND request is recovered
+     * by the client. */
+    xReturn = xQueueSend( pxWorker->xQueue, &( xDispatchMessage ), 0 );
+
+    if( xReturn != pdPASS )
+    {
+        configPRINTF( ( "[WARN] CLI worker queue full, packet dropped.\n" ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvParseRequest( const uint8_t * pucPacket,
+                                   uint32_t ulPacketLength,
+                                   CliRequest_t * pxRequest )
+{
+    BaseType_t xValidRequest = pdFALSE;
+    const PacketHeader_t * pxHeader;
+    const PacketHeaderV2_t * pxHeaderV2;
+    uint16_t usPayloadLength;
+
+    memset( pxRequest, 0, sizeof( CliRequest_t ) );
+
+    if( ( ulPacketLength > PACKET_HEADER_LENGTH ) &&
+        ( pucPacket[ 0 ] == PACKET_START_MARKER ) )
+    {
+        pxHeader = ( const PacketHeader_t * ) pucPacket;
+        usPayloadLength = FreeRTOS_ntohs( pxHeader->usPayloadLength );
+
+        if( ( pxHeader->ucPacketNumber == 1 ) &&
+            ( usPayloadLength <= configMAX_COMMAND_INPUT_SIZE ) &&
+            ( ( usPayloadLength + PACKET_HEADER_LENGTH ) == ulPacketLength ) )
+        {
+            xValidRequest = pdTRUE;
+            pxRequest->ucVersion = cliserverREQUEST_VERSION_1;
+            pxRequest->ucType = PACKET_TYPE_REQUEST;
+            memcpy( &( pxRequest->ucRequestId[ 0 ] ), &( pxHeader->ucRequestId[ 0 ] ), 4 );
+            pxRequest->pucPayload = &( pucPacket[ PACKET_HEADER_LENGTH ] );
+            pxRequest->usPayloadLength = usPayloadLength;
+            pxRequest->pcCommand = ( const char * ) pxRequest->pucPayload;
+        }
+    }
+    else if( ( ulPacketLength >= PACKET_HEADER_V2_LENGTH ) &&
+             ( pucPacket[ 0 ] == PACKET_START_MARKER_V2 ) )
+    {
+        pxHeaderV2 = ( const PacketHeaderV2_t * ) pucPacket;
+        usPayloadLength = FreeRTOS_ntohs( pxHeaderV2->usPayloadLength );
+
+        if( ( pxHeaderV2->ucVersion == PACKET_VERSION_2 ) &&
+            ( ( usPayloadLength + PACKET_HEADER_V2_LENGTH ) == ulPacketLength ) )
+        {
+            pxRequest->ucVersion = PACKET_VERSION_2;
+            pxRequest->ucType = pxHeaderV2->ucType;
+            pxRequest->ucFlags = pxHeaderV2->ucFlags;
+            memcpy( &( pxRequest->ucRequestId[ 0 ] ), &( pxHeaderV2->ucRequestId[ 0 ] ), 4 );
+            pxRequest->ulOffset = FreeRTOS_ntohl( pxHeaderV2->ulOffset );
+            pxRequest->ulLength = FreeRTOS_ntohl( pxHeaderV2->ulLength );
+            pxRequest->usWindow = FreeRTOS_ntohs( pxHeaderV2->usWindow );
+            pxRequest->pucPayload = &( pucPacket[ PACKET_HEADER_V2_LENGTH ] );
+            pxRequest->usPayloadLength = usPayloadLength;
+
+            /* Only requests carry a command. The packet is NULL terminated by
+             * the caller so the payload of a REQUEST is a valid string. */
+            if( pxRequest->ucType == PACKET_TYPE_REQUEST )
+            {
+                if( ( usPayloadLength > 0 ) && ( usPayloadLength <= configMAX_COMMAND_INPUT_SIZE ) )
+                {
+                    pxRequest->pcCommand = ( const char * ) pxRequest->pucPayload;
+                    xValidRequest = pdTRUE;
+                }
+            }
+            else if( pxRequest->ucType == PACKET_TYPE_INVOKE )
+            {
+                if( ( usPayloadLength >= sizeof( uint16_t ) ) && ( usPayloadLength <= configMAX_COMMAND_INPUT_SIZE ) )
+                {
+                    pxRequest->usOpcode = ( uint16_t ) ( ( ( uint16_t ) pxRequest->pucPayload[ 0 ] << 8 ) | pxRequest->pucPayload[ 1 ] );
+                    xValidRequest = pdTRUE;
+                }
+            }
+            else if( ( pxRequest->ucType == PACKET_TYPE_ACK ) ||
+                     ( pxRequest->ucType == PACKET_TYPE_RESEND ) ||
+                     ( pxRequest->ucType == PACKET_TYPE_DISCOVER ) )
+            {
+                xValidRequest = pdTRUE;
+            }
+            else
+            {
+                /* DATA, END and STREAM packets are only sent by the server. */
+            }
+        }
+    }
+
+    return xValidRequest;
+}
+/*-----------------------------------------------------------*/
+
+static void prvServeRequest( CliWorker_t * pxWorker,
+                             CliTransfer_t * pxTransfer,
+                             const CliRequest_t * pxRequest,
+                             const struct freertos_sockaddr * pxSourceAddress,
+                             BaseType_t xReplay )
+{
+    BaseType_t xResponseSent;
+    TickType_t xResponseStartTick;
+
+    if( pxRequest->ucType == PACKET_TYPE_INVOKE )
+    {
+        configPRINTF( ( "Received opcode. IP:%x Port:%u Opcode:0x%04x \n", pxSourceAddress->sin_address.ulIP_IPv4,
+                                                                           pxSourceAddress->sin_port,
+                                                                           pxRequest->usOpcode ) );
+    }
+    else if( pxRequest->ucType == PACKET_TYPE_DISCOVER )
+    {
+        configPRINTF( ( "Received discovery probe. IP:%x Port:%u \n", pxSourceAddress->sin_address.ulIP_IPv4,
+                                                                      pxSourceAddress->sin_port ) );
+    }
+    else
+    {
+        configPRINTF( ( "Received command. IP:%x Port:%u Content:%s \n", pxSourceAddress->sin_address.ulIP_IPv4,
+                                                                         pxSourceAddress->sin_port,
+                                                                         pxRequest->pcCommand ) );
+    }
+
+    if( xReplay == pdFALSE )
+    {
+        prvResetTransfer( pxTransfer );
+        pxTransfer->xIsUdp = pdTRUE;
+        pxTransfer->pxScratch = &( pxWorker->xScratch );
+        prvBuildTransfer( pxTransfer, pxRequest );
+    }
+    else
+    {
+        configPRINTF( ( "Request retried, sending the retained response.\n" ) );
+    }
+
+    /* A request sent to a group of devices asks them to spread their
+     * responses. */
+    if( pxRequest->ulOffset > 0U )
+    {
+        prvDelayResponse( pxRequest->ulOffset );
+    }
+
+    xResponseStartTick = xTaskGetTickCount();
+
+    /* A retry may come with a different payload size. */
+    pxTransfer->usPayloadSize = prvNegotiatePayloadSize( pxRequest );
+    pxTransfer->ulDatagrams = 0;
+    pxTransfer->ulSentOffset = 0;
+    pxTransfer->ulWireLength = 0;
+    pxTransfer->xCompress = pdFALSE;
+    pxTransfer->xChecksum = pdFALSE;
+
+    if( ( pxRequest->ucVersion == PACKET_VERSION_2 ) &&
+        ( ( pxRequest->ucFlags & PACKET_FLAG_CHECKSUM ) != 0U ) )
+    {
+        pxTransfer->xChecksum = pdTRUE;
+
+        /* The CRC32 of a DATA packet takes room from its payload. */
+        if( pxTransfer->usPayloadSize > ( cliserverMAX_UDP_PAYLOAD_SIZE - CLI_CHECKSUM_LENGTH ) )
+        {
+            pxTransfer->usPayloadSize = cliserverMAX_UDP_PAYLOAD_SIZE - CLI_CHECKSUM_LENGTH;
+        }
+
+        /* The digest of a retained response is only computed once. */
+        if( pxTransfer->xDigestValid == pdFALSE )
+        {
+            prvComputeDigest( pxTransfer );
+        }
+    }
+
+    #if ( cliserverUSE_COMPRESSION == 1 )
+    {
+        if( ( pxRequest->ucVersion == PACKET_VERSION_2 ) &&
+            ( ( pxRequest->ucFlags & PACKET_FLAG_COMPRESSED ) != 0U ) )
+        {
+            pxTransfer->xCompress = pdTRUE;
+        }
+    }
+    #endif
+
+    if( ( xReplay == pdTRUE ) &&
+        ( prvCopyTransferData( pxTransfer, 0, NULL, pxTransfer->ulTotalLength ) != pdPASS ) )
+    {
+        /* Part of the response was released because the same data was
+         * fetched again since. A version 2 client still gets the END packet,
+         * which completes the response if only the END packet was lost. */
+        if( pxRequest->ucVersion == PACKET_VERSION_2 )
+        {
+            ( void ) prvSendTransferEndV2( pxTransfer, pxTransfer->ucFlags | PACKET_FLAG_UNAVAILABLE );
+        }
+
+        xResponseSent = pdFAIL;
+    }
+    else if( pxRequest->ucVersion == PACKET_VERSION_2 )
+    {
+        xResponseSent = prvSendResponseV2( pxWorker, pxTransfer, pxRequest->usWindow );
+    }
+    else
+    {
+        xResponseSent = prvSendResponseV1( pxTransfer );
+    }
+
+    if( xResponseSent == pdPASS )
+    {
+        prvUpdateThroughputStats( pxTransfer->ulTotalLength,
+                                  pxTransfer->ulDatagrams,
+                                  pxTransfer->usPayloadSize,
+                                  xTaskGetTickCount() - xResponseStartTick );
+    }
+    else
+    {
+        configPRINTF( ( "[ERROR] Failed to send response. \n" ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvServeResend( CliTransfer_t * pxTransfer,
+                            const CliRequest_t * pxRequest )
+{
+    uint32_t ulOffset = pxRequest->ulOffset;
+    uint32_t ulEnd = pxTransfer->ulTotalLength;
+    uint32_t ulPayloadLength;
+    uint8_t ucFlags = pxTransfer->ucFlags;
+
+    /* A zero length asks for everything from the offset onwards. */
+    if( ( pxRequest->ulLength != 0 ) &&
+        ( pxRequest->ulLength < ( ulEnd - ulOffset ) ) )
+    {
+        ulEnd = ulOffset + pxRequest->ulLength;
+    }
+
+    xStats.ulResendRequests++;
+
+    /* The data of a retained response is only released when it leaves the
+     * cache or is fetched again, which a client without a window relies on
+     * to recover the ranges lost before the END packet. */
+    if( ( ulOffset > pxTransfer->ulTotalLength ) ||
+        ( prvCopyTransferData( pxTransfer, ulOffset, NULL, ulEnd - ulOffset ) != pdPASS ) )
+    {
+        ucFlags |= PACKET_FLAG_UNAVAILABLE;
+    }
+    else
+    {
+        while( ulOffset < ulEnd )
+        {
+            ulPayloadLength = prvSendDataV2( pxTransfer, ulOffset, ulEnd );
+
+            if( ulPayloadLength == 0 )
+            {
+                break;
+            }
+
+            xStats.ulRetransmissions++;
+            ulOffset += ulPayloadLength;
+        }
+    }
+
+    ( void ) prvSendTransferEndV2( pxTransfer, ucFlags );
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvNegotiatePayloadSize( const CliRequest_t * pxRequest )
+{
+    uint32_t ulPayloadSize = cliserverDEFAULT_UDP_PAYLOAD_SIZE;
+
+    /* Version 2 clients advertise the largest payload they accept in the
+     * ulLength field of the request. */
+    if( ( pxRequest->ucVersion == PACKET_VERSION_2 ) &&
+        ( pxRequest->ulLength != 0 ) )
+    {
+        ulPayloadSize = pxRequest->ulLength;
+
+        if( ulPayloadSize > cliserverMAX_UDP_PAYLOAD_SIZE )
+        {
+            ulPayloadSize = cliserverMAX_UDP_PAYLOAD_SIZE;
+        }
+        else if( ulPayloadSize < cliserverMIN_UDP_PAYLOAD_SIZE )
+        {
+            ulPayloadSize = cliserverMIN_UDP_PAYLOAD_SIZE;
+        }
+        else
+        {
+            /* The advertised size fits. */
+        }
+    }
+
+    return ( uint16_t ) ulPayloadSize;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDelayResponse( uint32_t ulMaxDelayMs )
+{
+    uint32_t ulRandom = 0;
+
+    if( ulMaxDelayMs > cliserverMAX_RESPONSE_DELAY_MS )
+    {
+        ulMaxDelayMs = cliserverMAX_RESPONSE_DELAY_MS;
+    }
+
+    if( xApplicationGetRandomNumber( &( ulRandom ) ) == pdPASS )
+    {
+        vTaskDelay( pdMS_TO_TICKS( ulRandom % ( ulMaxDelayMs + 1U ) ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvResetTransfer( CliTransfer_t * pxTransfer )
+{
+    /* The previous response leaves the cache. */
+    prvReleaseSegments( pxTransfer );
+
+    pxTransfer->ucFlags = 0;
+    pxTransfer->xDigestValid = pdFALSE;
+    pxTransfer->ulTotalLength = 0;
+    pxTransfer->uxSegmentCount = 0;
+    pxTransfer->ulTextLength = 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBuildTransfer( CliTransfer_t * pxTransfer,
+                              const CliRequest_t * pxRequest )
+{
+    const CliOpcodeDefinition_t * pxOpcode = NULL;
+    CliArgument_t * pxArguments = &( pxTransfer->pxScratch->xArguments[ 0 ] );
+    UBaseType_t uxArgumentCount = 0;
+    char * pcCommand = &( pxTransfer->pxScratch->cCommand[ 0 ] );
+
+    if( pxRequest->ucType == PACKET_TYPE_INVOKE )
+    {
+        if( prvParseArguments( pxRequest, pxArguments, &( uxArgumentCount ) ) == pdPASS )
+        {
+            pxOpcode = prvFindOpcode( pxRequest->usOpcode, NULL );
+        }
+
+        if( pxOpcode != NULL )
+        {
+            prvRunOpcode( pxTransfer, pxOpcode, pxArguments, uxArgumentCount );
+        }
+        else if( ( pxRequest->usOpcode == CLI_OPCODE_COMMAND ) &&
+                 ( uxArgumentCount == 1 ) &&
+                 ( pxArguments[ 0 ].ucTag == CLI_TLV_TEXT ) )
+        {
+            /* Any FreeRTOS+CLI command. The argument fits as it is part of
+             * the request. */
+            memcpy( pcCommand, pxArguments[ 0 ].pucValue, pxArguments[ 0 ].usLength );
+            pcCommand[ pxArguments[ 0 ].usLength ] = '\0';
+            prvRunCommand( pxTransfer, pcCommand );
+        }
+        else if( ( pxRequest->usOpcode == CLI_OPCODE_BATCH ) &&
+                 ( uxArgumentCount > 0 ) )
+        {
+            prvRunBatch( pxTransfer, pxArguments, uxArgumentCount );
+        }
+        else
+        {
+            configPRINTF( ( "[ERROR] Unknown opcode 0x%04x or malformed arguments.\n", pxRequest->usOpcode ) );
+            pxTransfer->ucFlags |= PACKET_FLAG_FAILED;
+        }
+    }
+    else if( pxRequest->ucType == PACKET_TYPE_DISCOVER )
+    {
+        prvBuildDiscovery( pxTransfer );
+    }
+    else
+    {
+        prvRunText( pxTransfer, pxRequest->pcCommand );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvBuildDiscovery( CliTransfer_t * pxTransfer )
+{
+    DiscoveryInfo_t * pxInfo = ( DiscoveryInfo_t * ) &( pxTransfer->cText[ pxTransfer->ulTextLength ] );
+
+    memset( pxInfo, 0, sizeof( DiscoveryInfo_t ) );
+    pxInfo->ucVersion = DISCOVERY_INFO_VERSION;
+    memcpy( &( pxInfo->ucMACAddress[ 0 ] ), ipLOCAL_MAC_ADDRESS, sizeof( pxInfo->ucMACAddress ) );
+    pxInfo->ulIPAddress = FreeRTOS_GetIPAddress();
+    pxInfo->usPort = FreeRTOS_htons( configCLI_SERVER_PORT );
+    pxInfo->usMaxPayloadSize = FreeRTOS_htons( cliserverMAX_UDP_PAYLOAD_SIZE );
+    pxInfo->ulCapabilities = FreeRTOS_htonl( prvGetCapabilities() );
+    pxInfo->ulUptimeMs = FreeRTOS_htonl( ( uint32_t ) ( xTaskGetTickCount() * portTICK_PERIOD_MS ) );
+    strncpy( &( pxInfo->cHostname[ 0 ] ), pcApplicationHostnameHook(), sizeof( pxInfo->cHostname ) );
+
+    if( prvAddSegment( pxTransfer, ( const uint8_t * ) pxInfo, sizeof( DiscoveryInfo_t ), NULL ) == pdPASS )
+    {
+        pxTransfer->ulTextLength += sizeof( DiscoveryInfo_t );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetCapabilities( void )
+{
+    uint32_t ulCapabilities = CLI_CAPABILITY_BATCH | CLI_CAPABILITY_TELEMETRY | CLI_CAPABILITY_CHECKSUM;
+
+    #if ( cliserverUSE_TCP == 1 )
+    {
+        ulCapabilities |= CLI_CAPABILITY_TCP;
+    }
+    #endif
+
+    #if ( cliserverUSE_COMPRESSION == 1 )
+    {
+        ulCapabilities |= CLI_CAPABILITY_COMPRESSION;
+    }
+    #endif
+
+    #if ( cliserverUSE_MULTICAST == 1 )
+    {
+        ulCapabilities |= CLI_CAPABILITY_MULTICAST;
+    }
+    #endif
+
+    if( prvFindOpcode( CLI_OPCODE_PCAP_GET, NULL ) != NULL )
+    {
+        ulCapabilities |= CLI_CAPABILITY_PCAP;
+    }
+
+    if( prvFindOpcode( CLI_OPCODE_TRACE_GET, NULL ) != NULL )
+    {
+        ulCapabilities |= CLI_CAPABILITY_TRACE;
+    }
+
+    if( prvFindOpcode( CLI_OPCODE_COREDUMP_GET, NULL ) != NULL )
+    {
+        ulCapabilities |= CLI_CAPABILITY_COREDUMP;
+    }
+
+    if( prvFindOpcode( CLI_OPCODE_BUNDLE_GET, NULL ) != NULL )
+    {
+        ulCapabilities |= CLI_CAPABILITY_BUNDLE;
+    }
+
+    if( prvFindOpcode( CLI_OPCODE_NETSTAT_DELTA, NULL ) != NULL )
+    {
+        ulCapabilities |= CLI_CAPABILITY_NETSTAT_DELTA;
+    }
+
+    return ulCapabilities;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunText( CliTransfer_t * pxTransfer,
+                        const char * pcCommand )
+{
+    const CliOpcodeDefinition_t * pxOpcode;
+
+    /* Text commands with binary output, such as "pcap get", are served by
+     * the opcode handler registered for them. */
+    pxOpcode = prvFindOpcode( 0, pcCommand );
+
+    if( pxOpcode != NULL )
+    {
+        prvRunOpcode( pxTransfer, pxOpcode, NULL, 0 );
+    }
+    else if( prvRunSubscription( pxTransfer, pcCommand ) == pdFALSE )
+    {
+        prvRunCommand( pxTransfer, pcCommand );
+    }
+    else
+    {
+        /* Served by the server itself as it needs the client address. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunSubscription( CliTransfer_t * pxTransfer,
+                                      const char * pcCommand )
+{
+    BaseType_t xReturn = pdTRUE;
+    BaseType_t xResult = pdFAIL;
+    BaseType_t xArgc;
+    const char * pcArgv[ cliserverSUBSCRIBE_MAX_WORDS ];
+    char * pcWords = &( pxTransfer->pxScratch->cWords[ 0 ] );
+    uint8_t ucStreams = 0;
+    uint32_t ulIntervalMs = 0, ulLeaseMs = 0;
+
+    if( strcmp( pcCommand, "unsubscribe" ) == 0 )
+    {
+        xResult = xCliTelemetryUnsubscribe( &( pxTransfer->xClientAddress ) );
+        prvAddText( pxTransfer, ( xResult == pdPASS ) ? "Unsubscribed.\r\n" : "Not subscribed.\r\n" );
+    }
+    else if( strncmp( pcCommand, "subscribe ", strlen( "subscribe " ) ) == 0 )
+    {
+        /* A command line with too many words is left with no parameters,
+         * which gets the usage text. */
+        xArgc = FreeRTOS_CLITokenize( pcCommand,
+                                      pcWords,
+                                      sizeof( pxTransfer->pxScratch->cWords ),
+                                      &( pcArgv[ 0 ] ),
+                                      cliserverSUBSCRIBE_MAX_WORDS );
+
+        if( xArgc > 1 )
+        {
+            ucStreams = prvParseStreams( pcArgv[ 1 ], ( BaseType_t ) strlen( pcArgv[ 1 ] ) );
+        }
+
+        if( xArgc > 2 )
+        {
+            ulIntervalMs = ( uint32_t ) strtoul( pcArgv[ 2 ], NULL, 10 );
+        }
+
+        if( xArgc > 3 )
+        {
+            ulLeaseMs = ( uint32_t ) strtoul( pcArgv[ 3 ], NULL, 10 );
+        }
+
+        /* The snapshots are sent over UDP. */
+        if( pxTransfer->xIsUdp == pdFALSE )
+        {
+            prvAddText( pxTransfer, "Subscriptions are only available over UDP.\r\n" );
+        }
+        else
+        {
+            xResult = xCliTelemetrySubscribe( xCLIServerSocket,
+                                              &( pxTransfer->xClientAddress ),
+                                              &( pxTransfer->ucRequestId[ 0 ] ),
+                                              ucStreams,
+                                              ulIntervalMs,
+                                              ulLeaseMs );
+            prvAddText( pxTransfer, ( xResult == pdPASS ) ? "Subscribed.\r\n" :
+                                    "Usage: subscribe <netstat,tasks,heap|all> <interval_ms> [lease_ms]\r\n" );
+        }
+    }
+    else
+    {
+        xReturn = pdFALSE;
+    }
+
+    if( ( xReturn == pdTRUE ) && ( xResult != pdPASS ) )
+    {
+        pxTransfer->ucFlags |= PACKET_FLAG_FAILED;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvParseStreams( const char * pcStreams,
+                                BaseType_t xLength )
+{
+    uint8_t ucStreams = 0;
+    BaseType_t xStart = 0, xEnd;
+    size_t uxNameLength;
+
+    while( xStart < xLength )
+    {
+        for( xEnd = xStart; ( xEnd < xLength ) && ( pcStreams[ xEnd ] != ',' ); xEnd++ )
+        {
+        }
+
+        uxNameLength = ( size_t ) ( xEnd - xStart );
+
+        if( ( uxNameLength == strlen( "netstat" ) ) && ( strncmp( &( pcStreams[ xStart ] ), "netstat", uxNameLength ) == 0 ) )
+        {
+            ucStreams |= CLI_STREAM_NETSTAT;
+        }
+        else if( ( uxNameLength == strlen( "tasks" ) ) && ( strncmp( &( pcStreams[ xStart ] ), "tasks", uxNameLength ) == 0 ) )
+        {
+            ucStreams |= CLI_STREAM_TASKS;
+        }
+        else if( ( uxNameLength == strlen( "heap" ) ) && ( strncmp( &( pcStreams[ xStart ] ), "heap", uxNameLength ) == 0 ) )
+        {
+            ucStreams |= CLI_STREAM_HEAP;
+        }
+        else if( ( uxNameLength == strlen( "all" ) ) && ( strncmp( &( pcStreams[ xStart ] ), "all", uxNameLength ) == 0 ) )
+        {
+            ucStreams |= CLI_STREAM_ALL;
+        }
+        else
+        {
+            /* An unknown stream makes the whole list invalid. */
+            ucStreams = 0;
+            break;
+        }
+
+        xStart = xEnd + 1;
+    }
+
+    return ucStreams;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddText( CliTransfer_t * pxTransfer,
+                        const char * pcText )
+{
+    size_t uxLength = strlen( pcText );
+    char * pcBuffer = &( pxTransfer->cText[ pxTransfer->ulTextLength ] );
+
+    if( uxLength > ( sizeof( pxTransfer->cText ) - pxTransfer->ulTextLength ) )
+    {
+        pxTransfer->ucFlags |= PACKET_FLAG_TRUNCATED;
+    }
+    else
+    {
+        memcpy( pcBuffer, pcText, uxLength );
+
+        if( prvAddSegment( pxTransfer, ( const uint8_t * ) pcBuffer, uxLength, NULL ) == pdPASS )
+        {
+            pxTransfer->ulTextLength += uxLength;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunBatch( CliTransfer_t * pxTransfer,
+                         const CliArgument_t * pxArguments,
+                         UBaseType_t uxArgumentCount )
+{
+    BatchResultHeader_t * pxResult;
+    UBaseType_t uxIndex;
+    uint32_t ulStartLength;
+    uint8_t ucFlags = pxTransfer->ucFlags;
+    char * pcCommand = &( pxTransfer->pxScratch->cCommand[ 0 ] );
+
+    for( uxIndex = 0; uxIndex < uxArgumentCount; uxIndex++ )
+    {
+        /* The header of a result is written in the text buffer, in front of
+         * the output, and completed once the command has run. */
+        pxResult = ( BatchResultHeader_t * ) &( pxTransfer->cText[ pxTransfer->ulTextLength ] );
+
+        if( ( ( sizeof( pxTransfer->cText ) - pxTransfer->ulTextLength ) < BATCH_RESULT_HEADER_LENGTH ) ||
+            ( prvAddSegment( pxTransfer, ( const uint8_t * ) pxResult, BATCH_RESULT_HEADER_LENGTH, NULL ) != pdPASS ) )
+        {
+            /* The remaining commands are not run. */
+            ucFlags |= PACKET_FLAG_TRUNCATED;
+            break;
+        }
+
+        pxTransfer->ulTextLength += BATCH_RESULT_HEADER_LENGTH;
+        ulStartLength = pxTransfer->ulTotalLength;
+
+        /* Collect the flags of this command alone. */
+        pxTransfer->ucFlags = 0;
+
+        if( pxArguments[ uxIndex ].ucTag == CLI_TLV_TEXT )
+        {
+            memcpy( pcCommand, pxArguments[ uxIndex ].pucValue, pxArguments[ uxIndex ].usLength );
+            pcCommand[ pxArguments[ uxIndex ].usLength ] = '\0';
+            prvRunText( pxTransfer, pcCommand );
+        }
+        else
+        {
+            pxTransfer->ucFlags |= PACKET_FLAG_FAILED;
+        }
+
+        pxResult->ucIndex = ( uint8_t ) uxIndex;
+        pxResult->ucFlags = pxTransfer->ucFlags;
+        pxResult->ulLength = FreeRTOS_htonl( pxTransfer->ulTotalLength - ulStartLength );
+        ucFlags |= pxTransfer->ucFlags;
+    }
+
+    pxTransfer->ucFlags = ucFlags;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunCommand( CliTransfer_t * pxTransfer,
+                           const char * pcCommand )
+{
+    BaseType_t xResponseRemaining;
+    CLI_Context_t * pxContext = &( pxTransfer->pxScratch->xContext );
+    CLI_Writer_t * pxWriter = &( pxTransfer->pxScratch->xWriter );
+
+    /* The commands write their output straight into the retained text
+     * buffer, in one chunk made of all the space left in it. Once it is full,
+     * the command is still run to completion, but the rest of its output is
+     * dropped. */
+    FreeRTOS_CLIInitContext( pxContext, &( cCommandOutput[ 0 ] ), sizeof( cCommandOutput ) );
+    FreeRTOS_CLIInitWriter( pxWriter,
+                            &( pxTransfer->cText[ pxTransfer->ulTextLength ] ),
+                            sizeof( pxTransfer->cText ) - pxTransfer->ulTextLength,
+                            prvFlushCommandOutput,
+                            pxTransfer );
+
+    do
+    {
+        /* Send the received command to the FreeRTOS+CLI. The mutex is
+         * released between the calls, letting a critical command of another
+         * worker run while a long command is in progress. */
+        ( void ) xSemaphoreTake( xInterpreterMutex, portMAX_DELAY );
+        xResponseRemaining = FreeRTOS_CLIProcessCommandToWriter( pxContext,
+                                                                 pcCommand,
+                                                                 pxWriter );
+        ( void ) xSemaphoreGive( xInterpreterMutex );
+    } while( xResponseRemaining == pdTRUE );
+
+    FreeRTOS_CLIWriterFlush( pxWriter );
+
+    if( pxWriter->xTruncated == pdTRUE )
+    {
+        pxTransfer->ucFlags |= PACKET_FLAG_TRUNCATED;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvFlushCommandOutput( CLI_Writer_t * pxWriter )
+{
+    CliTransfer_t * pxTransfer = ( CliTransfer_t * ) pxWriter->pvOwner;
+
+    if( prvAddSegment( pxTransfer,
+                       ( const uint8_t * ) pxWriter->pcBuffer,
+                       ( uint32_t ) pxWriter->xLength,
+                       NULL ) == pdPASS )
+    {
+        pxTransfer->ulTextLength += pxWriter->xLength;
+    }
+
+    /* The next chunk is what is left of the text buffer, if anything. When
+     * the segment could not be added, the same chunk is written again and the
+     * output is lost, the response being marked truncated. */
+    pxWriter->pcBuffer = &( pxTransfer->cText[ pxTransfer->ulTextLength ] );
+    pxWriter->xBufferLength = sizeof( pxTransfer->cText ) - pxTransfer->ulTextLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunOpcode( CliTransfer_t * pxTransfer,
+                          const CliOpcodeDefinition_t * pxOpcode,
+                          const CliArgument_t * pxArguments,
+                          UBaseType_t uxArgumentCount )
+{
+    BaseType_t xResult;
+    CliPayload_t xPayload;
+    CliOutput_t xOutput;
+    char * pcTextBuffer = &( pxTransfer->cText[ pxTransfer->ulTextLength ] );
+    size_t xTextBufferLength = sizeof( pxTransfer->cText ) - pxTransfer->ulTextLength;
+
+    memset( &( xPayload ), 0, sizeof( xPayload ) );
+    xOutput.pxTransfer = pxTransfer;
+    pxTransfer->pxOpcode = pxOpcode;
+
+    /* Handlers may share state with the FreeRTOS+CLI commands. An output
+     * handler adds its pieces to the response itself, and leaves xPayload
+     * empty. */
+    ( void ) xSemaphoreTake( xInterpreterMutex, portMAX_DELAY );
+
+    /* A retained response of the same opcode releases its data before the
+     * handler fetches it again, so that a fetch never repeats the previous
+     * one. */
+    prvReleaseOpcodeData( pxTransfer, pxOpcode );
+
+    if( pxOpcode->pxHandler != NULL )
+    {
+        xResult = pxOpcode->pxHandler( pxArguments,
+                                       uxArgumentCount,
+                                       pcTextBuffer,
+                                       xTextBufferLength,
+                                       &( xPayload ) );
+    }
+    else
+    {
+        xResult = pxOpcode->pxOutputHandler( pxArguments,
+                                             uxArgumentCount,
+                                             &( xOutput ) );
+    }
+
+    if( xResult != pdPASS )
+    {
+        pxTransfer->ucFlags |= PACKET_FLAG_FAILED;
+    }
+
+    if( xPayload.ucType == CLI_PAYLOAD_TEXT )
+    {
+        configASSERT( xPayload.ulLength <= xTextBufferLength );
+
+        if( prvAddSegment( pxTransfer,
+                           ( const uint8_t * ) pcTextBuffer,
+                           xPayload.ulLength,
+                           NULL ) == pdPASS )
+        {
+            pxTransfer->ulTextLength += xPayload.ulLength;
+        }
+    }
+    else if( xPayload.ucType == CLI_PAYLOAD_MEMORY )
+    {
+        ( void ) prvAddSegment( pxTransfer,
+                                xPayload.pucData,
+                                xPayload.ulLength,
+                                xPayload.pxReleaseHook );
+    }
+    else
+    {
+        /* No payload. */
+    }
+
+    /* Given back only once the data is part of the response, so that the
+     * next handler of the opcode finds it in the cache. */
+    ( void ) xSemaphoreGive( xInterpreterMutex );
+
+    pxTransfer->pxOpcode = NULL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvParseArguments( const CliRequest_t * pxRequest,
+                                     CliArgument_t * pxArguments,
+                                     UBaseType_t * puxArgumentCount )
+{
+    BaseType_t xReturn = pdPASS;
+    const uint8_t * pucPayload = pxRequest->pucPayload;
+    uint16_t usOffset = sizeof( uint16_t ); /* Skip the opcode. */
+    uint16_t usLength;
+
+    *puxArgumentCount = 0;
+
+    /* Every argument is a one byte tag, a two byte length and the value. */
+    while( usOffset < pxRequest->usPayloadLength )
+    {
+        if( ( ( pxRequest->usPayloadLength - usOffset ) < 3U ) ||
+            ( *puxArgumentCount == cliserverMAX_ARGUMENTS ) )
+        {
+            xReturn = pdFAIL;
+            break;
+        }
+
+        usLength = ( uint16_t ) ( ( ( uint16_t ) pucPayload[ usOffset + 1 ] << 8 ) | pucPayload[ usOffset + 2 ] );
+
+        if( usLength > ( pxRequest->usPayloadLength - usOffset - 3U ) )
+        {
+            xReturn = pdFAIL;
+            break;
+        }
+
+        pxArguments[ *puxArgumentCount ].ucTag = pucPayload[ usOffset ];
+        pxArguments[ *puxArgumentCount ].usLength = usLength;
+        pxArguments[ *puxArgumentCount ].pucValue = &( pucPayload[ usOffset + 3U ] );
+        ( *puxArgumentCount )++;
+
+        usOffset += 3U + usLength;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static const CliOpcodeDefinition_t * prvFindOpcode( uint16_t usOpcode,
+                                                    const char * pcAlias )
+{
+    const CliOpcodeDefinition_t * pxOpcode = NULL;
+    UBaseType_t uxIndex;
+
+    for( uxIndex = 0; uxIndex < uxOpcodeCount; uxIndex++ )
+    {
+        if( pcAlias == NULL )
+        {
+            if( pxOpcodes[ uxIndex ]->usOpcode == usOpcode )
+            {
+                pxOpcode = pxOpcodes[ uxIndex ];
+                break;
+            }
+        }
+        else if( ( pxOpcodes[ uxIndex ]->pcAlias != NULL ) &&
+                 ( strcmp( pxOpcodes[ uxIndex ]->pcAlias, pcAlias ) == 0 ) )
+        {
+            pxOpcode = pxOpcodes[ uxIndex ];
+            break;
+        }
+    }
+
+    return pxOpcode;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvAddSegment( CliTransfer_t * pxTransfer,
+                                 const uint8_t * pucData,
+                                 uint32_t ulLength,
+                                 CliReleaseHook_t pxReleaseHook )
+{
+    BaseType_t xReturn = pdPASS;
+    CliSegment_t * pxLastSegment = NULL;
+
+    if( pxTransfer->uxSegmentCount > 0 )
+    {
+        pxLastSegment = &( pxTransfer->xSegments[ pxTransfer->uxSegmentCount - 1 ] );
+    }
+
+    if( ulLength == 0 )
+    {
+        /* Nothing to send but the data still needs to be released. */
+        if( pxReleaseHook != NULL )
+        {
+            pxReleaseHook();
+        }
+    }
+    else if( ( pxLastSegment != NULL ) &&
+             ( pxLastSegment->pxReleaseHook == NULL ) &&
+             ( pxReleaseHook == NULL ) &&
+             ( ( pxLastSegment->pucData + pxLastSegment->ulLength ) == pucData ) )
+    {
+        /* Consecutive outputs of the same command are contiguous in the text
+         * buffer. */
+        pxLastSegment->ulLength += ulLength;
+        pxTransfer->ulTotalLength += ulLength;
+    }
+    else if( pxTransfer->uxSegmentCount < cliserverMAX_SEGMENTS )
+    {
+        pxTransfer->xSegments[ pxTransfer->uxSegmentCount ].pucData = pucData;
+        pxTransfer->xSegments[ pxTransfer->uxSegmentCount ].ulLength = ulLength;
+        pxTransfer->xSegments[ pxTransfer->uxSegmentCount ].pxReleaseHook = pxReleaseHook;
+        pxTransfer->xSegments[ pxTransfer->uxSegmentCount ].pxOpcode = ( pxReleaseHook != NULL ) ? pxTransfer->pxOpcode : NULL;
+        pxTransfer->uxSegmentCount++;
+        pxTransfer->ulTotalLength += ulLength;
+    }
+    else
+    {
+        pxTransfer->ucFlags |= PACKET_FLAG_TRUNCATED;
+        xReturn = pdFAIL;
+
+        if( pxReleaseHook != NULL )
+        {
+            pxReleaseHook();
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseSegments( CliTransfer_t * pxTransfer )
+{
+    UBaseType_t uxSegment;
+    CliSegment_t * pxSegment;
+
+    for( uxSegment = 0; uxSegment < pxTransfer->uxSegmentCount; uxSegment++ )
+    {
+        pxSegment = &( pxTransfer->xSegments[ uxSegment ] );
+
+        if( pxSegment->pxReleaseHook != NULL )
+        {
+            pxSegment->pxReleaseHook();
+            pxSegment->pxReleaseHook = NULL;
+
+            /* The data may be overwritten from now on, so it cannot be sent
+             * again. */
+            pxSegment->pucData = NULL;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseOpcodeData( const CliTransfer_t * pxTransfer,
+                                  const CliOpcodeDefinition_t * pxOpcode )
+{
+    UBaseType_t uxIndex, uxSegment;
+    CliTransfer_t * pxRetained;
+    CliSegment_t * pxSegment;
+    CliReleaseHook_t pxReleaseHook;
+
+    for( uxIndex = 0; uxIndex < cliserverRESPONSE_CACHE_SIZE; uxIndex++ )
+    {
+        pxRetained = &( xTransfers[ uxIndex ] );
+
+        for( uxSegment = 0; ( pxRetained != pxTransfer ) && ( uxSegment < pxRetained->uxSegmentCount ); uxSegment++ )
+        {
+            pxSegment = &( pxRetained->xSegments[ uxSegment ] );
+            pxReleaseHook = NULL;
+
+            /* Only the dispatcher hands a retained response to a worker, so
+             * the data is taken away from it at once. A response being sent
+             * again keeps its data till it leaves the cache. */
+            taskENTER_CRITICAL();
+            {
+                if( ( pxRetained->ucState == cliserverTRANSFER_RETAINED ) &&
+                    ( pxSegment->pxOpcode == pxOpcode ) )
+                {
+                    pxReleaseHook = pxSegment->pxReleaseHook;
+                    pxSegment->pxReleaseHook = NULL;
+
+                    if( pxReleaseHook != NULL )
+                    {
+                        pxSegment->pucData = NULL;
+                    }
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            if( pxReleaseHook != NULL )
+            {
+                pxReleaseHook();
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvGetTransferSpan( const CliTransfer_t * pxTransfer,
+                                      uint32_t ulOffset,
+                                      const uint8_t ** ppucData,
+                                      uint32_t * pulLength )
+{
+    BaseType_t xReturn = pdFAIL;
+    UBaseType_t uxSegment;
+    const CliSegment_t * pxSegment;
+    uint32_t ulSegmentStart = 0;
+
+    for( uxSegment = 0; uxSegment < pxTransfer->uxSegmentCount; uxSegment++ )
+    {
+        pxSegment = &( pxTransfer->xSegments[ uxSegment ] );
+
+        if( ulOffset < ( ulSegmentStart + pxSegment->ulLength ) )
+        {
+            /* Fails if the data has been released. */
+            if( pxSegment->pucData != NULL )
+            {
+                *ppucData = &( pxSegment->pucData[ ulOffset - ulSegmentStart ] );
+                *pulLength = pxSegment->ulLength - ( ulOffset - ulSegmentStart );
+                xReturn = pdPASS;
+            }
+
+            break;
+        }
+
+        ulSegmentStart += pxSegment->ulLength;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCopyTransferData( const CliTransfer_t * pxTransfer,
+                                       uint32_t ulOffset,
+                                       uint8_t * pucDestination,
+                                       uint32_t ulLength )
+{
+    BaseType_t xReturn = pdPASS;
+    UBaseType_t uxSegment;
+    const CliSegment_t * pxSegment;
+    uint32_t ulSegmentStart = 0, ulSegmentOffset, ulCopyLength;
+
+    for( uxSegment = 0; ( uxSegment < pxTransfer->uxSegmentCount ) && ( ulLength > 0 ); uxSegment++ )
+    {
+        pxSegment = &( pxTransfer->xSegments[ uxSegment ] );
+
+        if( ulOffset < ( ulSegmentStart + pxSegment->ulLength ) )
+        {
+            if( pxSegment->pucData == NULL )
+            {
+                xReturn = pdFAIL;
+                break;
+            }
+
+            ulSegmentOffset = ulOffset - ulSegmentStart;
+            ulCopyLength = pxSegment->ulLength - ulSegmentOffset;
+
+            if( ulCopyLength > ulLength )
+            {
+                ulCopyLength = ulLength;
+            }
+
+            /* A NULL destination only checks that the range can be sent. */
+            if( pucDestination != NULL )
+            {
+                memcpy( pucDestination, &( pxSegment->pucData[ ulSegmentOffset ] ), ulCopyLength );
+                pucDestination += ulCopyLength;
+            }
+
+            ulOffset += ulCopyLength;
+            ulLength -= ulCopyLength;
+        }
+
+        ulSegmentStart += pxSegment->ulLength;
+    }
+
+    /* The range goes past the end of the response. */
+    if( ulLength > 0 )
+    {
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvComputeDigest( CliTransfer_t * pxTransfer )
+{
+    UBaseType_t uxSegment;
+    const CliSegment_t * pxSegment;
+    uint32_t ulDigest = 0;
+
+    for( uxSegment = 0; uxSegment < pxTransfer->uxSegmentCount; uxSegment++ )
+    {
+        pxSegment = &( pxTransfer->xSegments[ uxSegment ] );
+
+        /* Released data cannot be sent again anyway. */
+        if( pxSegment->pucData == NULL )
+        {
+            break;
+        }
+
+        ulDigest = ulCliCrc32( ulDigest, pxSegment->pucData, pxSegment->ulLength );
+    }
+
+    if( uxSegment == pxTransfer->uxSegmentCount )
+    {
+        pxTransfer->ulDigest = ulDigest;
+        pxTransfer->xDigestValid = pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsTransferClient( const CliTransfer_t * pxTransfer,
+                                       const struct freertos_sockaddr * pxAddress,
+                                       const uint8_t * pucRequestId )
+{
+    BaseType_t xReturn = pdFALSE;
+
+    if( ( pxTransfer->ucState != cliserverTRANSFER_FREE ) &&
+        ( pxTransfer->xClientAddress.sin_address.ulIP_IPv4 == pxAddress->sin_address.ulIP_IPv4 ) &&
+        ( pxTransfer->xClientAddress.sin_port == pxAddress->sin_port ) &&
+        ( memcmp( &( pxTransfer->ucRequestId[ 0 ] ), pucRequestId, 4 ) == 0 ) )
+    {
+        xReturn = pdTRUE;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendPacket( const struct freertos_sockaddr * pxAddress,
+                                 const void * pvHeader,
+                                 size_t uxHeaderLength,
+                                 const CliTransfer_t * pxTransfer,
+                                 uint32_t ulOffset,
+                                 const uint8_t * pucPayload,
+                                 uint32_t ulPayloadLength,
+                                 BaseType_t xChecksum )
+{
+    BaseType_t xReturn = pdFAIL;
+    uint8_t * pucUdpPayload;
+    BaseType_t xSendFlags;
+    int32_t lBytesSent;
+    size_t uxPayloadStart = uxHeaderLength;
+    size_t uxPacketLength;
+    uint32_t ulCrc;
+
+    /* The CRC32 of the payload goes between the header and the payload. */
+    if( xChecksum == pdTRUE )
+    {
+        uxPayloadStart += CLI_CHECKSUM_LENGTH;
+    }
+
+    uxPacketLength = uxPayloadStart + ulPayloadLength;
+
+    /* Both paths take a network buffer without blocking, either here or in
+     * FreeRTOS_sendto, so the IP stack is never asked for one it may not
+     * have. */
+    pucUdpPayload = NULL;
+
+    #if ( cliserverUSE_ZERO_COPY_TX == 1 )
+    {
+        /* Get a network buffer from the IP stack and write the packet
+         * straight into it so that FreeRTOS_sendto does not need to copy it
+         * again. */
+        if( uxGetNumberOfFreeNetworkBuffers() >= cliserverSEND_MIN_FREE_BUFFERS )
+        {
+            pucUdpPayload = ( uint8_t * ) FreeRTOS_GetUDPPayloadBuffer( uxPacketLength, 0 );
+        }
+
+        xSendFlags = FREERTOS_ZERO_COPY | FREERTOS_MSG_DONTWAIT;
+    }
+    #else
+    {
+        ( void ) xSemaphoreTake( xResponseBufferMutex, portMAX_DELAY );
+
+        if( uxGetNumberOfFreeNetworkBuffers() >= cliserverSEND_MIN_FREE_BUFFERS )
+        {
+            pucUdpPayload = &( ucUdpResponseBuffer[ 0 ] );
+        }
+
+        xSendFlags = FREERTOS_MSG_DONTWAIT;
+    }
+    #endif /* cliserverUSE_ZERO_COPY_TX */
+
+    /* Without a network buffer, the packet is not sent. The callers decide
+     * whether to send it again later. */
+    if( pucUdpPayload != NULL )
+    {
+        memcpy( &( pucUdpPayload[ 0 ] ), pvHeader, uxHeaderLength );
+
+        /* The payload is either given or copied from the transfer. */
+        if( pucPayload != NULL )
+        {
+            memcpy( &( pucUdpPayload[ uxPayloadStart ] ), pucPayload, ulPayloadLength );
+        }
+
+        if( ( ulPayloadLength == 0 ) ||
+            ( pucPayload != NULL ) ||
+            ( prvCopyTransferData( pxTransfer, ulOffset, &( pucUdpPayload[ uxPayloadStart ] ), ulPayloadLength ) == pdPASS ) )
+        {
+            /* Computed over the copy in the network buffer, which is what
+             * the client receives. */
+            if( xChecksum == pdTRUE )
+            {
+                ulCrc = FreeRTOS_htonl( ulCliCrc32( 0, &( pucUdpPayload[ uxPayloadStart ] ), ulPayloadLength ) );
+                memcpy( &( pucUdpPayload[ uxHeaderLength ] ), &( ulCrc ), CLI_CHECKSUM_LENGTH );
+            }
+
+            lBytesSent = FreeRTOS_sendto( xCLIServerSocket,
+                                          ( const void * ) &( pucUdpPayload[ 0 ] ),
+                                          uxPacketLength,
+                                          xSendFlags,
+                                          pxAddress,
+                                          sizeof( struct freertos_sockaddr ) );
+
+            if( lBytesSent == ( int32_t ) uxPacketLength )
+            {
+                xReturn = pdPASS;
+            }
+        }
+
+        #if ( cliserverUSE_ZERO_COPY_TX == 1 )
+        {
+            if( xReturn != pdPASS )
+            {
+                /* The IP stack did not take the ownership of the buffer. */
+                FreeRTOS_ReleaseUDPPayloadBuffer( ( const void * ) pucUdpPayload );
+            }
+        }
+        #endif
+    }
+
+    #if ( cliserverUSE_ZERO_COPY_TX == 0 )
+    {
+        ( void ) xSemaphoreGive( xResponseBufferMutex );
+    }
+    #endif
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPaceData( uint32_t ulLength )
+{
+    BaseType_t xReturn = pdPASS, xAllowed = pdFALSE;
+    UBaseType_t uxFreeBuffers;
+    TickType_t xStartTick = xTaskGetTickCount(), xStarvedTick = xStartTick, xNow;
+    uint64_t ullTokens;
+
+    for( ;; )
+    {
+        uxFreeBuffers = uxGetNumberOfFreeNetworkBuffers();
+
+        taskENTER_CRITICAL();
+        {
+            /* Refill the bucket for the time elapsed. The tick of the last
+             * refill only moves when at least one token is added so that
+             * slow rates are not rounded down to nothing. */
+            xNow = xTaskGetTickCount();
+            ullTokens = ( ( uint64_t ) ( xNow - xPacerLastTick ) * ulPacerRate ) / configTICK_RATE_HZ;
+
+            if( ullTokens > 0 )
+            {
+                ullTokens += ulPacerTokens;
+                ulPacerTokens = ( ullTokens > cliserverPACER_BURST_BYTES ) ? cliserverPACER_BURST_BYTES : ( uint32_t ) ullTokens;
+                xPacerLastTick = xNow;
+            }
+
+            if( ( uxFreeBuffers >= cliserverPACER_MIN_FREE_BUFFERS ) &&
+                ( ( ulPacerRate == 0 ) || ( ulPacerTokens >= ulLength ) ) )
+            {
+                if( ulPacerRate != 0 )
+                {
+                    ulPacerTokens -= ulLength;
+                }
+
+                xAllowed = pdTRUE;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if( xAllowed == pdTRUE )
+        {
+            break;
+        }
+
+        /* The tokens always come, the network buffers may not. */
+        if( uxFreeBuffers >= cliserverPACER_MIN_FREE_BUFFERS )
+        {
+            xStarvedTick = xNow;
+        }
+        else if( ( xNow - xStarvedTick ) >= pdMS_TO_TICKS( cliserverSEND_DEFER_TIMEOUT_MS ) )
+        {
+            configPRINTF( ( "[ERROR] Fewer than %u network buffers free for %u ms.\n",
+                            ( unsigned ) cliserverPACER_MIN_FREE_BUFFERS,
+                            ( unsigned ) cliserverSEND_DEFER_TIMEOUT_MS ) );
+            xReturn = pdFAIL;
+            break;
+        }
+        else
+        {
+            /* Still waiting for the IP stack. */
+        }
+
+        vTaskDelay( 1 );
+    }
+
+    xNow = xTaskGetTickCount();
+
+    if( xNow != xStartTick )
+    {
+        taskENTER_CRITICAL();
+        {
+            xStats.ulThrottleEvents++;
+            xStats.ulThrottledTimeMs += ( uint32_t ) ( ( xNow - xStartTick ) * portTICK_PERIOD_MS );
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRefundPacer( uint32_t ulLength )
+{
+    uint64_t ullTokens;
+
+    taskENTER_CRITICAL();
+    {
+        if( ulPacerRate != 0 )
+        {
+            ullTokens = ( uint64_t ) ulPacerTokens + ulLength;
+            ulPacerTokens = ( ullTokens > cliserverPACER_BURST_BYTES ) ? cliserverPACER_BURST_BYTES : ( uint32_t ) ullTokens;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDeferSend( TickType_t xDeferStartTick )
+{
+    BaseType_t xReturn = pdPASS;
+
+    /* UDP sockets have no writable event, so the worker polls for free
+     * network buffers like the pacer. Only the worker of the client is held
+     * back, the other workers and the dispatcher go on sending. */
+    taskENTER_CRITICAL();
+    {
+        xStats.ulDeferredSends++;
+    }
+    taskEXIT_CRITICAL();
+
+    do
+    {
+        if( ( xTaskGetTickCount() - xDeferStartTick ) >= pdMS_TO_TICKS( cliserverSEND_DEFER_TIMEOUT_MS ) )
+        {
+            configPRINTF( ( "[ERROR] The IP stack did not take a response packet for %u ms.\n", ( unsigned ) cliserverSEND_DEFER_TIMEOUT_MS ) );
+            xReturn = pdFAIL;
+            break;
+        }
+
+        vTaskDelay( 1 );
+    } while( uxGetNumberOfFreeNetworkBuffers() < cliserverSEND_MIN_FREE_BUFFERS );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendResponseV1( CliTransfer_t * pxTransfer )
+{
+    BaseType_t xReturn;
+    PacketHeader_t xHeader;
+    uint8_t ucPacketNumber = 1;
+    uint32_t ulOffset = 0, ulPayloadLength;
+    TickType_t xDeferStartTick;
+
+    xHeader.ucStartMarker = PACKET_START_MARKER;
+    memcpy( &( xHeader.ucRequestId[ 0 ] ), &( pxTransfer->ucRequestId[ 0 ] ), 4 );
+
+    /* The last packet sent is the one with zero payload length. */
+    do
+    {
+        ulPayloadLength = pxTransfer->ulTotalLength - ulOffset;
+
+        if( ulPayloadLength > pxTransfer->usPayloadSize )
+        {
+            ulPayloadLength = pxTransfer->usPayloadSize;
+        }
+
+        xHeader.ucPacketNumber = ucPacketNumber;
+        ucPacketNumber++;
+        xHeader.usPayloadLength = FreeRTOS_htons( ( uint16_t ) ulPayloadLength );
+
+        /* Only the response data is paced. The other packets are small and
+         * the dispatcher must never block on the pacer. A packet is charged
+         * once, however many times the IP stack refuses it. */
+        xReturn = pdPASS;
+
+        if( ulPayloadLength > 0 )
+        {
+            xReturn = prvPaceData( ulPayloadLength );
+        }
+
+        if( xReturn == pdPASS )
+        {
+            xDeferStartTick = xTaskGetTickCount();
+
+            do
+            {
+                xReturn = prvSendPacket( &( pxTransfer->xClientAddress ),
+                                         &( xHeader ),
+                                         PACKET_HEADER_LENGTH,
+                                         pxTransfer,
+                                         ulOffset,
+                                         NULL,
+                                         ulPayloadLength,
+                                         pdFALSE );
+            } while( ( xReturn != pdPASS ) && ( prvDeferSend( xDeferStartTick ) == pdPASS ) );
+
+            if( ( xReturn != pdPASS ) && ( ulPayloadLength > 0 ) )
+            {
+                prvRefundPacer( ulPayloadLength );
+            }
+        }
+
+        if( ( xReturn == pdPASS ) && ( ulPayloadLength > 0 ) )
+        {
+            pxTransfer->ulDatagrams++;
+            xStats.ulDatagrams++;
+        }
+
+        ulOffset += ulPayloadLength;
+    } while( ( xReturn == pdPASS ) && ( ulPayloadLength > 0 ) );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendResponseV2( CliWorker_t * pxWorker,
+                                     CliTransfer_t * pxTransfer,
+                                     uint16_t usWindow )
+{
+    BaseType_t xReturn = pdPASS;
+    uint32_t ulNextOffset = 0, ulAckedOffset = 0, ulHighestOffset = 0;
+    uint32_t ulWindowBytes, ulPayloadLength;
+    UBaseType_t uxRetries = 0;
+    uint8_t ucFlags = pxTransfer->ucFlags;
+
+    if( usWindow > cliserverMAX_WINDOW )
+    {
+        usWindow = cliserverMAX_WINDOW;
+    }
+
+    ulWindowBytes = ( uint32_t ) usWindow * pxTransfer->usPayloadSize;
+
+    for( ;; )
+    {
+        /* Send as much as the window allows. Without a window, the complete
+         * response is sent and the client recovers any lost packet with a
+         * RESEND request. */
+        while( ( ulNextOffset < pxTransfer->ulTotalLength ) &&
+               ( ( usWindow == 0 ) || ( ( ulNextOffset - ulAckedOffset ) < ulWindowBytes ) ) )
+        {
+            ulPayloadLength = prvSendDataV2( pxTransfer, ulNextOffset, pxTransfer->ulTotalLength );
+
+            /* The IP stack did not have the network buffers in time. */
+            if( ulPayloadLength == 0 )
+            {
+                ucFlags |= PACKET_FLAG_ABORTED;
+                xReturn = pdFAIL;
+                break;
+            }
+
+            if( ulNextOffset < ulHighestOffset )
+            {
+                xStats.ulRetransmissions++;
+            }
+
+            ulNextOffset += ulPayloadLength;
+
+            if( ulNextOffset > ulHighestOffset )
+            {
+                ulHighestOffset = ulNextOffset;
+            }
+        }
+
+        if( ( xReturn != pdPASS ) ||
+            ( usWindow == 0 ) ||
+            ( ulAckedOffset >= pxTransfer->ulTotalLength ) )
+        {
+            break;
+        }
+
+        if( prvWaitForAck( pxWorker, pxTransfer, &( ulAckedOffset ) ) == pdTRUE )
+        {
+            uxRetries = 0;
+
+            if( ulNextOffset < ulAckedOffset )
+            {
+                ulNextOffset = ulAckedOffset;
+            }
+        }
+        else if( uxRetries < cliserverMAX_ACK_RETRIES )
+        {
+            /* Go back to the first packet which is not acknowledged. */
+            uxRetries++;
+            ulNextOffset = ulAckedOffset;
+        }
+        else
+        {
+            configPRINTF( ( "[ERROR] No ACK from the client. Response aborted at offset %lu.\n", ( unsigned long ) ulAckedOffset ) );
+            ucFlags |= PACKET_FLAG_ABORTED;
+            xReturn = pdFAIL;
+            break;
+        }
+    }
+
+    /* The END packet is sent even if the response is incomplete so that the
+     * client can ask for the missing ranges. */
+    if( prvSendTransferEndV2( pxTransfer, ucFlags ) != pdPASS )
+    {
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSendDataV2( CliTransfer_t * pxTransfer,
+                               uint32_t ulOffset,
+                               uint32_t ulEnd )
+{
+    uint32_t ulRawLength;
+    uint32_t ulChargedLength = ulEnd - ulOffset;
+    TickType_t xDeferStartTick;
+
+    if( ulChargedLength > pxTransfer->usPayloadSize )
+    {
+        ulChargedLength = pxTransfer->usPayloadSize;
+    }
+
+    /* The packet is paced once, before the compressor is taken, so that a
+     * worker held back by the pacer does not hold back the compression of
+     * the other workers. The size of the packet is not known yet, it is
+     * charged for the raw chunk and prvTrySendDataV2() gives back the bytes
+     * saved by the compression. */
+    if( prvPaceData( ulChargedLength ) != pdPASS )
+    {
+        ulRawLength = 0;
+    }
+    else
+    {
+        xDeferStartTick = xTaskGetTickCount();
+
+        /* The compressor is not held while the packet is held back. The
+         * chunks always start at the same offsets, so a chunk compressed
+         * again gives the same packet. */
+        do
+        {
+            ulRawLength = prvTrySendDataV2( pxTransfer, ulOffset, ulEnd );
+        } while( ( ulRawLength == 0 ) && ( prvDeferSend( xDeferStartTick ) == pdPASS ) );
+
+        if( ulRawLength == 0 )
+        {
+            prvRefundPacer( ulChargedLength );
+        }
+    }
+
+    return ulRawLength;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTrySendDataV2( CliTransfer_t * pxTransfer,
+                                  uint32_t ulOffset,
+                                  uint32_t ulEnd )
+{
+    PacketHeaderV2_t xHeader;
+    uint32_t ulPayloadLength = ulEnd - ulOffset;
+    uint32_t ulRawLength, ulChargedLength;
+    const uint8_t * pucPayload = NULL;
+    uint8_t ucFlags = 0;
+
+    if( ulPayloadLength > pxTransfer->usPayloadSize )
+    {
+        ulPayloadLength = pxTransfer->usPayloadSize;
+    }
+
+    /* The length prvSendDataV2() charged the pacer with. */
+    ulRawLength = ulPayloadLength;
+    ulChargedLength = ulPayloadLength;
+
+    #if ( cliserverUSE_COMPRESSION == 1 )
+    {
+        if( pxTransfer->xCompress == pdTRUE )
+        {
+            ( void ) xSemaphoreTake( xCompressorMutex, portMAX_DELAY );
+
+            /* Data which does not compress is sent as it is. */
+            if( prvCompressData( pxTransfer, ulOffset, ulEnd, &( ulRawLength ), &( ulPayloadLength ) ) == pdPASS )
+            {
+                ucFlags = PACKET_FLAG_COMPRESSED;
+                pucPayload = &( ucCompressBuffer[ 0 ] );
+            }
+        }
+    }
+    #endif
+
+    prvFillHeaderV2( &( xHeader ),
+                     PACKET_TYPE_DATA,
+                     ucFlags,
+                     &( pxTransfer->ucRequestId[ 0 ] ),
+                     ulOffset,
+                     pxTransfer->ulTotalLength,
+                     ( uint16_t ) ulPayloadLength );
+
+    if( ucFlags == PACKET_FLAG_COMPRESSED )
+    {
+        xHeader.usWindow = FreeRTOS_htons( ( uint16_t ) ulRawLength );
+    }
+
+    if( pxTransfer->xChecksum == pdTRUE )
+    {
+        xHeader.ucFlags |= PACKET_FLAG_CHECKSUM;
+    }
+
+    if( prvSendPacket( &( pxTransfer->xClientAddress ),
+                       &( xHeader ),
+                       PACKET_HEADER_V2_LENGTH,
+                       pxTransfer,
+                       ulOffset,
+                       pucPayload,
+                       ulPayloadLength,
+                       pxTransfer->xChecksum ) != pdPASS )
+    {
+        ulRawLength = 0;
+    }
+    else
+    {
+        pxTransfer->ulDatagrams++;
+        xStats.ulDatagrams++;
+
+        /* The chunks always start at the same offsets, so a chunk is sent
+         * for the first time when it starts where the data sent so far
+         * ends. */
+        if( ulOffset == pxTransfer->ulSentOffset )
+        {
+            pxTransfer->ulSentOffset += ulRawLength;
+            pxTransfer->ulWireLength += ulPayloadLength;
+        }
+
+        if( ucFlags == PACKET_FLAG_COMPRESSED )
+        {
+            xStats.ulCompressedRawBytes += ulRawLength;
+            xStats.ulCompressedBytes += ulPayloadLength;
+        }
+
+        if( ulPayloadLength < ulChargedLength )
+        {
+            prvRefundPacer( ulChargedLength - ulPayloadLength );
+        }
+    }
+
+    #if ( cliserverUSE_COMPRESSION == 1 )
+    {
+        if( pxTransfer->xCompress == pdTRUE )
+        {
+            ( void ) xSemaphoreGive( xCompressorMutex );
+        }
+    }
+    #endif
+
+    return ulRawLength;
+}
+/*-----------------------------------------------------------*/
+
+#if ( cliserverUSE_COMPRESSION == 1 )
+
+static BaseType_t prvCompressData( const CliTransfer_t * pxTransfer,
+                                   uint32_t ulOffset,
+                                   uint32_t ulEnd,
+                                   uint32_t * pulRawLength,
+                                   uint32_t * pulCompressedLength )
+{
+    BaseType_t xReturn = pdFAIL;
+    const uint8_t * pucData;
+    uint32_t ulSpan;
+    size_t xConsumed = 0, xCompressedLength;
+
+    /* A block never crosses a segment boundary so that it is compressed
+     * straight from the memory of the segment. */
+    if( prvGetTransferSpan( pxTransfer, ulOffset, &( pucData ), &( ulSpan ) ) == pdPASS )
+    {
+        if( ulSpan > ( ulEnd - ulOffset ) )
+        {
+            ulSpan = ulEnd - ulOffset;
+        }
+
+        xCompressedLength = xCliCompressBlock( &( xCompressState ),
+                                               pucData,
+                                               ulSpan,
+                                               &( ucCompressBuffer[ 0 ] ),
+                                               pxTransfer->usPayloadSize,
+                                               &( xConsumed ) );
+
+        if( xCompressedLength < xConsumed )
+        {
+            *pulRawLength = ( uint32_t ) xConsumed;
+            *pulCompressedLength = ( uint32_t ) xCompressedLength;
+            xReturn = pdPASS;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* cliserverUSE_COMPRESSION */
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendEndV2( const uint8_t * pucRequestId,
+                                const struct freertos_sockaddr * pxAddress,
+                                uint32_t ulTotalLength,
+                                uint8_t ucFlags )
+{
+    PacketHeaderV2_t xHeader;
+
+    prvFillHeaderV2( &( xHeader ),
+                     PACKET_TYPE_END,
+                     ucFlags,
+                     pucRequestId,
+                     ulTotalLength,
+                     ulTotalLength,
+                     0 );
+
+    /* Only sent by the dispatcher, which never waits for the IP stack. The
+     * packet is dropped while the network buffers are short and the client
+     * recovers a lost END packet by retrying the request. */
+    return prvSendPacket( pxAddress,
+                          &( xHeader ),
+                          PACKET_HEADER_V2_LENGTH,
+                          NULL,
+                          0,
+                          NULL,
+                          0,
+                          pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendTransferEndV2( const CliTransfer_t * pxTransfer,
+                                        uint8_t ucFlags )
+{
+    BaseType_t xReturn;
+    PacketHeaderV2_t xHeader;
+    uint32_t ulOffset = pxTransfer->ulTotalLength;
+    uint32_t ulDigest = 0;
+    uint16_t usPayloadLength = 0;
+    TickType_t xDeferStartTick = xTaskGetTickCount();
+
+    /* The END packet of a compressed response carries the number of payload
+     * bytes sent besides the raw length. */
+    if( pxTransfer->xCompress == pdTRUE )
+    {
+        ucFlags |= PACKET_FLAG_COMPRESSED;
+        ulOffset = pxTransfer->ulWireLength;
+    }
+
+    /* The digest of the whole response is the payload of the END packet. */
+    if( ( pxTransfer->xChecksum == pdTRUE ) && ( pxTransfer->xDigestValid == pdTRUE ) )
+    {
+        ucFlags |= PACKET_FLAG_CHECKSUM;
+        ulDigest = FreeRTOS_htonl( pxTransfer->ulDigest );
+        usPayloadLength = CLI_CHECKSUM_LENGTH;
+    }
+
+    prvFillHeaderV2( &( xHeader ),
+                     PACKET_TYPE_END,
+                     ucFlags,
+                     &( pxTransfer->ucRequestId[ 0 ] ),
+                     ulOffset,
+                     pxTransfer->ulTotalLength,
+                     usPayloadLength );
+
+    /* Only sent by the workers, which hold it back like the DATA packets. */
+    do
+    {
+        xReturn = prvSendPacket( &( pxTransfer->xClientAddress ),
+                                 &( xHeader ),
+                                 PACKET_HEADER_V2_LENGTH,
+                                 NULL,
+                                 0,
+                                 ( const uint8_t * ) &( ulDigest ),
+                                 usPayloadLength,
+                                 pdFALSE );
+    } while( ( xReturn != pdPASS ) && ( prvDeferSend( xDeferStartTick ) == pdPASS ) );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillHeaderV2( PacketHeaderV2_t * pxHeader,
+                             uint8_t ucType,
+                             uint8_t ucFlags,
+                             const uint8_t * pucRequestId,
+                             uint32_t ulOffset,
+                             uint32_t ulLength,
+                             uint16_t usPayloadLength )
+{
+    pxHeader->ucStartMarker = PACKET_START_MARKER_V2;
+    pxHeader->ucVersion = PACKET_VERSION_2;
+    pxHeader->ucType = ucType;
+    pxHeader->ucFlags = ucFlags;
+    memcpy( &( pxHeader->ucRequestId[ 0 ] ), pucRequestId, 4 );
+    pxHeader->ulOffset = FreeRTOS_htonl( ulOffset );
+    pxHeader->ulLength = FreeRTOS_htonl( ulLength );
+    pxHeader->usPayloadLength = FreeRTOS_htons( usPayloadLength );
+    pxHeader->usWindow = 0;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvWaitForAck( CliWorker_t * pxWorker,
+                                 CliTransfer_t * pxTransfer,
+                                 uint32_t * pulAckedOffset )
+{
+    BaseType_t xProgress = pdFALSE;
+    CliMessage_t xMessage;
+    const TickType_t xAckTimeout = pdMS_TO_TICKS( cliserverACK_TIMEOUT_MS );
+    TickType_t xStartTick = xTaskGetTickCount(), xElapsed;
+
+    for( ;; )
+    {
+        xElapsed = xTaskGetTickCount() - xStartTick;
+
+        if( ( xProgress == pdTRUE ) || ( xElapsed >= xAckTimeout ) )
+        {
+            break;
+        }
+
+        if( xQueueReceive( pxWorker->xQueue, &( xMessage ), xAckTimeout - xElapsed ) != pdPASS )
+        {
+            /* Timed out. */
+            break;
+        }
+
+        /* The dispatcher only forwards the packets of the response being
+         * sent by this worker, but a stale packet may still be queued. */
+        if( ( xMessage.ucAction == cliserverACTION_FORWARD ) &&
+            ( xMessage.pxTransfer == pxTransfer ) &&
+            ( xMessage.xRequest.ucVersion == PACKET_VERSION_2 ) )
+        {
+            if( xMessage.xRequest.ucType == PACKET_TYPE_ACK )
+            {
+                /* ACKs are cumulative - only an ACK that moves the window
+                 * forward is a progress. */
+                if( ( xMessage.xRequest.ulOffset > *pulAckedOffset ) &&
+                    ( xMessage.xRequest.ulOffset <= pxTransfer->ulTotalLength ) )
+                {
+                    *pulAckedOffset = xMessage.xRequest.ulOffset;
+                    xProgress = pdTRUE;
+                }
+            }
+            else if( xMessage.xRequest.ucType == PACKET_TYPE_RESEND )
+            {
+                prvServeResend( pxTransfer, &( xMessage.xRequest ) );
+            }
+            else
+            {
+                /* Requests are only handed to idle workers. */
+            }
+        }
+    }
+
+    return xProgress;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUpdateThroughputStats( uint32_t ulResponseBytes,
+                                      uint32_t ulDatagrams,
+                                      uint16_t usPayloadSize,
+                                      TickType_t xElapsedTicks )
+{
+    uint32_t ulElapsedMs = ( uint32_t ) ( xElapsedTicks * portTICK_PERIOD_MS );
+    uint32_t ulBytesPerSecond;
+    uint32_t ulAverageBytesPerSecond;
+
+    /* Responses sent within one tick are accounted as taking one tick to
+     * avoid dividing by zero. */
+    if( ulElapsedMs == 0 )
+    {
+        ulElapsedMs = portTICK_PERIOD_MS;
+    }
+
+    ulBytesPerSecond = ( uint32_t ) ( ( ( uint64_t ) ulResponseBytes * 1000U ) / ulElapsedMs );
+
+    /* The UDP and the TCP tasks both update the statistics. */
+    taskENTER_CRITICAL();
+    {
+        xStats.ulResponses++;
+        xStats.ulTotalBytes += ulResponseBytes;
+        xStats.ulTotalTimeMs += ulElapsedMs;
+        xStats.ulLastBytesPerSecond = ulBytesPerSecond;
+
+        /* TCP responses are not split in datagrams by the server. */
+        if( usPayloadSize != 0 )
+        {
+            xStats.ulLastDatagrams = ulDatagrams;
+            xStats.ulLastPayloadSize = usPayloadSize;
+        }
+
+        ulAverageBytesPerSecond = ( uint32_t ) ( ( ( uint64_t ) xStats.ulTotalBytes * 1000U ) / xStats.ulTotalTimeMs );
+    }
+    taskEXIT_CRITICAL();
+
+    configPRINTF( ( "Response of %lu bytes in %lu datagrams sent in %lu ms (%lu bytes/s). Average: %lu bytes/s.\n",
+                    ( unsigned long ) ulResponseBytes,
+                    ( unsigned long ) ulDatagrams,
+                    ( unsigned long ) ulElapsedMs,
+                    ( unsigned long ) ulBytesPerSecond,
+                    ( unsigned long ) ulAverageBytesPerSecond ) );
+}
+/*-----------------------------------------------------------*/
+
+#if ( cliserverUSE_TCP == 1 )
+
+static void prvCliServerTcpTask( void * pvParameters )
+{
+    Socket_t xListeningSocket;
+    struct freertos_sockaddr xServerAddress;
+    TickType_t xNoTimeout = 0;
+    TickType_t xSelectTimeout;
+    WinProperties_t xWinProperties;
+    CliTcpSession_t * pxFreeSession;
+    UBaseType_t uxIndex;
+
+    ( void ) pvParameters;
+
+    xTcpSocketSet = FreeRTOS_CreateSocketSet();
+    configASSERT( xTcpSocketSet != NULL );
+
+    xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET,
+                                        FREERTOS_SOCK_STREAM,
+                                        FREERTOS_IPPROTO_TCP );
+    configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+    /* The task only blocks in FreeRTOS_select. The accepted sockets inherit
+     * the timeouts and the window properties of the listening socket. */
+    FreeRTOS_setsockopt( xListeningSocket,
+                         0,
+                         FREERTOS_SO_RCVTIMEO,
+                         &( xNoTimeout ),
+                         sizeof( TickType_t ) );
+
+    FreeRTOS_setsockopt( xListeningSocket,
+                         0,
+                         FREERTOS_SO_SNDTIMEO,
+                         &( xNoTimeout ),
+                         sizeof( TickType_t ) );
+
+    memset( &( xWinProperties ), 0, sizeof( xWinProperties ) );
+    xWinProperties.lTxBufSize = cliserverTCP_TX_BUFFER_SIZE;
+    xWinProperties.lTxWinSize = cliserverTCP_TX_WINDOW_SIZE;
+    xWinProperties.lRxBufSize = cliserverTCP_RX_BUFFER_SIZE;
+    xWinProperties.lRxWinSize = cliserverTCP_RX_WINDOW_SIZE;
+    FreeRTOS_setsockopt( xListeningSocket,
+                         0,
+                         FREERTOS_SO_WIN_PROPERTIES,
+                         &( xWinProperties ),
+                         sizeof( xWinProperties ) );
+
+    xServerAddress.sin_port = FreeRTOS_htons( configCLI_SERVER_PORT );
+    xServerAddress.sin_family = FREERTOS_AF_INET;
+    xServerAddress.sin_address.ulIP_IPv4 = FreeRTOS_GetIPAddress();
+    FreeRTOS_bind( xListeningSocket, &( xServerAddress ), sizeof( xServerAddress ) );
+    FreeRTOS_listen( xListeningSocket, cliserverTCP_MAX_SESSIONS );
+
+    configPRINTF( ( "Waiting for TCP connections...\n" ) );
+
+    for( ;; )
+    {
+        pxFreeSession = NULL;
+        xSelectTimeout = portMAX_DELAY;
+
+        for( uxIndex = 0; uxIndex < cliserverTCP_MAX_SESSIONS; uxIndex++ )
+        {
+            if( xTcpSessions[ uxIndex ].ucState == cliserverSESSION_FREE )
+            {
+                pxFreeSession = &( xTcpSessions[ uxIndex ] );
+            }
+            else if( xTcpSessions[ uxIndex ].ucState != cliserverSESSION_RECEIVING )
+            {
+                /* Wake up to time out a session waiting for TX space or for
+                 * the peer to close. */
+                xSelectTimeout = pdMS_TO_TICKS( cliserverTCP_POLL_INTERVAL_MS );
+            }
+            else
+            {
+                /* Waits for a request as long as the client wants. */
+            }
+        }
+
+        /* New connections wait in the backlog while all the sessions are in
+         * use. */
+        if( pxFreeSession != NULL )
+        {
+            FreeRTOS_FD_SET( xListeningSocket, xTcpSocketSet, eSELECT_READ );
+        }
+        else
+        {
+            FreeRTOS_FD_CLR( xListeningSocket, xTcpSocketSet, eSELECT_READ );
+        }
+
+        ( void ) FreeRTOS_select( xTcpSocketSet, xSelectTimeout );
+
+        if( pxFreeSession != NULL )
+        {
+            prvAcceptTcpSession( xListeningSocket, pxFreeSession );
+        }
+
+        /* The operations do not block, so every session is served on every
+         * wake up. */
+        for( uxIndex = 0; uxIndex < cliserverTCP_MAX_SESSIONS; uxIndex++ )
+        {
+            if( xTcpSessions[ uxIndex ].ucState != cliserverSESSION_FREE )
+            {
+                prvServeTcpSession( &( xTcpSessions[ uxIndex ] ) );
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvAcceptTcpSession( Socket_t xListeningSocket,
+                                 CliTcpSession_t * pxSession )
+{
+    Socket_t xConnectedSocket;
+    socklen_t xClientAddressLength = sizeof( pxSession->xClientAddress );
+
+    xConnectedSocket = FreeRTOS_accept( xListeningSocket,
+                                        &( pxSession->xClientAddress ),
+                                        &( xClientAddressLength ) );
+
+    if( ( xConnectedSocket != NULL ) && ( xConnectedSocket != FREERTOS_INVALID_SOCKET ) )
+    {
+        configPRINTF( ( "TCP client connected. IP:%x Port:%u\n", pxSession->xClientAddress.sin_address.ulIP_IPv4,
+                                                                  pxSession->xClientAddress.sin_port ) );
+        xStats.ulTcpConnections++;
+
+        pxSession->xSocket = xConnectedSocket;
+        pxSession->ucState = cliserverSESSION_RECEIVING;
+        pxSession->ulReceived = 0;
+        prvWatchTcpSession( pxSession );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvServeTcpSession( CliTcpSession_t * pxSession )
+{
+    BaseType_t xComplete = pdFALSE;
+    BaseType_t xReceived;
+    uint8_t ucDiscard;
+
+    /* A session goes through as many states as it can without blocking.
+     * Requests are served till the client closes the connection. */
+    if( pxSession->ucState == cliserverSESSION_RECEIVING )
+    {
+        if( prvReceiveTcpRequest( pxSession, &( xComplete ) ) != pdPASS )
+        {
+            prvShutdownTcpSession( pxSession );
+        }
+        else if( ( xComplete == pdTRUE ) &&
+                 ( prvStartTcpResponse( pxSession ) != pdPASS ) )
+        {
+            prvShutdownTcpSession( pxSession );
+        }
+        else
+        {
+            /* Waiting for the rest of the request, or sending the response. */
+        }
+    }
+
+    if( ( pxSession->ucState == cliserverSESSION_SENDING ) &&
+        ( prvSendTcpResponse( pxSession ) != pdPASS ) )
+    {
+        prvShutdownTcpSession( pxSession );
+    }
+
+    if( pxSession->ucState == cliserverSESSION_CLOSING )
+    {
+        /* The peer has closed its side once FreeRTOS_recv returns an
+         * error. */
+        do
+        {
+            xReceived = FreeRTOS_recv( pxSession->xSocket, &( ucDiscard ), sizeof( ucDiscard ), FREERTOS_MSG_DONTWAIT );
+        } while( xReceived > 0 );
+
+        if( ( ( xReceived < 0 ) && ( xReceived != -pdFREERTOS_ERRNO_EWOULDBLOCK ) ) ||
+            ( ( xTaskGetTickCount() - pxSession->xWaitStartTick ) >= pdMS_TO_TICKS( cliserverTCP_SHUTDOWN_TIMEOUT_MS ) ) )
+        {
+            FreeRTOS_FD_CLR( pxSession->xSocket, xTcpSocketSet, eSELECT_ALL );
+            FreeRTOS_closesocket( pxSession->xSocket );
+            pxSession->ucState = cliserverSESSION_FREE;
+
+            configPRINTF( ( "TCP client disconnected.\n" ) );
+        }
+    }
+
+    if( pxSession->ucState != cliserverSESSION_FREE )
+    {
+        prvWatchTcpSession( pxSession );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReceiveTcpRequest( CliTcpSession_t * pxSession,
+                                        BaseType_t * pxComplete )
+{
+    BaseType_t xReturn = pdPASS;
+    BaseType_t xReceived;
+    const PacketHeaderV2_t * pxHeader = ( const PacketHeaderV2_t * ) &( pxSession->ucRequest[ 0 ] );
+    uint32_t ulExpected = PACKET_HEADER_V2_LENGTH;
+    uint16_t usPayloadLength;
+
+    *pxComplete = pdFALSE;
+
+    /* Requests are framed with the version 2 header, so the header tells the
+     * length of the command which follows. The request is received in as
+     * many pieces as it arrives in. */
+    while( ( xReturn == pdPASS ) && ( *pxComplete == pdFALSE ) )
+    {
+        if( pxSession->ulReceived >= PACKET_HEADER_V2_LENGTH )
+        {
+            usPayloadLength = FreeRTOS_ntohs( pxHeader->usPayloadLength );
+
+            if( ( pxHeader->ucStartMarker != PACKET_START_MARKER_V2 ) ||
+                ( usPayloadLength > configMAX_COMMAND_INPUT_SIZE ) )
+            {
+                configPRINTF( ( "[ERROR] Malformed TCP request header. IP:%x Port:%u\n", pxSession->xClientAddress.sin_address.ulIP_IPv4,
+                                                                                         pxSession->xClientAddress.sin_port ) );
+                xReturn = pdFAIL;
+                break;
+            }
+
+            ulExpected = PACKET_HEADER_V2_LENGTH + usPayloadLength;
+        }
+
+        if( pxSession->ulReceived == ulExpected )
+        {
+            *pxComplete = pdTRUE;
+        }
+        else
+        {
+            xReceived = FreeRTOS_recv( pxSession->xSocket,
+                                       &( pxSession->ucRequest[ pxSession->ulReceived ] ),
+                                       ulExpected - pxSession->ulReceived,
+                                       FREERTOS_MSG_DONTWAIT );
+
+            if( xReceived > 0 )
+            {
+                pxSession->ulReceived += ( uint32_t ) xReceived;
+            }
+            else if( ( xReceived == 0 ) || ( xReceived == -pdFREERTOS_ERRNO_EWOULDBLOCK ) )
+            {
+                /* The rest of the request has not arrived yet. */
+                break;
+            }
+            else
+            {
+                /* The connection is closed or broken. */
+                xReturn = pdFAIL;
+            }
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStartTcpResponse( CliTcpSession_t * pxSession )
+{
+    BaseType_t xReturn = pdFAIL;
+    CliTransfer_t * pxTransfer = &( pxSession->xTransfer );
+    CliRequest_t xRequest;
+
+    pxSession->ucRequest[ pxSession->ulReceived ] = '\0';
+
+    if( ( prvParseRequest( &( pxSession->ucRequest[ 0 ] ), pxSession->ulReceived, &( xRequest ) ) == pdTRUE ) &&
+        ( ( xRequest.ucType == PACKET_TYPE_REQUEST ) || ( xRequest.ucType == PACKET_TYPE_INVOKE ) ) )
+    {
+        configPRINTF( ( "Received TCP request. IP:%x Port:%u Type:%u \n", pxSession->xClientAddress.sin_address.ulIP_IPv4,
+                                                                          pxSession->xClientAddress.sin_port,
+                                                                          xRequest.ucType ) );
+
+        pxSession->xResponseStartTick = xTaskGetTickCount();
+        prvSetClassPriority( prvGetRequestClass( &( xRequest ), &( xTcpScratch.xArguments[ 0 ] ) ) );
+
+        /* TCP delivers the response reliably, so it is not cached. */
+        prvResetTransfer( pxTransfer );
+        memcpy( &( pxTransfer->xClientAddress ), &( pxSession->xClientAddress ), sizeof( struct freertos_sockaddr ) );
+        memcpy( &( pxTransfer->ucRequestId[ 0 ] ), &( xRequest.ucRequestId[ 0 ] ), 4 );
+        pxTransfer->xIsUdp = pdFALSE;
+        pxTransfer->pxScratch = &( xTcpScratch );
+        prvBuildTransfer( pxTransfer, &( xRequest ) );
+
+        prvSetClassPriority( CLI_CLASS_NORMAL );
+
+        /* A single header gives the length of the complete body. */
+        prvFillHeaderV2( &( pxSession->xStreamHeader ),
+                         PACKET_TYPE_STREAM,
+                         pxTransfer->ucFlags,
+                         &( pxTransfer->ucRequestId[ 0 ] ),
+                         0,
+                         pxTransfer->ulTotalLength,
+                         0 );
+
+        pxSession->ulSentLength = 0;
+        pxSession->xWaitStartTick = xTaskGetTickCount();
+        pxSession->ucState = cliserverSESSION_SENDING;
+        xReturn = pdPASS;
+    }
+    else
+    {
+        configPRINTF( ( "[ERROR] Malformed TCP request. IP:%x Port:%u\n", pxSession->xClientAddress.sin_address.ulIP_IPv4,
+                                                                          pxSession->xClientAddress.sin_port ) );
+    }
+
+    pxSession->ulReceived = 0;
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendTcpResponse( CliTcpSession_t * pxSession )
+{
+    BaseType_t xReturn = pdPASS;
+    BaseType_t xSent;
+    uint32_t ulStreamLength = PACKET_HEADER_V2_LENGTH + pxSession->xTransfer.ulTotalLength;
+    const uint8_t * pucData = NULL;
+    uint32_t ulLength = 0;
+
+    /* Copy as much of the response as fits in the TX buffer of the socket,
+     * the segments straight from their memory. The rest waits till select
+     * reports the socket writable again. */
+    while( pxSession->ulSentLength < ulStreamLength )
+    {
+        if( pxSession->ulSentLength < PACKET_HEADER_V2_LENGTH )
+        {
+            pucData = &( ( ( const uint8_t * ) &( pxSession->xStreamHeader ) )[ pxSession->ulSentLength ] );
+            ulLength = PACKET_HEADER_V2_LENGTH - pxSession->ulSentLength;
+        }
+        else if( prvGetTransferSpan( &( pxSession->xTransfer ),
+                                     pxSession->ulSentLength - PACKET_HEADER_V2_LENGTH,
+                                     &( pucData ),
+                                     &( ulLength ) ) != pdPASS )
+        {
+            xReturn = pdFAIL;
+            break;
+        }
+        else
+        {
+            /* The next span of the response. */
+        }
+
+        xSent = FreeRTOS_send( pxSession->xSocket, pucData, ulLength, FREERTOS_MSG_DONTWAIT );
+
+        if( xSent > 0 )
+        {
+            pxSession->ulSentLength += ( uint32_t ) xSent;
+            pxSession->xWaitStartTick = xTaskGetTickCount();
+        }
+        else if( ( xSent == 0 ) ||
+                 ( xSent == -pdFREERTOS_ERRNO_ENOSPC ) ||
+                 ( xSent == -pdFREERTOS_ERRNO_EWOULDBLOCK ) )
+        {
+            /* The TX buffer is full. */
+            if( ( xTaskGetTickCount() - pxSession->xWaitStartTick ) >= pdMS_TO_TICKS( cliserverTCP_SEND_TIMEOUT_MS ) )
+            {
+                configPRINTF( ( "[ERROR] The TCP client did not read its response for %u ms.\n", ( unsigned ) cliserverTCP_SEND_TIMEOUT_MS ) );
+                xReturn = pdFAIL;
+            }
+
+            break;
+        }
+        else
+        {
+            xReturn = pdFAIL;
+            break;
+        }
+    }
+
+    if( ( xReturn != pdPASS ) || ( pxSession->ulSentLength == ulStreamLength ) )
+    {
+        prvReleaseSegments( &( pxSession->xTransfer ) );
+    }
+
+    if( xReturn != pdPASS )
+    {
+        configPRINTF( ( "[ERROR] Failed to send TCP response. \n" ) );
+    }
+    else if( pxSession->ulSentLength == ulStreamLength )
+    {
+        prvUpdateThroughputStats( pxSession->xTransfer.ulTotalLength,
+                                  0,
+                                  0,
+                                  xTaskGetTickCount() - pxSession->xResponseStartTick );
+
+        pxSession->ucState = cliserverSESSION_RECEIVING;
+    }
+    else
+    {
+        /* Waiting for TX space. */
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvShutdownTcpSession( CliTcpSession_t * pxSession )
+{
+    /* Initiate a graceful shutdown, the socket is closed once the peer has
+     * closed its side too. */
+    FreeRTOS_shutdown( pxSession->xSocket, FREERTOS_SHUT_RDWR );
+    pxSession->ucState = cliserverSESSION_CLOSING;
+    pxSession->xWaitStartTick = xTaskGetTickCount();
+}
+/*-----------------------------------------------------------*/
+
+static void prvWatchTcpSession( const CliTcpSession_t * pxSession )
+{
+    /* A session sending a response waits for TX space, the others for data
+     * or for the peer to close. */
+    FreeRTOS_FD_CLR( pxSession->xSocket, xTcpSocketSet, eSELECT_ALL );
+
+    if( pxSession->ucState == cliserverSESSION_SENDING )
+    {
+        FreeRTOS_FD_SET( pxSession->xSocket, xTcpSocketSet, eSELECT_WRITE | eSELECT_EXCEPT );
+    }
+    else
+    {
+        FreeRTOS_FD_SET( pxSession->xSocket, xTcpSocketSet, eSELECT_READ | eSELECT_EXCEPT );
+    }
+}
+/*-----------------------------------------------------------*/
+
+#endif /* cliserverUSE_TCP */
@@ -0,0 +1,251 @@
+#ifndef CLI_SERVER_H
+#define CLI_SERVER_H
+
+/* Standard includes. */
+#include <stddef.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/*-----------------------------------------------------------*/
+
+/* Latency classes of the requests. A class decides the worker and the
+ * priority a request is served with. */
+#define CLI_CLASS_NORMAL        0
+#define CLI_CLASS_CRITICAL      1   /* Health checks, served by a reserved worker above the other CLI tasks. */
+#define CLI_CLASS_BULK          2   /* Long outputs and transfers, served below the other CLI tasks. */
+#define CLI_CLASS_COUNT         3
+
+/* Network buffers left to the rest of the IP stack. The response data is held
+ * back and the telemetry snapshots are skipped while fewer are free. */
+#define CLI_MIN_FREE_NETWORK_BUFFERS    ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 )
+
+typedef struct CliClassStats
+{
+    uint32_t ulRequests;            /* Requests of the class started by a worker. */
+    uint32_t ulBusyRejections;      /* Requests of the class rejected because all the workers were busy. */
+    uint32_t ulTotalQueueDelayMs;   /* Time from the dispatch to the start of the requests. */
+    uint32_t ulMaxQueueDelayMs;
+    uint32_t ulLastQueueDelayMs;
+} CliClassStats_t;
+
+typedef struct CliServerStats
+{
+    uint32_t ulResponses;           /* Number of responses sent. */
+    uint32_t ulTotalBytes;          /* Payload bytes sent in all the responses. */
+    uint32_t ulTotalTimeMs;         /* Time spent sending all the responses. */
+    uint32_t ulLastBytesPerSecond;  /* Throughput of the last response. */
+    uint32_t ulRetransmissions;     /* Data packets sent again because of a missing ACK or a RESEND request. */
+    uint32_t ulResendRequests;      /* Number of RESEND requests served. */
+    uint32_t ulTcpConnections;      /* Number of TCP connections accepted. */
+    uint32_t ulBusyRejections;      /* Requests rejected because all the workers were busy. */
+    uint32_t ulCacheHits;           /* Retried requests answered from the response cache. */
+    uint32_t ulCacheEvictions;      /* Retained responses evicted to make room for a new one. */
+    uint32_t ulDatagrams;           /* DATA packets sent over UDP, retransmissions included. */
+    uint32_t ulLastDatagrams;       /* DATA packets sent for the last UDP response. */
+    uint32_t ulLastPayloadSize;     /* Payload size negotiated for the last UDP response. */
+    uint32_t ulThrottleEvents;      /* DATA packets held back by the pacer. */
+    uint32_t ulThrottledTimeMs;     /* Time spent held back by the pacer. */
+    uint32_t ulDeferredSends;       /* Times a UDP packet was held back because the IP stack could not take it at once. */
+    uint32_t ulRateLimit;           /* Current rate limit in bytes per second, 0 if disabled. */
+    uint32_t ulCompressedRawBytes;  /* Response bytes sent in compressed DATA packets, before compression. */
+    uint32_t ulCompressedBytes;     /* Payload bytes of the compressed DATA packets. */
+    CliClassStats_t xClasses[ CLI_CLASS_COUNT ]; /* UDP requests by CLI_CLASS_*. */
+} CliServerStats_t;
+
+/*-----------------------------------------------------------*/
+
+/* Types of the payload returned by an opcode handler. */
+#define CLI_PAYLOAD_NONE        0
+#define CLI_PAYLOAD_TEXT        1   /* Written in the text buffer given to the handler. */
+#define CLI_PAYLOAD_MEMORY      2   /* A span of memory sent as it is. */
+
+/* Called once the response leaves the response cache, or before the handler
+ * which added the payload runs again, after which the memory may be reused.
+ * The payload cannot be sent again once released. */
+typedef void ( * CliReleaseHook_t )( void );
+
+typedef struct CliPayload
+{
+    uint8_t ucType;                 /* One of CLI_PAYLOAD_*. */
+    const uint8_t * pucData;        /* CLI_PAYLOAD_MEMORY only. */
+    uint32_t ulLength;
+    CliReleaseHook_t pxReleaseHook; /* CLI_PAYLOAD_MEMORY only, may be NULL. */
+} CliPayload_t;
+
+/* A TLV argument of an INVOKE request. The value is not NULL terminated. */
+typedef struct CliArgument
+{
+    uint8_t ucTag;                  /* One of CLI_TLV_*. */
+    uint16_t usLength;
+    const uint8_t * pucValue;
+} CliArgument_t;
+
+/**
+ * @brief Handler of an opcode.
+ *
+ * @param pxArguments Arguments of the request.
+ * @param uxArgumentCount Number of entries in pxArguments.
+ * @param pcTextBuffer Buffer to write a CLI_PAYLOAD_TEXT payload in.
+ * @param xTextBufferLength Size of pcTextBuffer.
+ * @param pxPayload Output parameter to describe the payload in.
+ *
+ * @return pdPASS if success, pdFAIL otherwise.
+ */
+typedef BaseType_t ( * CliOpcodeHandler_t )( const CliArgument_t * pxArguments,
+                                             UBaseType_t uxArgumentCount,
+                                             char * pcTextBuffer,
+                                             size_t xTextBufferLength,
+                                             CliPayload_t * pxPayload );
+
+/* The response an output handler appends to. */
+typedef struct CliOutput CliOutput_t;
+
+/**
+ * @brief Handler of an opcode building its response as a list of pieces.
+ *
+ * The response is made of text copied with xCliOutputAddText or
+ * pvCliOutputReserve, and of references to memory added with
+ * xCliOutputAddMemory, which are sent in order without being copied.
+ *
+ * @param pxArguments Arguments of the request.
+ * @param uxArgumentCount Number of entries in pxArguments.
+ * @param pxOutput The response to append to.
+ *
+ * @return pdPASS if success, pdFAIL otherwise.
+ */
+typedef BaseType_t ( * CliOutputHandler_t )( const CliArgument_t * pxArguments,
+                                             UBaseType_t uxArgumentCount,
+                                             CliOutput_t * pxOutput );
+
+typedef struct CliOpcodeDefinition
+{
+    uint16_t usOpcode;              /* One of CLI_OPCODE_*. */
+    const char * pcAlias;           /* Text command served by this opcode, for example "pcap get". May be NULL. */
+    CliOpcodeHandler_t pxHandler;   /* NULL to use pxOutputHandler. */
+    uint8_t ucClass;                /* One of CLI_CLASS_*. */
+    CliOutputHandler_t pxOutputHandler; /* Called when pxHandler is NULL, NULL otherwise. */
+} CliOpcodeDefinition_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Create the tasks serving FreeRTOS+CLI commands over UDP and TCP on
+ * configCLI_SERVER_PORT.
+ *
+ * UDP requests are received by a dispatcher task running at uxPriority + 3
+ * and served by a pool of worker tasks. One of the workers is reserved for
+ * the CLI_CLASS_CRITICAL requests. A worker serves a request at:
+ * - uxPriority + 2 for a CLI_CLASS_CRITICAL request.
+ * - uxPriority + 1 for a CLI_CLASS_NORMAL request.
+ * - uxPriority for a CLI_CLASS_BULK request.
+ * TCP requests are served the same way by a single task. The classes only
+ * order the CLI tasks among themselves, so uxPriority + 2 should be above the
+ * tasks which would otherwise delay the health checks.
+ *
+ * Must be called after the network is up.
+ *
+ * @param usStackSize Stack size for each of the CLI server tasks.
+ * @param uxPriority Lowest priority of the CLI server tasks.
+ *
+ * @return pdPASS if success, pdFAIL otherwise.
+ */
+BaseType_t xCliServerInitialize( uint16_t usStackSize,
+                                 UBaseType_t uxPriority );
+
+/**
+ * @brief Register the handler of an opcode.
+ *
+ * Must be called before xCliServerInitialize. The definition is referenced,
+ * not copied.
+ *
+ * @param pxDefinition The opcode to register.
+ *
+ * @return pdPASS if success, pdFAIL if the opcode table is full.
+ */
+BaseType_t xCliServerRegisterOpcode( const CliOpcodeDefinition_t * pxDefinition );
+
+/**
+ * @brief Set the latency class of a FreeRTOS+CLI command.
+ *
+ * Commands are CLI_CLASS_NORMAL unless set otherwise, and the commands served
+ * by an opcode take the class of the opcode definition. Discovery probes are
+ * CLI_CLASS_CRITICAL.
+ *
+ * Must be called before xCliServerInitialize. The command is referenced, not
+ * copied.
+ *
+ * @param pcCommand The command, without parameters, for example "ping".
+ * @param ucClass One of CLI_CLASS_*.
+ *
+ * @return pdPASS if success, pdFAIL if the class table is full.
+ */
+BaseType_t xCliServerSetCommandClass( const char * pcCommand,
+                                      uint8_t ucClass );
+
+/**
+ * @brief Set the rate limit of the response data sent over UDP.
+ *
+ * Bulk responses are paced with a token bucket so that they do not exhaust
+ * the network buffers. Independently of the rate, a DATA packet is held back
+ * while only a few network buffers are free.
+ *
+ * @param ulBytesPerSecond The rate limit, 0 to disable it.
+ */
+void vCliServerSetRateLimit( uint32_t ulBytesPerSecond );
+
+/**
+ * @brief Obtain the transport statistics of the CLI server.
+ *
+ * @param pxStats Output parameter to return the statistics in.
+ */
+void vCliServerGetStats( CliServerStats_t * pxStats );
+
+/**
+ * @brief Append a copy of a text to the response of an output handler.
+ *
+ * @param pxOutput The response, as given to the handler.
+ * @param pcText The NULL terminated text, the NULL is not sent.
+ *
+ * @return pdPASS if success, pdFAIL if the response is truncated.
+ */
+BaseType_t xCliOutputAddText( CliOutput_t * pxOutput,
+                              const char * pcText );
+
+/**
+ * @brief Append uninitialised bytes to the response of an output handler.
+ *
+ * The bytes are in the text buffer of the response, for a handler to build a
+ * binary structure in place.
+ *
+ * @param pxOutput The response, as given to the handler.
+ * @param uxLength Number of bytes to append.
+ *
+ * @return The bytes to fill, NULL if the response is truncated.
+ */
+void * pvCliOutputReserve( CliOutput_t * pxOutput,
+                           size_t uxLength );
+
+/**
+ * @brief Append a reference to memory to the response of an output handler.
+ *
+ * The memory is sent as it is, without being copied, so it must stay valid
+ * until pxReleaseHook is called. Without a release hook, it must stay valid
+ * as long as the response may be sent again.
+ *
+ * @param pxOutput The response, as given to the handler.
+ * @param pucData The memory to send.
+ * @param ulLength Number of bytes of pucData.
+ * @param pxReleaseHook Called once the response is not retained anymore, or
+ * at once if the memory cannot be added to the response. May be NULL.
+ *
+ * @return pdPASS if success, pdFAIL if the response is truncated.
+ */
+BaseType_t xCliOutputAddMemory( CliOutput_t * pxOutput,
+                                const uint8_t * pucData,
+                                uint32_t ulLength,
+                                CliReleaseHook_t pxReleaseHook );
+
+/*-----------------------------------------------------------*/
+
+#endif /* CLI_SERVER_H */
@@ -0,0 +1,468 @@
+/* Standard includes. */
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "NetworkBufferManagement.h"
+
+/* Netstat includes. */
+#include "netstat_capture.h"
+
+/* CLI server includes. */
+#include "cli_protocol.h"
+#include "cli_server.h"
+#include "cli_telemetry.h"
+
+/*-----------------------------------------------------------*/
+
+/* Maximum number of clients subscribed at the same time. */
+#define telemetryMAX_SUBSCRIPTIONS      4
+
+/* A snapshot fits in one frame of the endpoint MTU. */
+#define telemetryMAX_PAYLOAD_SIZE       ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER - ipSIZE_OF_UDP_HEADER - PACKET_HEADER_V2_LENGTH )
+
+/* Must be at least the number of tasks in the system for
+ * uxTaskGetSystemState to succeed. */
+#define telemetryMAX_TASKS              24
+
+/*-----------------------------------------------------------*/
+
+typedef struct TelemetrySubscription
+{
+    BaseType_t xActive;
+    Socket_t xSocket;
+    struct freertos_sockaddr xAddress;
+    uint8_t ucRequestId[ 4 ];
+    uint8_t ucStreams;
+    TickType_t xInterval;
+    TickType_t xLastSent;
+    TickType_t xLeaseStart;
+    TickType_t xLease;
+    uint32_t ulSequence;
+} TelemetrySubscription_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvTelemetryTask( void * pvParameters );
+
+static TickType_t prvServeSubscriptions( void );
+
+static size_t prvBuildSnapshot( uint8_t ucStreams,
+                                uint8_t * pucPayload );
+
+static size_t prvAddNetstat( uint8_t * pucRecord,
+                             size_t uxSpace );
+
+static size_t prvAddTasks( uint8_t * pucRecord,
+                           size_t uxSpace );
+
+static size_t prvAddHeap( uint8_t * pucRecord,
+                          size_t uxSpace );
+
+static void prvFillProtocol( TelemetryProtocol_t * pxWire,
+                             const ProtocolStats_t * pxStats );
+
+static BaseType_t prvIsSubscriber( const TelemetrySubscription_t * pxSubscription,
+                                   const struct freertos_sockaddr * pxAddress );
+
+/*-----------------------------------------------------------*/
+
+/* Written by the CLI server workers and read by the telemetry task, only
+ * accessed in a critical section. */
+static TelemetrySubscription_t xSubscriptions[ telemetryMAX_SUBSCRIPTIONS ];
+
+static TaskHandle_t xTelemetryTask = NULL;
+
+/* Used by the telemetry task only. */
+static uint8_t ucPacket[ PACKET_HEADER_V2_LENGTH + telemetryMAX_PAYLOAD_SIZE ];
+static TaskStatus_t xTaskStatus[ telemetryMAX_TASKS ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliTelemetryInitialize( uint16_t usStackSize,
+                                    UBaseType_t uxPriority )
+{
+    return xTaskCreate( prvTelemetryTask,
+                        "cli-tlm",
+                        usStackSize,
+                        NULL,
+                        uxPriority,
+                        &( xTelemetryTask ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliTelemetrySubscribe( Socket_t xSocket,
+                                   const struct freertos_sockaddr * pxAddress,
+                                   const uint8_t * pucRequestId,
+                                   uint8_t ucStreams,
+                                   uint32_t ulIntervalMs,
+                                   uint32_t ulLeaseMs )
+{
+    BaseType_t xReturn = pdFAIL;
+    TelemetrySubscription_t * pxSubscription = NULL;
+    UBaseType_t uxIndex;
+
+    if( ulLeaseMs == 0U )
+    {
+        ulLeaseMs = CLI_TELEMETRY_DEFAULT_LEASE_MS;
+    }
+
+    if( ( ( ucStreams & CLI_STREAM_ALL ) != 0U ) &&
+        ( ( ucStreams & ~CLI_STREAM_ALL ) == 0U ) &&
+        ( ulIntervalMs >= CLI_TELEMETRY_MIN_INTERVAL_MS ) &&
+        ( ulLeaseMs <= CLI_TELEMETRY_MAX_LEASE_MS ) )
+    {
+        taskENTER_CRITICAL();
+        {
+            /* Renew the subscription of the client, if any, or take a free
+             * one. */
+            for( uxIndex = 0; uxIndex < telemetryMAX_SUBSCRIPTIONS; uxIndex++ )
+            {
+                if( prvIsSubscriber( &( xSubscriptions[ uxIndex ] ), pxAddress ) == pdTRUE )
+                {
+                    pxSubscription = &( xSubscriptions[ uxIndex ] );
+                    break;
+                }
+                else if( ( xSubscriptions[ uxIndex ].xActive == pdFALSE ) && ( pxSubscription == NULL ) )
+                {
+                    pxSubscription = &( xSubscriptions[ uxIndex ] );
+                }
+                else
+                {
+                    /* Taken by another client. */
+                }
+            }
+
+            if( pxSubscription != NULL )
+            {
+                if( pxSubscription->xActive == pdFALSE )
+                {
+                    pxSubscription->ulSequence = 0;
+                }
+
+                pxSubscription->xSocket = xSocket;
+                memcpy( &( pxSubscription->xAddress ), pxAddress, sizeof( struct freertos_sockaddr ) );
+                memcpy( &( pxSubscription->ucRequestId[ 0 ] ), pucRequestId, sizeof( pxSubscription->ucRequestId ) );
+                pxSubscription->ucStreams = ucStreams;
+                pxSubscription->xInterval = pdMS_TO_TICKS( ulIntervalMs );
+                pxSubscription->xLeaseStart = xTaskGetTickCount();
+                pxSubscription->xLease = pdMS_TO_TICKS( ulLeaseMs );
+
+                /* The first snapshot is sent right away. */
+                pxSubscription->xLastSent = pxSubscription->xLeaseStart - pxSubscription->xInterval;
+                pxSubscription->xActive = pdTRUE;
+                xReturn = pdPASS;
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    if( xReturn == pdPASS )
+    {
+        ( void ) xTaskNotifyGive( xTelemetryTask );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliTelemetryUnsubscribe( const struct freertos_sockaddr * pxAddress )
+{
+    BaseType_t xReturn = pdFAIL;
+    UBaseType_t uxIndex;
+
+    taskENTER_CRITICAL();
+    {
+        for( uxIndex = 0; uxIndex < telemetryMAX_SUBSCRIPTIONS; uxIndex++ )
+        {
+            if( prvIsSubscriber( &( xSubscriptions[ uxIndex ] ), pxAddress ) == pdTRUE )
+            {
+                xSubscriptions[ uxIndex ].xActive = pdFALSE;
+                xReturn = pdPASS;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCliTelemetryFillNetstat( TelemetryNetstat_t * pxWire )
+{
+    NetworkStats_t xStats;
+    BaseType_t xReturn = pdFAIL;
+
+    if( Netstat_GetStats( &( xStats ) ) == NETSTAT_RESULT_OK )
+    {
+        prvFillProtocol( &( pxWire->xTcp ), &( xStats.tcp ) );
+        prvFillProtocol( &( pxWire->xUdp ), &( xStats.udp ) );
+        prvFillProtocol( &( pxWire->xIcmp ), &( xStats.icmp ) );
+        pxWire->ulRxLatencyHigh = FreeRTOS_htonl( ( uint32_t ) ( ( xStats.rxLatency >> 32 ) & 0xFFFFFFFFU ) );
+        pxWire->ulRxLatencyLow = FreeRTOS_htonl( ( uint32_t ) ( xStats.rxLatency & 0xFFFFFFFFU ) );
+        pxWire->ulTxLatencyHigh = FreeRTOS_htonl( ( uint32_t ) ( ( xStats.txLatency >> 32 ) & 0xFFFFFFFFU ) );
+        pxWire->ulTxLatencyLow = FreeRTOS_htonl( ( uint32_t ) ( xStats.txLatency & 0xFFFFFFFFU ) );
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxCliTelemetryFillTasks( TelemetryTask_t * pxWire,
+                                     UBaseType_t uxMaxEntries,
+                                     TaskStatus_t * pxTaskStatus,
+                                     UBaseType_t uxTaskStatusCount )
+{
+    UBaseType_t uxTaskCount, uxIndex;
+
+    /* Returns 0 if there are more than uxTaskStatusCount tasks. */
+    uxTaskCount = uxTaskGetSystemState( pxTaskStatus, uxTaskStatusCount, NULL );
+
+    if( uxTaskCount > uxMaxEntries )
+    {
+        uxTaskCount = uxMaxEntries;
+    }
+
+    for( uxIndex = 0; uxIndex < uxTaskCount; uxIndex++ )
+    {
+        memset( &( pxWire[ uxIndex ] ), 0, sizeof( TelemetryTask_t ) );
+        pxWire[ uxIndex ].ucNumber = ( uint8_t ) pxTaskStatus[ uxIndex ].xTaskNumber;
+        pxWire[ uxIndex ].ucState = ( uint8_t ) pxTaskStatus[ uxIndex ].eCurrentState;
+        pxWire[ uxIndex ].ucPriority = ( uint8_t ) pxTaskStatus[ uxIndex ].uxCurrentPriority;
+        pxWire[ uxIndex ].ulRunTimeCounter = FreeRTOS_htonl( ( uint32_t ) pxTaskStatus[ uxIndex ].ulRunTimeCounter );
+        pxWire[ uxIndex ].ulStackHighWaterMark = FreeRTOS_htonl( ( uint32_t ) pxTaskStatus[ uxIndex ].usStackHighWaterMark );
+        strncpy( &( pxWire[ uxIndex ].cName[ 0 ] ), pxTaskStatus[ uxIndex ].pcTaskName, TELEMETRY_TASK_NAME_LENGTH );
+    }
+
+    return uxTaskCount;
+}
+/*-----------------------------------------------------------*/
+
+void vCliTelemetryFillHeap( TelemetryHeap_t * pxWire )
+{
+    pxWire->ulFreeBytes = FreeRTOS_htonl( ( uint32_t ) xPortGetFreeHeapSize() );
+    pxWire->ulMinimumEverFreeBytes = FreeRTOS_htonl( ( uint32_t ) xPortGetMinimumEverFreeHeapSize() );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTelemetryTask( void * pvParameters )
+{
+    TickType_t xWait;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* Sleep till the next snapshot is due or a subscription changes. */
+        xWait = prvServeSubscriptions();
+        ( void ) ulTaskNotifyTake( pdTRUE, xWait );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvServeSubscriptions( void )
+{
+    TelemetrySubscription_t xSubscription;
+    PacketHeaderV2_t * pxHeader = ( PacketHeaderV2_t * ) &( ucPacket[ 0 ] );
+    TickType_t xWait = portMAX_DELAY, xNow, xElapsed, xLeaseLeft;
+    UBaseType_t uxIndex;
+    size_t uxPayloadLength;
+    BaseType_t xDue;
+
+    for( uxIndex = 0; uxIndex < telemetryMAX_SUBSCRIPTIONS; uxIndex++ )
+    {
+        xDue = pdFALSE;
+        xNow = xTaskGetTickCount();
+
+        taskENTER_CRITICAL();
+        {
+            if( xSubscriptions[ uxIndex ].xActive == pdTRUE )
+            {
+                if( ( xNow - xSubscriptions[ uxIndex ].xLeaseStart ) >= xSubscriptions[ uxIndex ].xLease )
+                {
+                    xSubscriptions[ uxIndex ].xActive = pdFALSE;
+                }
+                else if( ( xNow - xSubscriptions[ uxIndex ].xLastSent ) >= xSubscriptions[ uxIndex ].xInterval )
+                {
+                    xSubscriptions[ uxIndex ].xLastSent = xNow;
+                    xSubscriptions[ uxIndex ].ulSequence++;
+                    memcpy( &( xSubscription ), &( xSubscriptions[ uxIndex ] ), sizeof( xSubscription ) );
+                    xDue = pdTRUE;
+                }
+                else
+                {
+                    /* Not due yet. */
+                }
+
+                if( xSubscriptions[ uxIndex ].xActive == pdTRUE )
+                {
+                    xElapsed = xNow - xSubscriptions[ uxIndex ].xLastSent;
+
+                    if( ( xSubscriptions[ uxIndex ].xInterval - xElapsed ) < xWait )
+                    {
+                        xWait = xSubscriptions[ uxIndex ].xInterval - xElapsed;
+                    }
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        /* A snapshot is only sent while the IP stack has network buffers to
+         * spare. FreeRTOS_sendto takes one without blocking, and a failed
+         * allocation asserts on the board. */
+        if( ( xDue == pdTRUE ) &&
+            ( uxGetNumberOfFreeNetworkBuffers() >= CLI_MIN_FREE_NETWORK_BUFFERS ) )
+        {
+            uxPayloadLength = prvBuildSnapshot( xSubscription.ucStreams, &( ucPacket[ PACKET_HEADER_V2_LENGTH ] ) );
+            xLeaseLeft = xSubscription.xLease - ( xNow - xSubscription.xLeaseStart );
+
+            memset( pxHeader, 0, PACKET_HEADER_V2_LENGTH );
+            pxHeader->ucStartMarker = PACKET_START_MARKER_V2;
+            pxHeader->ucVersion = PACKET_VERSION_2;
+            pxHeader->ucType = PACKET_TYPE_TELEMETRY;
+            memcpy( &( pxHeader->ucRequestId[ 0 ] ), &( xSubscription.ucRequestId[ 0 ] ), sizeof( pxHeader->ucRequestId ) );
+            pxHeader->ulOffset = FreeRTOS_htonl( xSubscription.ulSequence );
+            pxHeader->ulLength = FreeRTOS_htonl( ( uint32_t ) ( xLeaseLeft * portTICK_PERIOD_MS ) );
+            pxHeader->usPayloadLength = FreeRTOS_htons( ( uint16_t ) uxPayloadLength );
+            pxHeader->usWindow = FreeRTOS_htons( ( uint16_t ) xSubscription.ucStreams );
+
+            /* A lost or skipped snapshot is not sent again, the next one
+             * supersedes it. */
+            ( void ) FreeRTOS_sendto( xSubscription.xSocket,
+                                      &( ucPacket[ 0 ] ),
+                                      PACKET_HEADER_V2_LENGTH + uxPayloadLength,
+                                      FREERTOS_MSG_DONTWAIT,
+                                      &( xSubscription.xAddress ),
+                                      sizeof( xSubscription.xAddress ) );
+        }
+    }
+
+    return xWait;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvBuildSnapshot( uint8_t ucStreams,
+                                uint8_t * pucPayload )
+{
+    size_t uxLength = 0;
+
+    if( ( ucStreams & CLI_STREAM_NETSTAT ) != 0U )
+    {
+        uxLength += prvAddNetstat( &( pucPayload[ uxLength ] ), telemetryMAX_PAYLOAD_SIZE - uxLength );
+    }
+
+    if( ( ucStreams & CLI_STREAM_HEAP ) != 0U )
+    {
+        uxLength += prvAddHeap( &( pucPayload[ uxLength ] ), telemetryMAX_PAYLOAD_SIZE - uxLength );
+    }
+
+    /* The task list goes last as it takes whatever space is left. */
+    if( ( ucStreams & CLI_STREAM_TASKS ) != 0U )
+    {
+        uxLength += prvAddTasks( &( pucPayload[ uxLength ] ), telemetryMAX_PAYLOAD_SIZE - uxLength );
+    }
+
+    return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvAddNetstat( uint8_t * pucRecord,
+                             size_t uxSpace )
+{
+    TelemetryRecordHeader_t * pxRecord = ( TelemetryRecordHeader_t * ) pucRecord;
+    TelemetryNetstat_t * pxWire = ( TelemetryNetstat_t * ) &( pucRecord[ sizeof( TelemetryRecordHeader_t ) ] );
+    size_t uxLength = 0;
+
+    if( ( uxSpace >= ( sizeof( TelemetryRecordHeader_t ) + sizeof( TelemetryNetstat_t ) ) ) &&
+        ( xCliTelemetryFillNetstat( pxWire ) == pdPASS ) )
+    {
+        pxRecord->ucStream = CLI_STREAM_NETSTAT;
+        pxRecord->ucCount = 1;
+        pxRecord->usLength = FreeRTOS_htons( ( uint16_t ) sizeof( TelemetryNetstat_t ) );
+        uxLength = sizeof( TelemetryRecordHeader_t ) + sizeof( TelemetryNetstat_t );
+    }
+
+    return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvAddTasks( uint8_t * pucRecord,
+                           size_t uxSpace )
+{
+    TelemetryRecordHeader_t * pxRecord = ( TelemetryRecordHeader_t * ) pucRecord;
+    TelemetryTask_t * pxWire = ( TelemetryTask_t * ) &( pucRecord[ sizeof( TelemetryRecordHeader_t ) ] );
+    UBaseType_t uxTaskCount;
+    size_t uxLength = 0;
+
+    if( uxSpace >= sizeof( TelemetryRecordHeader_t ) )
+    {
+        uxTaskCount = uxCliTelemetryFillTasks( pxWire,
+                                               ( uxSpace - sizeof( TelemetryRecordHeader_t ) ) / sizeof( TelemetryTask_t ),
+                                               &( xTaskStatus[ 0 ] ),
+                                               telemetryMAX_TASKS );
+
+        pxRecord->ucStream = CLI_STREAM_TASKS;
+        pxRecord->ucCount = ( uint8_t ) uxTaskCount;
+        pxRecord->usLength = FreeRTOS_htons( ( uint16_t ) ( uxTaskCount * sizeof( TelemetryTask_t ) ) );
+        uxLength = sizeof( TelemetryRecordHeader_t ) + ( uxTaskCount * sizeof( TelemetryTask_t ) );
+    }
+
+    return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvAddHeap( uint8_t * pucRecord,
+                          size_t uxSpace )
+{
+    TelemetryRecordHeader_t * pxRecord = ( TelemetryRecordHeader_t * ) pucRecord;
+    TelemetryHeap_t * pxWire = ( TelemetryHeap_t * ) &( pucRecord[ sizeof( TelemetryRecordHeader_t ) ] );
+    size_t uxLength = 0;
+
+    if( uxSpace >= ( sizeof( TelemetryRecordHeader_t ) + sizeof( TelemetryHeap_t ) ) )
+    {
+        vCliTelemetryFillHeap( pxWire );
+
+        pxRecord->ucStream = CLI_STREAM_HEAP;
+        pxRecord->ucCount = 1;
+        pxRecord->usLength = FreeRTOS_htons( ( uint16_t ) sizeof( TelemetryHeap_t ) );
+        uxLength = sizeof( TelemetryRecordHeader_t ) + sizeof( TelemetryHeap_t );
+    }
+
+    return uxLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillProtocol( TelemetryProtocol_t * pxWire,
+                             const ProtocolStats_t * pxStats )
+{
+    pxWire->ulRxPackets = FreeRTOS_htonl( pxStats->rxPackets );
+    pxWire->ulTxPackets = FreeRTOS_htonl( pxStats->txPackets );
+    pxWire->ulRxBytes = FreeRTOS_htonl( pxStats->rxBytes );
+    pxWire->ulTxBytes = FreeRTOS_htonl( pxStats->txBytes );
+    pxWire->ulRxDropped = FreeRTOS_htonl( pxStats->rxDropped );
+    pxWire->ulTxDropped = FreeRTOS_htonl( pxStats->txDropped );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsSubscriber( const TelemetrySubscription_t * pxSubscription,
+                                   const struct freertos_sockaddr * pxAddress )
+{
+    BaseType_t xReturn = pdFALSE;
+
+    if( ( pxSubscription->xActive == pdTRUE ) &&
+        ( pxSubscription->xAddress.sin_address.ulIP_IPv4 == pxAddress->sin_address.ulIP_IPv4 ) &&
+        ( pxSubscription->xAddress.sin_port == pxAddress->sin_port ) )
+    {
+        xReturn = pdTRUE;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
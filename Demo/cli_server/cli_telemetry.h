@@ -0,0 +1,120 @@
+#ifndef CLI_TELEMETRY_H
+#define CLI_TELEMETRY_H
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* CLI server includes. */
+#include "cli_protocol.h"
+
+/*
+ * Telemetry subscriptions of the CLI server.
+ *
+ * A client subscribes to a set of CLI_STREAM_* streams and then receives a
+ * PACKET_TYPE_TELEMETRY packet with a binary snapshot of these streams at
+ * the requested interval, without sending further requests. The packets are
+ * described in cli_protocol.h.
+ *
+ * A subscription lasts for a lease and the client renews it by subscribing
+ * again before it expires. There is at most one subscription per client
+ * address and port.
+ */
+
+/*-----------------------------------------------------------*/
+
+/* Lease of a subscription which does not give one. */
+#define CLI_TELEMETRY_DEFAULT_LEASE_MS      30000U
+
+/* Longest lease a client can get. */
+#define CLI_TELEMETRY_MAX_LEASE_MS          600000U
+
+/* Shortest interval between two snapshots. */
+#define CLI_TELEMETRY_MIN_INTERVAL_MS       10U
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Create the task sending the telemetry snapshots.
+ *
+ * @param usStackSize Stack size of the task.
+ * @param uxPriority Priority of the task.
+ *
+ * @return pdPASS if success, pdFAIL otherwise.
+ */
+BaseType_t xCliTelemetryInitialize( uint16_t usStackSize,
+                                    UBaseType_t uxPriority );
+
+/**
+ * @brief Subscribe a client to telemetry streams, or renew its subscription.
+ *
+ * @param xSocket The UDP socket to send the snapshots from.
+ * @param pxAddress Address and port of the client.
+ * @param pucRequestId Request ID echoed in the telemetry packets.
+ * @param ucStreams Bitwise OR of CLI_STREAM_*.
+ * @param ulIntervalMs Interval between two snapshots.
+ * @param ulLeaseMs Time after which the subscription expires, 0 for
+ * CLI_TELEMETRY_DEFAULT_LEASE_MS.
+ *
+ * @return pdPASS if success, pdFAIL if the parameters are invalid or all the
+ * subscriptions are taken.
+ */
+BaseType_t xCliTelemetrySubscribe( Socket_t xSocket,
+                                   const struct freertos_sockaddr * pxAddress,
+                                   const uint8_t * pucRequestId,
+                                   uint8_t ucStreams,
+                                   uint32_t ulIntervalMs,
+                                   uint32_t ulLeaseMs );
+
+/**
+ * @brief Cancel the subscription of a client.
+ *
+ * @param pxAddress Address and port of the client.
+ *
+ * @return pdPASS if the client was subscribed, pdFAIL otherwise.
+ */
+BaseType_t xCliTelemetryUnsubscribe( const struct freertos_sockaddr * pxAddress );
+
+/**
+ * @brief Fill a TelemetryNetstat_t with the current network statistics.
+ *
+ * @param pxWire The record to fill.
+ *
+ * @return pdPASS if success, pdFAIL if the statistics are not available.
+ */
+BaseType_t xCliTelemetryFillNetstat( TelemetryNetstat_t * pxWire );
+
+/**
+ * @brief Fill TelemetryTask_t records with the state of the tasks.
+ *
+ * @param pxWire The records to fill.
+ * @param uxMaxEntries Number of entries in pxWire.
+ * @param pxTaskStatus Buffer for uxTaskGetSystemState.
+ * @param uxTaskStatusCount Number of entries in pxTaskStatus, at least the
+ * number of tasks in the system.
+ *
+ * @return The number of records filled, 0 if there are more tasks than
+ * uxTaskStatusCount.
+ */
+UBaseType_t uxCliTelemetryFillTasks( TelemetryTask_t * pxWire,
+                                     UBaseType_t uxMaxEntries,
+                                     TaskStatus_t * pxTaskStatus,
+                                     UBaseType_t uxTaskStatusCount );
+
+/**
+ * @brief Fill a TelemetryHeap_t with the current heap usage.
+ *
+ * @param pxWire The record to fill.
+ */
+void vCliTelemetryFillHeap( TelemetryHeap_t * pxWire );
+
+/*-----------------------------------------------------------*/
+
+#endif /* CLI_TELEMETRY_H */
@@ -0,0 +1,105 @@
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+
+/* Exception info. */
+#include "expinfo.h"
+
+/* CLI server includes. */
+#include "cli_protocol.h"
+#include "cli_server.h"
+#include "cli_telemetry.h"
+
+/*-----------------------------------------------------------*/
+
+/* Buffer of uxTaskGetSystemState, only used under the interpreter mutex of
+ * the CLI server. */
+static TaskStatus_t xBundleTaskStatus[ HEALTH_BUNDLE_MAX_TASKS ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Handler of the CLI_OPCODE_BUNDLE_GET opcode.
+ *
+ * Fills a HealthBundle_t in place in the response.
+ */
+static BaseType_t prvBundleGetOpcodeHandler( const CliArgument_t * pxArguments,
+                                             UBaseType_t uxArgumentCount,
+                                             CliOutput_t * pxOutput )
+{
+    HealthBundle_t * pxBundle = ( HealthBundle_t * ) pvCliOutputReserve( pxOutput, sizeof( HealthBundle_t ) );
+    UBaseType_t uxTaskCount = 0;
+    BaseType_t xReturn = pdFAIL;
+
+    ( void ) pxArguments;
+    ( void ) uxArgumentCount;
+
+    if( pxBundle != NULL )
+    {
+        memset( pxBundle, 0, sizeof( HealthBundle_t ) );
+        pxBundle->ucVersion = HEALTH_BUNDLE_VERSION;
+        pxBundle->ulUptimeMs = FreeRTOS_htonl( ( uint32_t ) ( xTaskGetTickCount() * portTICK_PERIOD_MS ) );
+
+        if( ExpInfo_InfoExist() == pdTRUE )
+        {
+            pxBundle->ucFlags |= HEALTH_BUNDLE_FLAG_COREDUMP;
+        }
+
+        if( xCliTelemetryFillNetstat( &( pxBundle->xNetstat ) ) == pdPASS )
+        {
+            pxBundle->ucFlags |= HEALTH_BUNDLE_FLAG_NETSTAT;
+        }
+
+        vCliTelemetryFillHeap( &( pxBundle->xHeap ) );
+
+        if( uxTaskGetNumberOfTasks() <= HEALTH_BUNDLE_MAX_TASKS )
+        {
+            uxTaskCount = uxCliTelemetryFillTasks( &( pxBundle->xTasks[ 0 ] ),
+                                                   HEALTH_BUNDLE_MAX_TASKS,
+                                                   &( xBundleTaskStatus[ 0 ] ),
+                                                   HEALTH_BUNDLE_MAX_TASKS );
+        }
+
+        /* A task created between the two calls also makes
+         * uxTaskGetSystemState fail. */
+        if( uxTaskCount == 0U )
+        {
+            pxBundle->ucFlags |= HEALTH_BUNDLE_FLAG_TASKS_TRUNCATED;
+        }
+
+        pxBundle->ucTaskCount = ( uint8_t ) uxTaskCount;
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Structure that defines the opcode serving "bundle".
+ */
+static const CliOpcodeDefinition_t xBundleGetOpcode =
+{
+    CLI_OPCODE_BUNDLE_GET,
+    "bundle",
+    NULL,
+    CLI_CLASS_CRITICAL,
+    prvBundleGetOpcodeHandler
+};
+
+/*-----------------------------------------------------------*/
+
+void vRegisterBundleCommand( void )
+{
+    ( void ) xCliServerRegisterOpcode( &( xBundleGetOpcode ) );
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,70 @@
+/* Generated by cli_command_table.py from the command definitions of
+ * this directory, do not edit. */
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/* FreeRTOS+CLI includes. */
+#include "FreeRTOS_CLI.h"
+
+#if ( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+
+extern const CLI_Command_Definition_t xCliStatsCommand; /* "cli-stats", cli_stats_command.c */
+extern const CLI_Command_Definition_t xExceptionCommand; /* "coredump", exception_command.c */
+extern const CLI_Command_Definition_t xFirewallAddCommand; /* "firewall-add", firewall_command.c */
+extern const CLI_Command_Definition_t xFirewallListCommand; /* "firewall-list", firewall_command.c */
+extern const CLI_Command_Definition_t xFirewallRemoveRuleCommand; /* "firewall-remove", firewall_command.c */
+extern const CLI_Command_Definition_t xNetStatCommand; /* "netstat", netstat_command.c */
+extern const CLI_Command_Definition_t xPcapCommand; /* "pcap", pcap_commands.c */
+extern const CLI_Command_Definition_t xPingCommand; /* "ping", ping_command.c */
+extern const CLI_Command_Definition_t xTopCommand; /* "top", top_command.c */
+extern const CLI_Command_Definition_t xTraceCommand; /* "trace", trace_commands.c */
+
+/*-----------------------------------------------------------*/
+
+static const CLI_Command_Definition_t * const pxStaticCommands[] =
+{
+    &( xCliStatsCommand ),
+    &( xExceptionCommand ),
+    &( xFirewallAddCommand ),
+    &( xFirewallListCommand ),
+    &( xFirewallRemoveRuleCommand ),
+    &( xNetStatCommand ),
+    &( xPcapCommand ),
+    &( xPingCommand ),
+    &( xTopCommand ),
+    &( xTraceCommand ),
+};
+
+/* One more than the index in pxStaticCommands of the command hashing to
+ * each slot, 0 if none. */
+static const uint8_t ucStaticCommandSlots[ 32 ] =
+{
+     0,  0,  0,  2,  0,  5,  0,  0,  0,  4,  0,  6,  3,  0,  0,  0,
+     0,  9,  7,  0,  0,  0,  0,  0,  0,  0,  1, 10,  0,  0,  8,  0,
+};
+
+#if ( configCLI_USE_PROFILING == 1 )
+    static CLI_Command_Stats_t xStaticCommandStats[ 10 ];
+#endif
+
+const CLI_Static_Command_Table_t xCLIStaticCommandTable =
+{
+    pxStaticCommands,
+    sizeof( pxStaticCommands ) / sizeof( pxStaticCommands[ 0 ] ),
+    ucStaticCommandSlots,
+    0x0000001FUL,
+    0x00000003UL,
+#if ( configCLI_USE_PROFILING == 1 )
+    xStaticCommandStats
+#else
+    NULL
+#endif
+};
+
+/*-----------------------------------------------------------*/
+
+#endif /* configCLI_USE_STATIC_COMMAND_TABLE */
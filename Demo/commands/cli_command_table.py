@@ -0,0 +1,151 @@
+""" Generates cli_command_table.c, the static command table of FreeRTOS+CLI,
+from the CLI_Command_Definition_t definitions of the command files of this
+directory. Run it again whenever a command is added, renamed or removed:
+
+    python3 cli_command_table.py
+
+The hash is the one FreeRTOS_CLI.c probes the table with, described in
+FreeRTOS_CLI.h: FNV-1a from 2166136261 XOR the seed. The smallest power of two
+of slots at least twice the number of commands is used, with the first seed
+for which no two commands share a slot.
+"""
+
+import os
+import re
+import sys
+
+DIRECTORY = os.path.dirname( os.path.abspath( __file__ ) )
+OUTPUT = os.path.join( DIRECTORY, 'cli_command_table.c' )
+
+DEFINITION = re.compile( r'^const\s+CLI_Command_Definition_t\s+(\w+)\s*=\s*\{\s*(?:\(\s*const\s+char\s*\*\s*const\s*\)\s*)?"([^"]+)"',
+                         re.MULTILINE )
+
+MAX_SEEDS = 1 << 20
+
+def fnv1a( command, seed ):
+    value = 2166136261 ^ seed
+
+    for byte in command.encode():
+        value = ( ( value ^ byte ) * 16777619 ) & 0xFFFFFFFF
+
+    return value
+
+def find_commands():
+    """ Returns the ( command, symbol, file ) of every command, ordered by
+    command. """
+    commands = []
+
+    for name in sorted( os.listdir( DIRECTORY ) ):
+        if name.endswith( '.c' ) and os.path.join( DIRECTORY, name ) != OUTPUT:
+            with open( os.path.join( DIRECTORY, name ) ) as f:
+                for symbol, command in DEFINITION.findall( f.read() ):
+                    commands.append( ( command, symbol, name ) )
+
+    return sorted( commands )
+
+def find_seed( commands, slot_count ):
+    for seed in range( MAX_SEEDS ):
+        slots = { fnv1a( command, seed ) & ( slot_count - 1 ) for command, _, _ in commands }
+
+        if len( slots ) == len( commands ):
+            return seed
+
+    return None
+
+def generate( commands ):
+    slot_count = 1
+
+    while slot_count < 2 * len( commands ):
+        slot_count *= 2
+
+    seed = find_seed( commands, slot_count )
+
+    while seed is None:
+        slot_count *= 2
+        seed = find_seed( commands, slot_count )
+
+    slots = [ 0 ] * slot_count
+
+    for index, ( command, _, _ ) in enumerate( commands ):
+        slots[ fnv1a( command, seed ) & ( slot_count - 1 ) ] = index + 1
+
+    lines = [
+        '/* Generated by cli_command_table.py from the command definitions of',
+        ' * this directory, do not edit. */',
+        '',
+        '/* Standard includes. */',
+        '#include <stdint.h>',
+        '',
+        '/* Kernel includes. */',
+        '#include "FreeRTOS.h"',
+        '',
+        '/* FreeRTOS+CLI includes. */',
+        '#include "FreeRTOS_CLI.h"',
+        '',
+        '#if ( configCLI_USE_STATIC_COMMAND_TABLE == 1 )',
+        '',
+    ]
+
+    for command, symbol, name in commands:
+        lines.append( 'extern const CLI_Command_Definition_t %s; /* "%s", %s */' % ( symbol, command, name ) )
+
+    lines += [
+        '',
+        '/*-----------------------------------------------------------*/',
+        '',
+        'static const CLI_Command_Definition_t * const pxStaticCommands[] =',
+        '{',
+    ]
+    lines += [ '    &( %s ),' % symbol for _, symbol, _ in commands ]
+    lines += [
+        '};',
+        '',
+        '/* One more than the index in pxStaticCommands of the command hashing to',
+        ' * each slot, 0 if none. */',
+        'static const uint8_t ucStaticCommandSlots[ %d ] =' % slot_count,
+        '{',
+    ]
+    lines += [ '    ' + ', '.join( '%2d' % slot for slot in slots[ row : row + 16 ] ) + ','
+               for row in range( 0, slot_count, 16 ) ]
+    lines += [
+        '};',
+        '',
+        '#if ( configCLI_USE_PROFILING == 1 )',
+        '    static CLI_Command_Stats_t xStaticCommandStats[ %d ];' % len( commands ),
+        '#endif',
+        '',
+        'const CLI_Static_Command_Table_t xCLIStaticCommandTable =',
+        '{',
+        '    pxStaticCommands,',
+        '    sizeof( pxStaticCommands ) / sizeof( pxStaticCommands[ 0 ] ),',
+        '    ucStaticCommandSlots,',
+        '    0x%08XUL,' % ( slot_count - 1 ),
+        '    0x%08XUL,' % seed,
+        '#if ( configCLI_USE_PROFILING == 1 )',
+        '    xStaticCommandStats',
+        '#else',
+        '    NULL',
+        '#endif',
+        '};',
+        '',
+        '/*-----------------------------------------------------------*/',
+        '',
+        '#endif /* configCLI_USE_STATIC_COMMAND_TABLE */',
+        '',
+    ]
+
+    return '\n'.join( lines )
+
+def main():
+    commands = find_commands()
+
+    if len( commands ) > 255:
+        sys.exit( 'Too many commands for the uint8_t slots.' )
+
+    with open( OUTPUT, 'w' ) as f:
+        f.write( generate( commands ) )
+
+    print( '%d commands written to %s.' % ( len( commands ), OUTPUT ) )
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,197 @@
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+CLI includes. */
+#include "FreeRTOS_CLI.h"
+
+/* CLI server includes. */
+#include "cli_server.h"
+
+/* Names of the CLI_CLASS_* latency classes. */
+static const char * const pcClassNames[ CLI_CLASS_COUNT ] =
+{
+    "normal",
+    "critical",
+    "bulk"
+};
+
+/*-----------------------------------------------------------*/
+
+#if ( configCLI_USE_PROFILING == 1 )
+
+/**
+ * @brief Write the statistics of the calls made to every command.
+ *
+ * The latency histogram has a column per bucket, headed by the power of two
+ * of cycles the calls it counts took less than.
+ */
+static void prvWriteCommandStats( CLI_Writer_t * pxWriter )
+{
+    const CLI_Command_Definition_t * pxCommand;
+    CLI_Command_Stats_t xCommandStats;
+    uint32_t ulAverageCycles;
+    UBaseType_t uxIndex, uxBucket;
+
+    FreeRTOS_CLIPrintf( pxWriter, "\r\nCommand\tcalls\tavg cycles\tmax cycles\ttotal kcycles\tbytes\t" );
+
+    for( uxBucket = 0; uxBucket < ( configCLI_PROFILING_HISTOGRAM_BUCKETS - 1 ); uxBucket++ )
+    {
+        FreeRTOS_CLIPrintf( pxWriter, "<2^%u\t",
+                            ( unsigned ) ( configCLI_PROFILING_HISTOGRAM_FIRST_BITS + ( uxBucket * configCLI_PROFILING_HISTOGRAM_STEP_BITS ) ) );
+    }
+
+    FreeRTOS_CLIPrintf( pxWriter, "more\r\n" );
+
+    for( uxIndex = 0; FreeRTOS_CLIGetCommandStats( uxIndex, &( pxCommand ), &( xCommandStats ) ) == pdTRUE; uxIndex++ )
+    {
+        ulAverageCycles = 0;
+
+        if( xCommandStats.ulCalls > 0 )
+        {
+            ulAverageCycles = ( uint32_t ) ( xCommandStats.ullTotalCycles / xCommandStats.ulCalls );
+        }
+
+        FreeRTOS_CLIPrintf( pxWriter, "%s\t%lu\t%lu\t%lu\t%lu\t%lu",
+                            pxCommand->pcCommand,
+                            ( unsigned long ) xCommandStats.ulCalls,
+                            ( unsigned long ) ulAverageCycles,
+                            ( unsigned long ) xCommandStats.ulMaxCycles,
+                            ( unsigned long ) ( xCommandStats.ullTotalCycles / 1000U ),
+                            ( unsigned long ) xCommandStats.ulOutputBytes );
+
+        for( uxBucket = 0; uxBucket < configCLI_PROFILING_HISTOGRAM_BUCKETS; uxBucket++ )
+        {
+            FreeRTOS_CLIPrintf( pxWriter, "\t%lu", ( unsigned long ) xCommandStats.ulHistogram[ uxBucket ] );
+        }
+
+        FreeRTOS_CLIPrintf( pxWriter, "\r\n" );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* configCLI_USE_PROFILING */
+
+/**
+ * @brief Interpreter that handles the cli-stats command.
+ */
+static void prvCliStatsCommandInterpreter( CLI_Writer_t * pxWriter,
+                                           BaseType_t xArgc,
+                                           const char * const * ppcArgv )
+{
+    CliServerStats_t xStats;
+    uint32_t ulAverageBytesPerSecond = 0;
+    uint32_t ulAverageQueueDelayMs;
+    const CliClassStats_t * pxClassStats;
+    UBaseType_t uxClass;
+
+    ( void ) xArgc;
+    ( void ) ppcArgv;
+
+    vCliServerGetStats( &( xStats ) );
+
+    if( xStats.ulTotalTimeMs > 0 )
+    {
+        ulAverageBytesPerSecond = ( uint32_t ) ( ( ( uint64_t ) xStats.ulTotalBytes * 1000U ) / xStats.ulTotalTimeMs );
+    }
+
+    FreeRTOS_CLIPrintf( pxWriter,
+                        "Responses: %lu\r\n"
+                        "Bytes: %lu\r\n"
+                        "Time: %lu ms\r\n"
+                        "Last rate: %lu bytes/s\r\n"
+                        "Average rate: %lu bytes/s\r\n"
+                        "Rate limit: %lu bytes/s\r\n"
+                        "Throttle events: %lu\r\n"
+                        "Throttled time: %lu ms\r\n"
+                        "Deferred sends: %lu\r\n"
+                        "Datagrams: %lu\r\n"
+                        "Last datagrams: %lu\r\n"
+                        "Last payload size: %lu\r\n"
+                        "Compressed: %lu -> %lu bytes\r\n"
+                        "Retransmissions: %lu\r\n"
+                        "Resend requests: %lu\r\n"
+                        "Busy rejections: %lu\r\n"
+                        "Cache hits: %lu\r\n"
+                        "Cache evictions: %lu\r\n"
+                        "TCP connections: %lu\r\n",
+                        ( unsigned long ) xStats.ulResponses,
+                        ( unsigned long ) xStats.ulTotalBytes,
+                        ( unsigned long ) xStats.ulTotalTimeMs,
+                        ( unsigned long ) xStats.ulLastBytesPerSecond,
+                        ( unsigned long ) ulAverageBytesPerSecond,
+                        ( unsigned long ) xStats.ulRateLimit,
+                        ( unsigned long ) xStats.ulThrottleEvents,
+                        ( unsigned long ) xStats.ulThrottledTimeMs,
+                        ( unsigned long ) xStats.ulDeferredSends,
+                        ( unsigned long ) xStats.ulDatagrams,
+                        ( unsigned long ) xStats.ulLastDatagrams,
+                        ( unsigned long ) xStats.ulLastPayloadSize,
+                        ( unsigned long ) xStats.ulCompressedRawBytes,
+                        ( unsigned long ) xStats.ulCompressedBytes,
+                        ( unsigned long ) xStats.ulRetransmissions,
+                        ( unsigned long ) xStats.ulResendRequests,
+                        ( unsigned long ) xStats.ulBusyRejections,
+                        ( unsigned long ) xStats.ulCacheHits,
+                        ( unsigned long ) xStats.ulCacheEvictions,
+                        ( unsigned long ) xStats.ulTcpConnections );
+
+    /* The queueing delay is the time a request waits for a worker to start
+     * it once dispatched. */
+    for( uxClass = 0; uxClass < CLI_CLASS_COUNT; uxClass++ )
+    {
+        pxClassStats = &( xStats.xClasses[ uxClass ] );
+        ulAverageQueueDelayMs = 0;
+
+        if( pxClassStats->ulRequests > 0 )
+        {
+            ulAverageQueueDelayMs = pxClassStats->ulTotalQueueDelayMs / pxClassStats->ulRequests;
+        }
+
+        FreeRTOS_CLIPrintf( pxWriter,
+                            "Class %s: %lu requests, %lu busy, queueing %lu ms avg %lu ms max %lu ms last\r\n",
+                            pcClassNames[ uxClass ],
+                            ( unsigned long ) pxClassStats->ulRequests,
+                            ( unsigned long ) pxClassStats->ulBusyRejections,
+                            ( unsigned long ) ulAverageQueueDelayMs,
+                            ( unsigned long ) pxClassStats->ulMaxQueueDelayMs,
+                            ( unsigned long ) pxClassStats->ulLastQueueDelayMs );
+    }
+
+    #if ( configCLI_USE_PROFILING == 1 )
+    {
+        prvWriteCommandStats( pxWriter );
+    }
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Structure that defines the "cli-stats" command line command.
+ */
+const CLI_Command_Definition_t xCliStatsCommand =
+{
+    ( const char * const ) "cli-stats", /* The command string to type. */
+    ( const char * const ) "cli-stats: Get the transport statistics of the CLI server, and the calls made to every command.\r\n",
+    NULL, /* Writes to a writer. */
+    0, /* No parameters are expected. */
+    NULL,
+    prvCliStatsCommandInterpreter /* The interpreter function for the command. */
+};
+
+/*-----------------------------------------------------------*/
+
+void vRegisterCliStatsCommand( void )
+{
+    /* Register cli-stats command. */
+    FreeRTOS_CLIRegisterCommand( &( xCliStatsCommand ) );
+}
+
+/*-----------------------------------------------------------*/
@@ -14,61 +14,39 @@
 /* Exception info. */
 #include "expinfo.h"
 
+/* CLI server includes. */
+#include "cli_protocol.h"
+#include "cli_server.h"
+
 /**
  * @brief Interpreter that handles the pcap command.
  */
-static portBASE_TYPE prvExceptionCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
+static portBASE_TYPE prvExceptionCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, BaseType_t xArgc, const char * const *ppcArgv )
 {
-    const char * pcCommandParameter;
-    BaseType_t xCommandParameterLength;
+    /* The interpreter has checked that there is one parameter. */
+    const char * pcCommandParameter = ppcArgv[ 1 ];
 
-    configASSERT( pcWriteBuffer );
+    ( void ) xArgc;
 
-    pcCommandParameter = FreeRTOS_CLIGetParameter( pcCommandString, 1, &( xCommandParameterLength ) );
+    configASSERT( pcWriteBuffer );
 
-    if( pcCommandParameter != NULL )
+    /* A command parameter for the demo purpose only to force an assert. */
+    if( strcmp( pcCommandParameter, "trigger" ) == 0 )
     {
-        if( strncmp( pcCommandParameter, "get", xCommandParameterLength ) == 0 )
-        {
-            /* HACK - coredump data is binary data and therefore, cannot be sent as
-             * a null terminated string as payload can have legitimate null
-             * bytes. Instead, we write a marker here in the output buffer which
-             * the caller of FreeRTOS_CLIProcessCommand checks and sends the
-             * actual data instead of this response. */
-            BaseType_t xCoredumpExist;
-            xCoredumpExist = ExpInfo_InfoExist();
-
-            if( xCoredumpExist == pdTRUE )
-            {
-                snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "COREDUMP-GET" );
-            }
-            else
-            {
-                snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "No coredump exists!" );
-            }
-        }
-        /* A command parameter for the demo purpose only to force an assert. */
-        else if( strncmp( pcCommandParameter, "trigger", xCommandParameterLength ) == 0 )
-        {
-            configASSERT( pdFALSE );
-        }
-        else if( strncmp( pcCommandParameter, "check", xCommandParameterLength ) == 0 )
+        configASSERT( pdFALSE );
+    }
+    else if( strcmp( pcCommandParameter, "check" ) == 0 )
+    {
+        BaseType_t xCoredumpExist;
+        xCoredumpExist = ExpInfo_InfoExist();
+
+        if( xCoredumpExist == pdTRUE )
         {
-            BaseType_t xCoredumpExist;
-            xCoredumpExist = ExpInfo_InfoExist();
-
-            if( xCoredumpExist == pdTRUE )
-            {
-                snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "TRUE" );
-            }
-            else
-            {
-                snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "FALSE" );
-            }
+            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "TRUE" );
         }
         else
         {
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "Bad Command." );
+            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "FALSE" );
         }
     }
     else
@@ -82,15 +60,61 @@ static portBASE_TYPE prvExceptionCommandInterpreter( char *pcWriteBuffer, size_t
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Handler of the CLI_OPCODE_COREDUMP_GET opcode.
+ *
+ * Coredump data is binary data and therefore, is sent straight from flash.
+ * The coredump stays in flash, so it needs no release.
+ */
+static BaseType_t prvCoredumpGetOpcodeHandler( const CliArgument_t * pxArguments,
+                                               UBaseType_t uxArgumentCount,
+                                               CliOutput_t * pxOutput )
+{
+    BaseType_t xReturn = pdFAIL;
+    const uint8_t * pucDumpAddress;
+    uint32_t ulDumpLength;
+
+    ( void ) pxArguments;
+    ( void ) uxArgumentCount;
+
+    if( ( ExpInfo_InfoExist() == pdTRUE ) &&
+        ( ExpInfo_GetInfo( &pucDumpAddress, &ulDumpLength ) != pdFALSE ) )
+    {
+        xReturn = xCliOutputAddMemory( pxOutput, pucDumpAddress, ulDumpLength, NULL );
+    }
+    else
+    {
+        ( void ) xCliOutputAddText( pxOutput, "No coredump exists!" );
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Structure that defines the "coredump" command line command.
  */
-static const CLI_Command_Definition_t xExceptionCommand =
+const CLI_Command_Definition_t xExceptionCommand =
 {
     ( const char * const ) "coredump", /* The command string to type. */
     ( const char * const ) "coredump: Checks or retrieves a coredump according to the parameter - check/get.\r\n",
+    NULL, /* Takes an argument vector. */
+    1, /* One parameter - check or get. */
     prvExceptionCommandInterpreter, /* The interpreter function for the command. */
-    1 /* One parameter - check or get. */
+    NULL
+};
+
+/**
+ * @brief Structure that defines the opcode serving "coredump get".
+ */
+static const CliOpcodeDefinition_t xCoredumpGetOpcode =
+{
+    CLI_OPCODE_COREDUMP_GET,
+    "coredump get",
+    NULL,
+    CLI_CLASS_BULK,
+    prvCoredumpGetOpcodeHandler
 };
 
 /*-----------------------------------------------------------*/
@@ -98,6 +122,7 @@ static const CLI_Command_Definition_t xExceptionCommand =
 void vRegisterExceptionCommand( void )
 {
     FreeRTOS_CLIRegisterCommand( &( xExceptionCommand ) );
+    ( void ) xCliServerRegisterOpcode( &( xCoredumpGetOpcode ) );
 }
 
 /*-----------------------------------------------------------*/
@@ -17,40 +17,46 @@
 #include "FreeRTOS_Firewall.h"
 
 static portBASE_TYPE prvFirewallAddRuleCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
-static portBASE_TYPE prvFirewallListCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
+static void prvFirewallListCommandInterpreter( CLI_Writer_t *pxWriter, BaseType_t xArgc, const char * const *ppcArgv );
 static portBASE_TYPE prvFirewallRemoveRuleCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
 
 /**
  * @brief Structure that defines the "firewall-add" command line command.
  */
-static const CLI_Command_Definition_t xFirewallAddCommand =
+const CLI_Command_Definition_t xFirewallAddCommand =
 {
     ( const char * const ) "firewall-add", /* The command string to type. */
     ( const char * const ) "firewall-add: Add a new firewall rule.\r\n",
     prvFirewallAddRuleCommandInterpreter, /* The interpreter function for the command. */
-    6 /* No parameters are expected. */
+    6, /* No parameters are expected. */
+    NULL,
+    NULL
 };
 
 /**
  * @brief Structure that defines the "firewall-list" command line command.
  */
-static const CLI_Command_Definition_t xFirewallListCommand =
+const CLI_Command_Definition_t xFirewallListCommand =
 {
     ( const char * const ) "firewall-list", /* The command string to type. */
     ( const char * const ) "firewall-list: List active firewall rules.\r\n",
-    prvFirewallListCommandInterpreter, /* The interpreter function for the command. */
-    0 /* No parameters are expected. */
+    NULL, /* Writes to a writer. */
+    0, /* No parameters are expected. */
+    NULL,
+    prvFirewallListCommandInterpreter /* The interpreter function for the command. */
 };
 
 /**
  * @brief Structure that defines the "firewall-remove" command line command.
  */
-static const CLI_Command_Definition_t xFirewallRemoveRuleCommand =
+const CLI_Command_Definition_t xFirewallRemoveRuleCommand =
 {
     ( const char * const ) "firewall-remove", /* The command string to type. */
     ( const char * const ) "firewall-remove: Remove active firewall rule by rule ID.\r\n",
     prvFirewallRemoveRuleCommandInterpreter, /* The interpreter function for the command. */
-    1 /* No parameters are expected. */
+    1, /* No parameters are expected. */
+    NULL,
+    NULL
 };
 
 
@@ -78,21 +84,44 @@ static portBASE_TYPE prvFirewallAddRuleCommandInterpreter( char *pcWriteBuffer,
 
 /**
  * @brief Interpreter that handles the firewall-list command.
+ *
+ * The rules are listed straight into what is left of the chunk of the writer,
+ * rather than in a configCOMMAND_INT_MAX_OUTPUT_SIZE buffer. Rules which do
+ * not fit are listed again in a fresh chunk, as FreeRTOS_CLIPrintf() does.
  */
-static portBASE_TYPE prvFirewallListCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
+static void prvFirewallListCommandInterpreter( CLI_Writer_t *pxWriter, BaseType_t xArgc, const char * const *ppcArgv )
 {
-    ( void ) pcCommandString;
-
     BaseType_t xRet = pdFALSE;
+    size_t xSpaceLength;
+    char *pcSpace = FreeRTOS_CLIWriterGetSpace( pxWriter, &xSpaceLength );
 
-    xRet = xFirewallListRules((uint8_t *)pcWriteBuffer, xWriteBufferLen);
+    ( void ) xArgc;
+    ( void ) ppcArgv;
 
-    if(xRet == pdFALSE)
+    if( xSpaceLength > 0 )
+    {
+        xRet = xFirewallListRules((uint8_t *)pcSpace, xSpaceLength);
+    }
+
+    if( ( xRet == pdFALSE ) && ( pxWriter->xLength > 0 ) && ( pxWriter->pxFlush != NULL ) )
     {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Internal error command (low buffer size)\r\n");
+        FreeRTOS_CLIWriterFlush( pxWriter );
+        pcSpace = FreeRTOS_CLIWriterGetSpace( pxWriter, &xSpaceLength );
+
+        if( xSpaceLength > 0 )
+        {
+            xRet = xFirewallListRules((uint8_t *)pcSpace, xSpaceLength);
+        }
     }
 
-    return pdFALSE;
+    if(xRet == pdFALSE)
+    {
+        FreeRTOS_CLIPrintf(pxWriter, "Internal error command (low buffer size)\r\n");
+    }
+    else
+    {
+        FreeRTOS_CLIWriterCommit(pxWriter, strnlen(pcSpace, xSpaceLength));
+    }
 }
 
 /**
@@ -11,9 +11,59 @@
 /* FreeRTOS+CLI includes. */
 #include "FreeRTOS_CLI.h"
 
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+
 /* Netstat includes. */
 #include "netstat_capture.h"
 
+/* CLI server includes. */
+#include "cli_protocol.h"
+#include "cli_server.h"
+
+/* Clients of CLI_OPCODE_NETSTAT_DELTA whose baseline is kept, the least
+ * recently served is forgotten first. */
+#define netstatDELTA_MAX_CLIENTS            8
+
+/* Responses after which a client gets a keyframe again. */
+#define netstatDELTA_KEYFRAME_INTERVAL      60U
+
+/* Longest varint of a 32-bit value. */
+#define netstatDELTA_MAX_VARINT_LENGTH      5U
+
+/*-----------------------------------------------------------*/
+
+typedef struct NetstatDeltaClient
+{
+    uint32_t ulClientId;            /* 0 if the entry is free. */
+    uint32_t ulSequence;            /* Sequence of the last response, the baseline. */
+    uint32_t ulResponses;           /* Responses since the last keyframe. */
+    TickType_t xLastServed;
+    uint32_t ulBaseline[ NETSTAT_DELTA_COUNTERS ];
+} NetstatDeltaClient_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvGetCounters( const NetworkStats_t * pxStats,
+                            uint32_t * pulCounters );
+
+static BaseType_t prvGetUint32Argument( const CliArgument_t * pxArgument,
+                                        uint32_t * pulValue );
+
+static NetstatDeltaClient_t * prvFindDeltaClient( uint32_t ulClientId );
+
+static size_t prvWriteVarint( uint8_t * pucOutput,
+                              uint32_t ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* Only accessed by the opcode handler, under the interpreter mutex of the
+ * CLI server. */
+static NetstatDeltaClient_t xDeltaClients[ netstatDELTA_MAX_CLIENTS ];
+static uint32_t ulDeltaSequence = 0;
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Interpreter that handles the netstat command.
  */
@@ -59,15 +109,231 @@ static portBASE_TYPE prvNetStatCommandInterpreter( char *pcWriteBuffer, size_t x
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Handler of the CLI_OPCODE_NETSTAT_DELTA opcode.
+ *
+ * Encodes the counters which changed since the baseline of the client, as
+ * described in cli_protocol.h.
+ */
+static BaseType_t prvNetstatDeltaOpcodeHandler( const CliArgument_t * pxArguments,
+                                                UBaseType_t uxArgumentCount,
+                                                char * pcTextBuffer,
+                                                size_t xTextBufferLength,
+                                                CliPayload_t * pxPayload )
+{
+    NetstatDeltaHeader_t * pxHeader = ( NetstatDeltaHeader_t * ) pcTextBuffer;
+    uint8_t * pucOutput = ( uint8_t * ) pcTextBuffer;
+    NetstatDeltaClient_t * pxClient = NULL;
+    const uint32_t * pulBaseline = NULL;
+    uint32_t ulCounters[ NETSTAT_DELTA_COUNTERS ];
+    uint32_t ulClientId = 0, ulBaseline = 0, ulDelta;
+    NetworkStats_t xStats;
+    size_t uxLength = sizeof( NetstatDeltaHeader_t );
+    UBaseType_t uxIndex;
+    BaseType_t xReturn = pdFAIL;
+
+    if( ( uxArgumentCount == 0U ) ||
+        ( ( uxArgumentCount == 2U ) &&
+          ( prvGetUint32Argument( &( pxArguments[ 0 ] ), &( ulClientId ) ) == pdPASS ) &&
+          ( prvGetUint32Argument( &( pxArguments[ 1 ] ), &( ulBaseline ) ) == pdPASS ) ) )
+    {
+        xReturn = pdPASS;
+    }
+
+    if( ( xReturn == pdPASS ) &&
+        ( xTextBufferLength >= ( sizeof( NetstatDeltaHeader_t ) + ( NETSTAT_DELTA_COUNTERS * netstatDELTA_MAX_VARINT_LENGTH ) ) ) &&
+        ( Netstat_GetStats( &( xStats ) ) == NETSTAT_RESULT_OK ) )
+    {
+        prvGetCounters( &( xStats ), &( ulCounters[ 0 ] ) );
+
+        /* 0 is the baseline of a keyframe request, never a sequence. */
+        ulDeltaSequence++;
+
+        if( ulDeltaSequence == 0U )
+        {
+            ulDeltaSequence = 1U;
+        }
+
+        if( ulClientId != 0U )
+        {
+            pxClient = prvFindDeltaClient( ulClientId );
+
+            if( ( pxClient->ulClientId == ulClientId ) &&
+                ( ulBaseline != 0U ) &&
+                ( pxClient->ulSequence == ulBaseline ) &&
+                ( pxClient->ulResponses < netstatDELTA_KEYFRAME_INTERVAL ) )
+            {
+                pulBaseline = &( pxClient->ulBaseline[ 0 ] );
+            }
+        }
+
+        memset( pxHeader, 0, sizeof( NetstatDeltaHeader_t ) );
+        pxHeader->ucVersion = NETSTAT_DELTA_VERSION;
+        pxHeader->ucFlags = ( pulBaseline == NULL ) ? NETSTAT_DELTA_FLAG_KEYFRAME : 0U;
+        pxHeader->ucCounters = NETSTAT_DELTA_COUNTERS;
+        pxHeader->ulSequence = FreeRTOS_htonl( ulDeltaSequence );
+
+        for( uxIndex = 0; uxIndex < NETSTAT_DELTA_COUNTERS; uxIndex++ )
+        {
+            ulDelta = ulCounters[ uxIndex ] - ( ( pulBaseline != NULL ) ? pulBaseline[ uxIndex ] : 0U );
+
+            if( ulDelta != 0U )
+            {
+                /* Zigzag encoding, so that a counter reset stays short. */
+                ulDelta = ( ( ulDelta & 0x80000000UL ) != 0U ) ? ~( ulDelta << 1 ) : ( ulDelta << 1 );
+
+                pxHeader->ucChanged[ uxIndex / 8U ] |= ( uint8_t ) ( 1U << ( uxIndex % 8U ) );
+                uxLength += prvWriteVarint( &( pucOutput[ uxLength ] ), ulDelta );
+            }
+        }
+
+        if( pxClient != NULL )
+        {
+            if( pulBaseline == NULL )
+            {
+                pxClient->ulClientId = ulClientId;
+                pxClient->ulResponses = 0;
+            }
+
+            pxClient->ulResponses++;
+            pxClient->ulSequence = ulDeltaSequence;
+            pxClient->xLastServed = xTaskGetTickCount();
+            memcpy( &( pxClient->ulBaseline[ 0 ] ), &( ulCounters[ 0 ] ), sizeof( ulCounters ) );
+        }
+
+        pxPayload->ucType = CLI_PAYLOAD_TEXT;
+        pxPayload->ulLength = ( uint32_t ) uxLength;
+    }
+    else
+    {
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvGetCounters( const NetworkStats_t * pxStats,
+                            uint32_t * pulCounters )
+{
+    const ProtocolStats_t * pxProtocols[ 3 ] = { &( pxStats->udp ), &( pxStats->tcp ), &( pxStats->icmp ) };
+    UBaseType_t uxIndex;
+
+    /* The order of the netstat command. */
+    for( uxIndex = 0; uxIndex < 3U; uxIndex++ )
+    {
+        *pulCounters++ = pxProtocols[ uxIndex ]->rxPackets;
+        *pulCounters++ = pxProtocols[ uxIndex ]->txPackets;
+        *pulCounters++ = pxProtocols[ uxIndex ]->rxDropped;
+        *pulCounters++ = pxProtocols[ uxIndex ]->txDropped;
+        *pulCounters++ = pxProtocols[ uxIndex ]->rxBytes;
+        *pulCounters++ = pxProtocols[ uxIndex ]->txBytes;
+    }
+
+    *pulCounters++ = ( uint32_t ) ( ( pxStats->rxLatency >> 32 ) & 0xFFFFFFFFU );
+    *pulCounters++ = ( uint32_t ) ( pxStats->rxLatency & 0xFFFFFFFFU );
+    *pulCounters++ = ( uint32_t ) ( ( pxStats->txLatency >> 32 ) & 0xFFFFFFFFU );
+    *pulCounters = ( uint32_t ) ( pxStats->txLatency & 0xFFFFFFFFU );
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvGetUint32Argument( const CliArgument_t * pxArgument,
+                                        uint32_t * pulValue )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    if( ( pxArgument->ucTag == CLI_TLV_UINT32 ) && ( pxArgument->usLength == sizeof( uint32_t ) ) )
+    {
+        *pulValue = ( ( uint32_t ) pxArgument->pucValue[ 0 ] << 24 ) |
+                    ( ( uint32_t ) pxArgument->pucValue[ 1 ] << 16 ) |
+                    ( ( uint32_t ) pxArgument->pucValue[ 2 ] << 8 ) |
+                    ( ( uint32_t ) pxArgument->pucValue[ 3 ] );
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+static NetstatDeltaClient_t * prvFindDeltaClient( uint32_t ulClientId )
+{
+    NetstatDeltaClient_t * pxClient = NULL;
+    TickType_t xNow = xTaskGetTickCount();
+    UBaseType_t uxIndex;
+
+    /* The entry of the client, else a free one, else the least recently
+     * served. The caller takes over the entry of another client. */
+    for( uxIndex = 0; uxIndex < netstatDELTA_MAX_CLIENTS; uxIndex++ )
+    {
+        if( xDeltaClients[ uxIndex ].ulClientId == ulClientId )
+        {
+            pxClient = &( xDeltaClients[ uxIndex ] );
+            break;
+        }
+        else if( ( pxClient == NULL ) || ( pxClient->ulClientId != 0U ) )
+        {
+            if( ( pxClient == NULL ) ||
+                ( xDeltaClients[ uxIndex ].ulClientId == 0U ) ||
+                ( ( xNow - xDeltaClients[ uxIndex ].xLastServed ) > ( xNow - pxClient->xLastServed ) ) )
+            {
+                pxClient = &( xDeltaClients[ uxIndex ] );
+            }
+        }
+        else
+        {
+            /* A free entry is already found. */
+        }
+    }
+
+    return pxClient;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t prvWriteVarint( uint8_t * pucOutput,
+                              uint32_t ulValue )
+{
+    size_t uxLength = 0;
+
+    while( ulValue >= 0x80U )
+    {
+        pucOutput[ uxLength++ ] = ( uint8_t ) ( ( ulValue & 0x7FU ) | 0x80U );
+        ulValue >>= 7;
+    }
+
+    pucOutput[ uxLength++ ] = ( uint8_t ) ulValue;
+
+    return uxLength;
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Structure that defines the "netstat" command line command.
  */
-static const CLI_Command_Definition_t xNetStatCommand =
+const CLI_Command_Definition_t xNetStatCommand =
 {
     ( const char * const ) "netstat", /* The command string to type. */
     ( const char * const ) "netstat: Get the Network Statistics.\r\n",
     prvNetStatCommandInterpreter, /* The interpreter function for the command. */
-    0 /* No parameters are expected. */
+    0, /* No parameters are expected. */
+    NULL,
+    NULL
+};
+
+/**
+ * @brief Structure that defines the opcode serving "netstat delta".
+ */
+static const CliOpcodeDefinition_t xNetStatDeltaOpcode =
+{
+    CLI_OPCODE_NETSTAT_DELTA,
+    "netstat delta",
+    prvNetstatDeltaOpcodeHandler,
+    CLI_CLASS_CRITICAL,
+    NULL
 };
 
 /*-----------------------------------------------------------*/
@@ -76,6 +342,7 @@ void vRegisterNetStatCommand( void )
 {
     /* Register netstat command. */
     FreeRTOS_CLIRegisterCommand( &( xNetStatCommand ) );
+    ( void ) xCliServerRegisterOpcode( &( xNetStatDeltaOpcode ) );
 }
 
 /*-----------------------------------------------------------*/
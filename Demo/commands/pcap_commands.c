@@ -14,43 +14,31 @@
 /* Pcap capture includes. */
 #include "pcap_capture.h"
 
+/* CLI server includes. */
+#include "cli_protocol.h"
+#include "cli_server.h"
+
 /**
  * @brief Interpreter that handles the pcap command.
  */
-static portBASE_TYPE prvPcapCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
+static portBASE_TYPE prvPcapCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, BaseType_t xArgc, const char * const *ppcArgv )
 {
-    const char * pcCommandParameter;
-    BaseType_t xCommandParameterLength;
+    /* The interpreter has checked that there is one parameter. */
+    const char * pcCommandParameter = ppcArgv[ 1 ];
 
-    configASSERT( pcWriteBuffer );
+    ( void ) xArgc;
 
-    pcCommandParameter = FreeRTOS_CLIGetParameter( pcCommandString, 1, &( xCommandParameterLength ) );
+    configASSERT( pcWriteBuffer );
 
-    if( pcCommandParameter != NULL )
+    if( strcmp( pcCommandParameter, "start" ) == 0 )
+    {
+        PcapCapture_Start();
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
+    }
+    else if( strcmp( pcCommandParameter, "stop" ) == 0 )
     {
-        if( strncmp( pcCommandParameter, "start", xCommandParameterLength ) == 0 )
-        {
-            PcapCapture_Start();
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
-        }
-        else if( strncmp( pcCommandParameter, "stop", xCommandParameterLength ) == 0 )
-        {
-            PcapCapture_Stop();
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
-        }
-        else if( strncmp( pcCommandParameter, "get", xCommandParameterLength ) == 0 )
-        {
-            /* HACK - PCAP data is binary data and therefore, cannot be sent as
-             * a null terminated string as payload can have legitimate null
-             * bytes. Instead, we write a marker here in the output buffer which
-             * the caller of FreeRTOS_CLIProcessCommand checks and sends the
-             * actual data instead of this response. */
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "PCAP-GET" );
-        }
-        else
-        {
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "Bad Command." );
-        }
+        PcapCapture_Stop();
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
     }
     else
     {
@@ -63,15 +51,58 @@ static portBASE_TYPE prvPcapCommandInterpreter( char *pcWriteBuffer, size_t xWri
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Handler of the CLI_OPCODE_PCAP_GET opcode.
+ *
+ * PCAP data is binary data and therefore, is sent straight from the capture
+ * buffer. The capture is reset once the response leaves the response cache,
+ * or at the latest when it is fetched again, so that retries and RESEND
+ * requests are served from it.
+ */
+static BaseType_t prvPcapGetOpcodeHandler( const CliArgument_t * pxArguments,
+                                           UBaseType_t uxArgumentCount,
+                                           CliOutput_t * pxOutput )
+{
+    const uint8_t * pucPcapData;
+    size_t uxPcapDataLength;
+
+    ( void ) pxArguments;
+    ( void ) uxArgumentCount;
+
+    PcapCapture_GetCapturedData( &( pucPcapData ),
+                                 &( uxPcapDataLength ) );
+
+    return xCliOutputAddMemory( pxOutput,
+                                pucPcapData,
+                                ( uint32_t ) uxPcapDataLength,
+                                PcapCapture_Reset );
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Structure that defines the "pcap" command line command.
  */
-static const CLI_Command_Definition_t xPcapCommand =
+const CLI_Command_Definition_t xPcapCommand =
 {
     ( const char * const ) "pcap", /* The command string to type. */
     ( const char * const ) "pcap: Starts, stops and gets the packet capture according to the parameter - start/stop/get.\r\n",
+    NULL, /* Takes an argument vector. */
+    1, /* One parameter - start, stop or get. */
     prvPcapCommandInterpreter, /* The interpreter function for the command. */
-    1 /* One parameter - start, stop or get. */
+    NULL
+};
+
+/**
+ * @brief Structure that defines the opcode serving "pcap get".
+ */
+static const CliOpcodeDefinition_t xPcapGetOpcode =
+{
+    CLI_OPCODE_PCAP_GET,
+    "pcap get",
+    NULL,
+    CLI_CLASS_BULK,
+    prvPcapGetOpcodeHandler
 };
 
 /*-----------------------------------------------------------*/
@@ -79,6 +110,7 @@ static const CLI_Command_Definition_t xPcapCommand =
 void vRegisterPcapCommand( void )
 {
     FreeRTOS_CLIRegisterCommand( &( xPcapCommand ) );
+    ( void ) xCliServerRegisterOpcode( &( xPcapGetOpcode ) );
 }
 
 /*-----------------------------------------------------------*/
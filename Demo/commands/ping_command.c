@@ -30,12 +30,14 @@ static portBASE_TYPE prvPingCommandInterpreter( char *pcWriteBuffer, size_t xWri
 /**
  * @brief Structure that defines the "ping" command line command.
  */
-static const CLI_Command_Definition_t xPingCommand =
+const CLI_Command_Definition_t xPingCommand =
 {
     ( const char * const ) "ping", /* The command string to type. */
     ( const char * const ) "ping: Returns OK.\r\n",
     prvPingCommandInterpreter, /* The interpreter function for the command. */
-    0 /* No parameters are expected. */
+    0, /* No parameters are expected. */
+    NULL,
+    NULL
 };
 
 /*-----------------------------------------------------------*/
@@ -10,22 +10,71 @@
 /* FreeRTOS+CLI includes. */
 #include "FreeRTOS_CLI.h"
 
+/* Must be at least the number of tasks in the system for
+ * uxTaskGetSystemState to succeed. */
+#define topMAX_TASKS    24
+
+/*-----------------------------------------------------------*/
+
+/* Buffer of uxTaskGetSystemState. The writer commands run to completion in one
+ * call, and the CLI server serialises them. */
+static TaskStatus_t xTopTaskStatus[ topMAX_TASKS ];
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Interpreter that handles the top command.
+ *
+ * Writes a line per task, in the format of vTaskGetRunTimeStats, straight to
+ * the writer so that the output is not limited by the number of tasks.
  */
-static portBASE_TYPE prvTopCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
+static void prvTopCommandInterpreter( CLI_Writer_t *pxWriter, BaseType_t xArgc, const char * const *ppcArgv )
 {
-    ( void ) pcCommandString;
-    ( void ) xWriteBufferLen;
+    UBaseType_t uxTaskCount, uxIndex;
+    uint64_t ullTotalRunTime = 0;
+    uint32_t ulPercentage;
+
+    ( void ) xArgc;
+    ( void ) ppcArgv;
+
+    /* Returns 0 if there are more than topMAX_TASKS tasks. */
+    uxTaskCount = uxTaskGetSystemState( &( xTopTaskStatus[ 0 ] ), topMAX_TASKS, NULL );
+
+    /* The percentages are relative to the time run by the tasks which still
+     * exist. */
+    for( uxIndex = 0; uxIndex < uxTaskCount; uxIndex++ )
+    {
+        ullTotalRunTime += ( uint64_t ) xTopTaskStatus[ uxIndex ].ulRunTimeCounter;
+    }
+
+    for( uxIndex = 0; uxIndex < uxTaskCount; uxIndex++ )
+    {
+        ulPercentage = 0;
 
-    configASSERT( pcWriteBuffer );
+        if( ullTotalRunTime > 0 )
+        {
+            ulPercentage = ( uint32_t ) ( ( ( uint64_t ) xTopTaskStatus[ uxIndex ].ulRunTimeCounter * 100U ) / ullTotalRunTime );
+        }
 
-    /* TODO - We need to call uxTaskGetSystemState and return the
-     * results in a format suitable for our CLI. */
-    vTaskGetRunTimeStats( pcWriteBuffer );
+        if( ulPercentage > 0 )
+        {
+            FreeRTOS_CLIPrintf( pxWriter, "%s\t\t%lu\t\t%lu%%\r\n",
+                                xTopTaskStatus[ uxIndex ].pcTaskName,
+                                ( unsigned long ) xTopTaskStatus[ uxIndex ].ulRunTimeCounter,
+                                ( unsigned long ) ulPercentage );
+        }
+        else
+        {
+            FreeRTOS_CLIPrintf( pxWriter, "%s\t\t%lu\t\t<1%%\r\n",
+                                xTopTaskStatus[ uxIndex ].pcTaskName,
+                                ( unsigned long ) xTopTaskStatus[ uxIndex ].ulRunTimeCounter );
+        }
+    }
 
-    /* Return pdFALSE to indicate that the response is complete. */
-    return pdFALSE;
+    if( uxTaskCount == 0U )
+    {
+        FreeRTOS_CLIPrintf( pxWriter, "More than %u tasks.\r\n", ( unsigned ) topMAX_TASKS );
+    }
 }
 
 /*-----------------------------------------------------------*/
@@ -33,12 +82,14 @@ static portBASE_TYPE prvTopCommandInterpreter( char *pcWriteBuffer, size_t xWrit
 /**
  * @brief Structure that defines the "top" command line command.
  */
-static const CLI_Command_Definition_t xTopCommand =
+const CLI_Command_Definition_t xTopCommand =
 {
     ( const char * const ) "top", /* The command string to type. */
     ( const char * const ) "top: Returns various stats about all tasks.\r\n",
-    prvTopCommandInterpreter, /* The interpreter function for the command. */
-    0 /* No parameters are expected. */
+    NULL, /* Writes to a writer. */
+    0, /* No parameters are expected. */
+    NULL,
+    prvTopCommandInterpreter /* The interpreter function for the command. */
 };
 
 /*-----------------------------------------------------------*/
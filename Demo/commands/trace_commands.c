@@ -13,47 +13,35 @@
 
 /* FreeRTOS-tdlogger includes. */
 #include "FreeRTOS_TD_Logger.h"
+
+/* CLI server includes. */
+#include "cli_protocol.h"
+#include "cli_server.h"
 /*-----------------------------------------------------------*/
 
 /**
  * @brief Interpreter that handles the trace command.
  */
-static portBASE_TYPE prvTraceCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
+static portBASE_TYPE prvTraceCommandInterpreter( char *pcWriteBuffer, size_t xWriteBufferLen, BaseType_t xArgc, const char * const *ppcArgv )
 {
-    const char * pcCommandParameter;
-    BaseType_t xCommandParameterLength;
+    /* The interpreter has checked that there is one parameter. */
+    const char * pcCommandParameter = ppcArgv[ 1 ];
+
+    ( void ) xArgc;
 
     configASSERT( pcWriteBuffer );
 
-    pcCommandParameter = FreeRTOS_CLIGetParameter( pcCommandString, 1, &( xCommandParameterLength ) );
+    if( strcmp( pcCommandParameter, "start" ) == 0 )
+    {
+        FreeRTOS_TD_Logger_Start();
 
-    if( pcCommandParameter != NULL )
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
+    }
+    else if( strcmp( pcCommandParameter, "stop" ) == 0 )
     {
-        if( strncmp( pcCommandParameter, "start", xCommandParameterLength ) == 0 )
-        {
-            FreeRTOS_TD_Logger_Start();
-
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
-        }
-        else if( strncmp( pcCommandParameter, "stop", xCommandParameterLength ) == 0 )
-        {
-            FreeRTOS_TD_Logger_Stop();
-
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
-        }
-        else if( strncmp( pcCommandParameter, "get", xCommandParameterLength ) == 0 )
-        {
-            /* HACK - TRACE data is binary data and therefore, cannot be sent as
-             * a null terminated string as payload can have legitimate null
-             * bytes. Instead, we write a marker here in the output buffer which
-             * the caller of FreeRTOS_CLIProcessCommand checks and sends the
-             * actual data instead of this response. */
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "TRACE-GET" );
-        }
-        else
-        {
-            snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "Bad Command." );
-        }
+        FreeRTOS_TD_Logger_Stop();
+
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "OK" );
     }
     else
     {
@@ -66,15 +54,58 @@ static portBASE_TYPE prvTraceCommandInterpreter( char *pcWriteBuffer, size_t xWr
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Handler of the CLI_OPCODE_TRACE_GET opcode.
+ *
+ * Trace data is binary data and therefore, is sent straight from the trace
+ * buffer. The trace is reset once the response leaves the response cache,
+ * or at the latest when it is fetched again, so that retries and RESEND
+ * requests are served from it.
+ */
+static BaseType_t prvTraceGetOpcodeHandler( const CliArgument_t * pxArguments,
+                                            UBaseType_t uxArgumentCount,
+                                            CliOutput_t * pxOutput )
+{
+    const uint8_t * pucTraceCapture;
+    size_t xTraceCaptureLength;
+
+    ( void ) pxArguments;
+    ( void ) uxArgumentCount;
+
+    FreeRTOS_TD_Logger_GetTrace( &( pucTraceCapture ),
+                                 &( xTraceCaptureLength ) );
+
+    return xCliOutputAddMemory( pxOutput,
+                                pucTraceCapture,
+                                ( uint32_t ) xTraceCaptureLength,
+                                FreeRTOS_TD_Logger_Reset );
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Structure that defines the "trace" command line command.
  */
-static const CLI_Command_Definition_t xTraceCommand =
+const CLI_Command_Definition_t xTraceCommand =
 {
     ( const char * const ) "trace", /* The command string to type. */
     ( const char * const ) "trace: Starts, stops and gets the trace according to the parameter - start/stop/get.\r\n",
+    NULL, /* Takes an argument vector. */
+    1, /* One parameter - start, stop or get. */
     prvTraceCommandInterpreter, /* The interpreter function for the command. */
-    1 /* One parameter - start, stop or get. */
+    NULL
+};
+
+/**
+ * @brief Structure that defines the opcode serving "trace get".
+ */
+static const CliOpcodeDefinition_t xTraceGetOpcode =
+{
+    CLI_OPCODE_TRACE_GET,
+    "trace get",
+    NULL,
+    CLI_CLASS_BULK,
+    prvTraceGetOpcodeHandler
 };
 
 /*-----------------------------------------------------------*/
@@ -82,6 +113,7 @@ static const CLI_Command_Definition_t xTraceCommand =
 void vRegisterTraceCommand( void )
 {
     FreeRTOS_CLIRegisterCommand( &( xTraceCommand ) );
+    ( void ) xCliServerRegisterOpcode( &( xTraceGetOpcode ) );
 }
 
 /*-----------------------------------------------------------*/
@@ -11,6 +11,8 @@
 /* Interface includes. */
 #include "netstat_capture.h"
 
+#if defined( __arm__ )
+
 /* DWT related defines. */
 #define ARM_REG_DEMCR         ( *( volatile uint32_t * ) 0xE000EDFC )
 #define ARM_REG_DWT_CTRL      ( *( volatile uint32_t * ) 0xE0001000 )
@@ -18,6 +20,18 @@
 #define DWT_CYCCNTENA_BIT     ( 1UL << 0 )
 #define DWT_TRCENA_BIT        ( 1UL << 24 )
 
+#define READ_CYCLE_COUNT()    ARM_REG_DWT_CYCCNT
+
+#else
+
+/* There is no DWT in the host build. The host provides a cycle count derived
+ * from its monotonic clock, running at CLOCK_SPEED_HTZ. */
+extern uint32_t ulHostGetCycleCount( void );
+
+#define READ_CYCLE_COUNT()    ulHostGetCycleCount()
+
+#endif
+
 /*-----------------------------------------------------------*/
 
 static NetworkStats_t stats;
@@ -49,12 +63,16 @@ void StartRecording( void )
     memset( &( stats ), 0 , sizeof( NetworkStats_t ) );
 
     /* Initialize DWT for latency measurements. */
-    if( ARM_REG_DWT_CTRL != 0 )
+    #if defined( __arm__ )
     {
-        ARM_REG_DEMCR |= DWT_TRCENA_BIT;
-        ARM_REG_DWT_CYCCNT = 0;
-        ARM_REG_DWT_CTRL |= DWT_CYCCNTENA_BIT;
+        if( ARM_REG_DWT_CTRL != 0 )
+        {
+            ARM_REG_DEMCR |= DWT_TRCENA_BIT;
+            ARM_REG_DWT_CYCCNT = 0;
+            ARM_REG_DWT_CTRL |= DWT_CYCCNTENA_BIT;
+        }
     }
+    #endif
 
     record = 1;
 }
@@ -65,9 +83,8 @@ void StopRecording( void )
 {
     record = 0;
 
-    /* Disable DWT. */
-    ARM_REG_DWT_CYCCNT = 0;
-    ARM_REG_DWT_CTRL &= ~DWT_CYCCNTENA_BIT;
+    /* The DWT cycle counter is left running, the CLI commands are profiled
+     * with it. */
 }
 
 /*-----------------------------------------------------------*/
@@ -275,14 +292,14 @@ void UpdateTxLatency( uint64_t rtt )
 
 void GetCurrentCycleCount( uint32_t * cycleCount )
 {
-    *cycleCount = ARM_REG_DWT_CYCCNT;
+    *cycleCount = READ_CYCLE_COUNT();
 }
 
 /*-----------------------------------------------------------*/
 
 uint32_t GetElapsedCycles( uint32_t start )
 {
-    uint32_t currentCycleCount = ARM_REG_DWT_CYCCNT;
+    uint32_t currentCycleCount = READ_CYCLE_COUNT();
     return currentCycleCount - start;
 }
 
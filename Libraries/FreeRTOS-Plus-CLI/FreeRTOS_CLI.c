@@ -27,6 +27,8 @@
 /* Standard includes. */
 #include <string.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
@@ -49,6 +51,9 @@ typedef struct xCOMMAND_INPUT_LIST
 {
 	const CLI_Command_Definition_t *pxCommandLineDefinition;
 	struct xCOMMAND_INPUT_LIST *pxNext;
+	#if( configCLI_USE_PROFILING == 1 )
+		CLI_Command_Stats_t xStats;
+	#endif
 } CLI_Definition_List_Item_t;
 
 /*
@@ -57,11 +62,52 @@ typedef struct xCOMMAND_INPUT_LIST
  */
 static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
 
+/*
+ * Set *ppxDefinition to the next command listed by "help" in pxContext.
+ * Returns pdFALSE if it is the last one.
+ */
+static BaseType_t prvListCommands( CLI_Context_t *pxContext, const CLI_Command_Definition_t **ppxDefinition );
+
+/*
+ * Run the command interpreter in pxContext.  Without a writer, the output is
+ * written into pcWriteBuffer.  With a writer, the callbacks with a writer
+ * write to pxWriter, and the output written into pcWriteBuffer is then added
+ * to pxWriter.
+ */
+static BaseType_t prvProcessCommand( CLI_Context_t *pxContext, const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen, CLI_Writer_t *pxWriter );
+
+/*
+ * Add the output written into pcWriteBuffer to pxWriter, pcWriteBuffer having
+ * room for the terminator after its xWriteBufferLen bytes.
+ */
+static void prvWriteOutput( CLI_Writer_t *pxWriter, char *pcWriteBuffer, size_t xWriteBufferLen );
+
 /*
  * Return the number of parameters that follow the command name.
  */
 static int8_t prvGetNumberOfParameters( const char *pcCommandString );
 
+#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+
+	/*
+	 * Return the command of the static command table named by the first word
+	 * of pcCommandInput, or NULL if there is none.  Its index in the table is
+	 * written to *puxIndex.
+	 */
+	static const CLI_Command_Definition_t *prvFindStaticCommand( const char *pcCommandInput, UBaseType_t *puxIndex );
+
+#endif
+
+#if( configCLI_USE_PROFILING == 1 )
+
+	/*
+	 * Add a call of ulCycles cycles which wrote ulOutputBytes bytes to
+	 * pxStats.
+	 */
+	static void prvRecordCall( CLI_Command_Stats_t *pxStats, uint32_t ulCycles, uint32_t ulOutputBytes );
+
+#endif
+
 /* The definition of the "help" command.  This command is always at the front
 of the list of registered commands. */
 static const CLI_Command_Definition_t xHelpCommand =
@@ -69,7 +115,9 @@ static const CLI_Command_Definition_t xHelpCommand =
 	"help",
 	"\r\nhelp:\r\n Lists all the registered commands\r\n\r\n",
 	prvHelpCommand,
-	0
+	0,
+	NULL,
+	NULL
 };
 
 /* The definition of the list of commands.  Commands that are registered are
@@ -78,16 +126,17 @@ static CLI_Definition_List_Item_t xRegisteredCommands =
 {
 	&xHelpCommand,	/* The first command in the list is always the help command, defined in this file. */
 	NULL			/* The next pointer is initialised to NULL, as there are no other registered commands yet. */
+	#if( configCLI_USE_PROFILING == 1 )
+		, { 0 }		/* The help command has not been called yet. */
+	#endif
 };
 
 /* A buffer into which command outputs can be written is declared here, rather
 than in the command console implementation, to allow multiple command consoles
 to share the same buffer.  For example, an application may allow access to the
 command interpreter by UART and by Ethernet.  Sharing a buffer is done purely
-to save RAM.  Note, however, that the command console itself is not re-entrant,
-so only one command interpreter interface can be used at any one time.  For that
-reason, no attempt at providing mutual exclusion to the cOutputBuffer array is
-attempted.
+to save RAM.  It is the output buffer of the default context, and no attempt at
+providing mutual exclusion to the cOutputBuffer array is attempted.
 
 configAPPLICATION_PROVIDES_cOutputBuffer is provided to allow the application
 writer to provide their own cOutputBuffer declaration in cases where the
@@ -98,6 +147,11 @@ buffer needs to be placed at a fixed address (rather than by the linker). */
 	extern char cOutputBuffer[ configCOMMAND_INT_MAX_OUTPUT_SIZE ];
 #endif
 
+/* The context of the commands run by FreeRTOS_CLIProcessCommand().  It is
+set up by FreeRTOS_CLIInitContext() on first use, until which it is all zeros:
+no command and no "help" in progress. */
+static CLI_Context_t xDefaultContext;
+
 
 /*-----------------------------------------------------------*/
 
@@ -106,36 +160,58 @@ BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const p
 static CLI_Definition_List_Item_t *pxLastCommandInList = &xRegisteredCommands;
 CLI_Definition_List_Item_t *pxNewListItem;
 BaseType_t xReturn = pdFAIL;
+#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+	UBaseType_t uxIndex;
+#endif
 
 	/* Check the parameter is not NULL. */
 	configASSERT( pxCommandToRegister );
 
-	/* Create a new list item that will reference the command being registered. */
-	pxNewListItem = ( CLI_Definition_List_Item_t * ) pvPortMalloc( sizeof( CLI_Definition_List_Item_t ) );
-	configASSERT( pxNewListItem );
+	#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+	{
+		/* The commands of the static table need no list item. */
+		if( prvFindStaticCommand( pxCommandToRegister->pcCommand, &uxIndex ) == pxCommandToRegister )
+		{
+			xReturn = pdPASS;
+		}
+	}
+	#endif
 
-	if( pxNewListItem != NULL )
+	if( xReturn == pdFAIL )
 	{
-		taskENTER_CRITICAL();
+		/* Create a new list item that will reference the command being registered. */
+		pxNewListItem = ( CLI_Definition_List_Item_t * ) pvPortMalloc( sizeof( CLI_Definition_List_Item_t ) );
+		configASSERT( pxNewListItem );
+
+		if( pxNewListItem != NULL )
 		{
-			/* Reference the command being registered from the newly created
-			list item. */
-			pxNewListItem->pxCommandLineDefinition = pxCommandToRegister;
+			#if( configCLI_USE_PROFILING == 1 )
+			{
+				memset( &( pxNewListItem->xStats ), 0x00, sizeof( pxNewListItem->xStats ) );
+			}
+			#endif
 
-			/* The new list item will get added to the end of the list, so
-			pxNext has nowhere to point. */
-			pxNewListItem->pxNext = NULL;
+			taskENTER_CRITICAL();
+			{
+				/* Reference the command being registered from the newly created
+				list item. */
+				pxNewListItem->pxCommandLineDefinition = pxCommandToRegister;
 
-			/* Add the newly created list item to the end of the already existing
-			list. */
-			pxLastCommandInList->pxNext = pxNewListItem;
+				/* The new list item will get added to the end of the list, so
+				pxNext has nowhere to point. */
+				pxNewListItem->pxNext = NULL;
 
-			/* Set the end of list marker to the new list item. */
-			pxLastCommandInList = pxNewListItem;
-		}
-		taskEXIT_CRITICAL();
+				/* Add the newly created list item to the end of the already existing
+				list. */
+				pxLastCommandInList->pxNext = pxNewListItem;
+
+				/* Set the end of list marker to the new list item. */
+				pxLastCommandInList = pxNewListItem;
+			}
+			taskEXIT_CRITICAL();
 
-		xReturn = pdPASS;
+			xReturn = pdPASS;
+		}
 	}
 
 	return xReturn;
@@ -144,20 +220,103 @@ BaseType_t xReturn = pdFAIL;
 
 BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  )
 {
-static const CLI_Definition_List_Item_t *pxCommand = NULL;
-BaseType_t xReturn = pdTRUE;
+	/* Note:  The default context must not be used by more than one task. */
+	if( xDefaultContext.pcOutputBuffer == NULL )
+	{
+		FreeRTOS_CLIInitContext( &xDefaultContext, cOutputBuffer, configCOMMAND_INT_MAX_OUTPUT_SIZE );
+	}
+
+	return FreeRTOS_CLIProcessCommandWithContext( &xDefaultContext, pcCommandInput, pcWriteBuffer, xWriteBufferLen );
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLIInitContext( CLI_Context_t *pxContext, char *pcOutputBuffer, size_t xOutputBufferLength )
+{
+	pxContext->pxCommand = NULL;
+	pxContext->pxHelpListItem = NULL;
+	pxContext->uxNextStaticCommand = 0;
+	pxContext->pcOutputBuffer = pcOutputBuffer;
+	pxContext->xOutputBufferLength = xOutputBufferLength;
+
+	#if( configCLI_USE_PROFILING == 1 )
+	{
+		pxContext->pxStats = NULL;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIProcessCommandWithContext( CLI_Context_t *pxContext, const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen )
+{
+	return prvProcessCommand( pxContext, pcCommandInput, pcWriteBuffer, xWriteBufferLen, NULL );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIProcessCommandToWriter( CLI_Context_t *pxContext, const char * const pcCommandInput, CLI_Writer_t *pxWriter )
+{
+char *pcWriteBuffer = pxContext->pcOutputBuffer;
+
+	configASSERT( pcWriteBuffer != NULL );
+
+	/* Let a command that writes into a buffer write straight into the chunk
+	when a whole output fits in what is left of it.  One byte is kept for the
+	terminator in either buffer. */
+	if( ( pxWriter->xTruncated == pdFALSE ) && ( ( pxWriter->xBufferLength - pxWriter->xLength ) >= pxContext->xOutputBufferLength ) )
+	{
+		pcWriteBuffer = &( pxWriter->pcBuffer[ pxWriter->xLength ] );
+	}
+
+	return prvProcessCommand( pxContext, pcCommandInput, pcWriteBuffer, pxContext->xOutputBufferLength - 1, pxWriter );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvProcessCommand( CLI_Context_t *pxContext, const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen, CLI_Writer_t *pxWriter )
+{
+const CLI_Command_Definition_t *pxCommand = pxContext->pxCommand;
+const CLI_Command_Definition_t *pxDefinition;
+CLI_Definition_List_Item_t *pxListItem;
+BaseType_t xReturn = pdTRUE, xBufferOutput = pdTRUE;
 const char *pcRegisteredCommandString;
 size_t xCommandStringLength;
-
-	/* Note:  This function is not re-entrant.  It must not be called from more
-	thank one task. */
+CLI_Writer_t xBufferWriter;
+#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+	UBaseType_t uxIndex;
+#endif
+#if( configCLI_USE_PROFILING == 1 )
+	/* The call is measured from here, so the time taken to look the command
+	up is included. */
+	uint32_t ulStartCycles = configCLI_PROFILING_GET_CYCLES();
+	uint32_t ulStartLength = 0;
+	CLI_Command_Stats_t *pxStats = pxContext->pxStats;
+	size_t xOutputLength;
+
+	if( pxWriter != NULL )
+	{
+		ulStartLength = pxWriter->ulFlushedLength + ( uint32_t ) pxWriter->xLength;
+	}
+#endif
 
 	if( pxCommand == NULL )
 	{
+		#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+		{
+			pxCommand = prvFindStaticCommand( pcCommandInput, &uxIndex );
+
+			#if( configCLI_USE_PROFILING == 1 )
+			{
+				if( pxCommand != NULL )
+				{
+					pxStats = &( xCLIStaticCommandTable.pxStats[ uxIndex ] );
+				}
+			}
+			#endif
+		}
+		#endif
+
 		/* Search for the command string in the list of registered commands. */
-		for( pxCommand = &xRegisteredCommands; pxCommand != NULL; pxCommand = pxCommand->pxNext )
+		for( pxListItem = &xRegisteredCommands; ( pxCommand == NULL ) && ( pxListItem != NULL ); pxListItem = pxListItem->pxNext )
 		{
-			pcRegisteredCommandString = pxCommand->pxCommandLineDefinition->pcCommand;
+			pcRegisteredCommandString = pxListItem->pxCommandLineDefinition->pcCommand;
 			xCommandStringLength = strlen( pcRegisteredCommandString );
 
 			/* To ensure the string lengths match exactly, so as not to pick up
@@ -168,22 +327,42 @@ size_t xCommandStringLength;
 			{
 				if( ( pcCommandInput[ xCommandStringLength ] == ' ' ) || ( pcCommandInput[ xCommandStringLength ] == 0x00 ) )
 				{
-					/* The command has been found.  Check it has the expected
-					number of parameters.  If cExpectedNumberOfParameters is -1,
-					then there could be a variable number of parameters and no
-					check is made. */
-					if( pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters >= 0 )
+					pxCommand = pxListItem->pxCommandLineDefinition;
+
+					#if( configCLI_USE_PROFILING == 1 )
 					{
-						if( prvGetNumberOfParameters( pcCommandInput ) != pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters )
-						{
-							xReturn = pdFALSE;
-						}
+						pxStats = &( pxListItem->xStats );
 					}
-
-					break;
+					#endif
 				}
 			}
 		}
+
+		/* If the command has been found, check it has the expected number of
+		parameters.  If cExpectedNumberOfParameters is -1, then there could be
+		a variable number of parameters and no check is made.  The command line
+		of an argument vector command is split here, once, and the words are
+		kept in the context until the command completes. */
+		if( ( pxCommand != NULL ) && ( pxCommand->pxCommandInterpreter == NULL ) )
+		{
+			pxContext->xArgc = FreeRTOS_CLITokenize( pcCommandInput, pxContext->cArgumentBuffer, sizeof( pxContext->cArgumentBuffer ), pxContext->pcArgv, configCLI_MAX_ARGUMENTS );
+
+			if( pxContext->xArgc < 1 )
+			{
+				xReturn = pdFALSE;
+			}
+			else if( ( pxCommand->cExpectedNumberOfParameters >= 0 ) && ( ( pxContext->xArgc - 1 ) != pxCommand->cExpectedNumberOfParameters ) )
+			{
+				xReturn = pdFALSE;
+			}
+		}
+		else if( ( pxCommand != NULL ) && ( pxCommand->cExpectedNumberOfParameters >= 0 ) )
+		{
+			if( prvGetNumberOfParameters( pcCommandInput ) != pxCommand->cExpectedNumberOfParameters )
+			{
+				xReturn = pdFALSE;
+			}
+		}
 	}
 
 	if( ( pxCommand != NULL ) && ( xReturn == pdFALSE ) )
@@ -192,11 +371,68 @@ size_t xCommandStringLength;
 		was incorrect. */
 		strncpy( pcWriteBuffer, "Incorrect command parameter(s).  Enter \"help\" to view a list of available commands.\r\n\r\n", xWriteBufferLen );
 		pxCommand = NULL;
+
+		#if( configCLI_USE_PROFILING == 1 )
+		{
+			/* The command is not called. */
+			pxStats = NULL;
+		}
+		#endif
+	}
+	else if( pxCommand == &xHelpCommand )
+	{
+		/* "help" keeps the position of the listing in the context, rather than
+		in prvHelpCommand().  With a writer, the whole list is written in one
+		call. */
+		if( pxWriter == NULL )
+		{
+			xReturn = prvListCommands( pxContext, &pxDefinition );
+			strncpy( pcWriteBuffer, pxDefinition->pcHelpString, xWriteBufferLen );
+		}
+		else
+		{
+			do
+			{
+				xReturn = prvListCommands( pxContext, &pxDefinition );
+				FreeRTOS_CLIWrite( pxWriter, pxDefinition->pcHelpString, strlen( pxDefinition->pcHelpString ) );
+			} while( xReturn == pdTRUE );
+
+			xBufferOutput = pdFALSE;
+		}
+
+		if( xReturn == pdFALSE )
+		{
+			pxCommand = NULL;
+		}
 	}
 	else if( pxCommand != NULL )
 	{
 		/* Call the callback function that is registered to this command. */
-		xReturn = pxCommand->pxCommandLineDefinition->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
+		if( pxCommand->pxCommandInterpreter != NULL )
+		{
+			xReturn = pxCommand->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
+		}
+		else if( pxCommand->pxArgvCommandInterpreter != NULL )
+		{
+			xReturn = pxCommand->pxArgvCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pxContext->xArgc, pxContext->pcArgv );
+		}
+		else
+		{
+			/* Without a writer, the output is limited to pcWriteBuffer. */
+			if( pxWriter == NULL )
+			{
+				FreeRTOS_CLIInitWriter( &xBufferWriter, pcWriteBuffer, xWriteBufferLen - 1, NULL, NULL );
+				pxCommand->pxWriterCommandInterpreter( &xBufferWriter, pxContext->xArgc, pxContext->pcArgv );
+				pcWriteBuffer[ xBufferWriter.xLength ] = 0x00;
+			}
+			else
+			{
+				pxCommand->pxWriterCommandInterpreter( pxWriter, pxContext->xArgc, pxContext->pcArgv );
+				xBufferOutput = pdFALSE;
+			}
+
+			xReturn = pdFALSE;
+		}
 
 		/* If xReturn is pdFALSE, then no further strings will be returned
 		after this one, and	pxCommand can be reset to NULL ready to search
@@ -213,16 +449,195 @@ size_t xCommandStringLength;
 		xReturn = pdFALSE;
 	}
 
+	pxContext->pxCommand = pxCommand;
+
+	if( ( pxWriter != NULL ) && ( xBufferOutput == pdTRUE ) )
+	{
+		prvWriteOutput( pxWriter, pcWriteBuffer, xWriteBufferLen );
+	}
+
+	#if( configCLI_USE_PROFILING == 1 )
+	{
+		if( pxStats != NULL )
+		{
+			if( pxWriter != NULL )
+			{
+				xOutputLength = ( size_t ) ( ( pxWriter->ulFlushedLength + ( uint32_t ) pxWriter->xLength ) - ulStartLength );
+			}
+			else
+			{
+				/* The output may fill pcWriteBuffer without a terminator. */
+				xOutputLength = 0;
+
+				while( ( xOutputLength < xWriteBufferLen ) && ( pcWriteBuffer[ xOutputLength ] != 0x00 ) )
+				{
+					xOutputLength++;
+				}
+			}
+
+			prvRecordCall( pxStats, configCLI_PROFILING_GET_CYCLES() - ulStartCycles, ( uint32_t ) xOutputLength );
+		}
+
+		/* Kept for the next call of a command still in progress. */
+		pxContext->pxStats = ( pxCommand != NULL ) ? pxStats : NULL;
+	}
+	#endif
+
 	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
+static void prvWriteOutput( CLI_Writer_t *pxWriter, char *pcWriteBuffer, size_t xWriteBufferLen )
+{
+size_t xLength;
+
+	/* Ensure null termination so that the strlen below does not end up
+	reading past bounds. */
+	pcWriteBuffer[ xWriteBufferLen ] = 0x00;
+	xLength = strlen( pcWriteBuffer );
+
+	if( pcWriteBuffer == &( pxWriter->pcBuffer[ pxWriter->xLength ] ) )
+	{
+		/* The output was written straight into the chunk. */
+		FreeRTOS_CLIWriterCommit( pxWriter, xLength );
+	}
+	else
+	{
+		FreeRTOS_CLIWrite( pxWriter, pcWriteBuffer, xLength );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLIInitWriter( CLI_Writer_t *pxWriter, char *pcBuffer, size_t xBufferLength, void ( *pxFlush )( CLI_Writer_t *pxWriter ), void *pvOwner )
+{
+	pxWriter->pcBuffer = pcBuffer;
+	pxWriter->xBufferLength = xBufferLength;
+	pxWriter->xLength = 0;
+	pxWriter->pxFlush = pxFlush;
+	pxWriter->pvOwner = pvOwner;
+	pxWriter->xTruncated = pdFALSE;
+	pxWriter->ulFlushedLength = 0;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLIWrite( CLI_Writer_t *pxWriter, const char *pcData, size_t xLength )
+{
+size_t xSpace, xCopyLength;
+
+	while( ( xLength > 0 ) && ( pxWriter->xTruncated == pdFALSE ) )
+	{
+		xSpace = pxWriter->xBufferLength - pxWriter->xLength;
+
+		if( xSpace == 0 )
+		{
+			FreeRTOS_CLIWriterFlush( pxWriter );
+
+			if( pxWriter->xLength == pxWriter->xBufferLength )
+			{
+				/* There is no next chunk. */
+				pxWriter->xTruncated = pdTRUE;
+			}
+		}
+		else
+		{
+			xCopyLength = ( xLength < xSpace ) ? xLength : xSpace;
+			memcpy( &( pxWriter->pcBuffer[ pxWriter->xLength ] ), pcData, xCopyLength );
+			pxWriter->xLength += xCopyLength;
+			pcData += xCopyLength;
+			xLength -= xCopyLength;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLIPrintf( CLI_Writer_t *pxWriter, const char *pcFormat, ... )
+{
+va_list xArguments;
+int iLength;
+size_t xSpace;
+BaseType_t xAttempt;
+
+	/* The output is formatted at most twice, the second time in an empty
+	chunk. */
+	for( xAttempt = 0; ( xAttempt < 2 ) && ( pxWriter->xTruncated == pdFALSE ); xAttempt++ )
+	{
+		xSpace = pxWriter->xBufferLength - pxWriter->xLength;
+
+		va_start( xArguments, pcFormat );
+		iLength = vsnprintf( &( pxWriter->pcBuffer[ pxWriter->xLength ] ), xSpace, pcFormat, xArguments );
+		va_end( xArguments );
+
+		if( iLength < 0 )
+		{
+			/* Encoding error, nothing is written. */
+			break;
+		}
+		else if( ( size_t ) iLength < xSpace )
+		{
+			/* The output and its terminator fit, the terminator is not kept. */
+			pxWriter->xLength += ( size_t ) iLength;
+			break;
+		}
+		else if( ( pxWriter->xLength > 0 ) && ( pxWriter->pxFlush != NULL ) )
+		{
+			/* Try again in the next chunk. */
+			FreeRTOS_CLIWriterFlush( pxWriter );
+		}
+		else
+		{
+			/* Longer than what can be given to it, keep what was written of
+			it. */
+			if( xSpace > 0 )
+			{
+				pxWriter->xLength += xSpace - 1;
+			}
+
+			pxWriter->xTruncated = pdTRUE;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+char *FreeRTOS_CLIWriterGetSpace( CLI_Writer_t *pxWriter, size_t *pxSpaceLength )
+{
+	*pxSpaceLength = ( pxWriter->xTruncated == pdFALSE ) ? ( pxWriter->xBufferLength - pxWriter->xLength ) : 0;
+
+	return &( pxWriter->pcBuffer[ pxWriter->xLength ] );
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLIWriterCommit( CLI_Writer_t *pxWriter, size_t xLength )
+{
+	configASSERT( xLength <= ( pxWriter->xBufferLength - pxWriter->xLength ) );
+
+	pxWriter->xLength += xLength;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLIWriterFlush( CLI_Writer_t *pxWriter )
+{
+	/* Without pxFlush, the bytes stay in the only chunk. */
+	if( pxWriter->pxFlush != NULL )
+	{
+		pxWriter->ulFlushedLength += ( uint32_t ) pxWriter->xLength;
+		pxWriter->pxFlush( pxWriter );
+		pxWriter->xLength = 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
 char *FreeRTOS_CLIGetOutputBuffer( void )
 {
 	return cOutputBuffer;
 }
 /*-----------------------------------------------------------*/
 
+char *FreeRTOS_CLIGetContextOutputBuffer( CLI_Context_t *pxContext )
+{
+	return pxContext->pcOutputBuffer;
+}
+/*-----------------------------------------------------------*/
+
 const char *FreeRTOS_CLIGetParameter( const char *pcCommandString, UBaseType_t uxWantedParameter, BaseType_t *pxParameterStringLength )
 {
 UBaseType_t uxParametersFound = 0;
@@ -279,25 +694,151 @@ const char *pcReturn = NULL;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t FreeRTOS_CLITokenize( const char *pcCommandString, char *pcBuffer, size_t xBufferLength, const char **ppcArgv, BaseType_t xMaxArguments )
+{
+BaseType_t xArgc = 0, xInWord = pdFALSE, xInQuotes = pdFALSE, xError = pdFALSE;
+size_t xLength = 0;
+const char *pcCharacter;
+
+	for( pcCharacter = pcCommandString; ( *pcCharacter != 0x00 ) && ( xError == pdFALSE ); pcCharacter++ )
+	{
+		if( ( *pcCharacter == ' ' ) && ( xInQuotes == pdFALSE ) )
+		{
+			if( xInWord == pdTRUE )
+			{
+				/* The space ends the word.  There is always room for its
+				terminator, as room is kept for it below. */
+				pcBuffer[ xLength ] = 0x00;
+				xLength++;
+				xInWord = pdFALSE;
+			}
+		}
+		else
+		{
+			if( xInWord == pdFALSE )
+			{
+				/* The word needs at least the room of its terminator. */
+				if( ( xArgc < xMaxArguments ) && ( xLength < xBufferLength ) )
+				{
+					ppcArgv[ xArgc ] = &( pcBuffer[ xLength ] );
+					xArgc++;
+					xInWord = pdTRUE;
+				}
+				else
+				{
+					xError = pdTRUE;
+				}
+			}
+
+			if( *pcCharacter == '"' )
+			{
+				/* The quotes are not part of the word. */
+				xInQuotes = ( xInQuotes == pdFALSE ) ? pdTRUE : pdFALSE;
+			}
+			else if( ( xLength + 1 ) < xBufferLength )
+			{
+				/* Keep one byte for the terminator of the word. */
+				pcBuffer[ xLength ] = *pcCharacter;
+				xLength++;
+			}
+			else
+			{
+				xError = pdTRUE;
+			}
+		}
+	}
+
+	if( ( xError == pdTRUE ) || ( xInQuotes == pdTRUE ) )
+	{
+		xArgc = -1;
+	}
+	else if( xInWord == pdTRUE )
+	{
+		pcBuffer[ xLength ] = 0x00;
+	}
+
+	return xArgc;
+}
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
 {
-static const CLI_Definition_List_Item_t * pxCommand = NULL;
+const CLI_Command_Definition_t *pxDefinition;
 BaseType_t xReturn;
 
+	/* prvProcessCommand() lists the commands itself, this is only reached
+	when the help command is called directly. */
 	( void ) pcCommandString;
 
-	if( pxCommand == NULL )
+	xReturn = prvListCommands( &xDefaultContext, &pxDefinition );
+	strncpy( pcWriteBuffer, pxDefinition->pcHelpString, xWriteBufferLen );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvListCommands( CLI_Context_t *pxContext, const CLI_Command_Definition_t **ppxDefinition )
+{
+const CLI_Definition_List_Item_t * pxCommand = pxContext->pxHelpListItem;
+const CLI_Command_Definition_t *pxDefinition = NULL;
+BaseType_t xStaticCommandsLeft = pdFALSE, xReturn;
+#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+	/* The commands of the static table are listed after the registered ones.
+	One more than the index of the next one to list, 0 while the registered
+	commands are being listed. */
+	UBaseType_t uxNextStaticCommand = pxContext->uxNextStaticCommand;
+#endif
+
+	#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
 	{
-		/* Reset the pxCommand pointer back to the start of the list. */
-		pxCommand = &xRegisteredCommands;
+		if( uxNextStaticCommand != 0 )
+		{
+			pxDefinition = xCLIStaticCommandTable.ppxCommands[ uxNextStaticCommand - 1 ];
+			uxNextStaticCommand++;
+		}
 	}
+	#endif
 
-	/* Return the next command help string, before moving the pointer on to
-	the next command in the list. */
-	strncpy( pcWriteBuffer, pxCommand->pxCommandLineDefinition->pcHelpString, xWriteBufferLen );
-	pxCommand = pxCommand->pxNext;
+	if( pxDefinition == NULL )
+	{
+		if( pxCommand == NULL )
+		{
+			/* Reset the pxCommand pointer back to the start of the list. */
+			pxCommand = &xRegisteredCommands;
+		}
 
-	if( pxCommand == NULL )
+		/* Return the next command help string, before moving the pointer on
+		to the next command in the list. */
+		pxDefinition = pxCommand->pxCommandLineDefinition;
+		pxCommand = pxCommand->pxNext;
+
+		#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+		{
+			if( pxCommand == NULL )
+			{
+				uxNextStaticCommand = 1;
+			}
+		}
+		#endif
+	}
+
+	*ppxDefinition = pxDefinition;
+
+	#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+	{
+		if( uxNextStaticCommand > xCLIStaticCommandTable.uxCommandCount )
+		{
+			/* All the commands have been listed. */
+			uxNextStaticCommand = 0;
+		}
+		else if( uxNextStaticCommand != 0 )
+		{
+			xStaticCommandsLeft = pdTRUE;
+		}
+	}
+	#endif
+
+	if( ( pxCommand == NULL ) && ( xStaticCommandsLeft == pdFALSE ) )
 	{
 		/* There are no more commands in the list, so there will be no more
 		strings to return after this one and pdFALSE should be returned. */
@@ -308,6 +849,14 @@ BaseType_t xReturn;
 		xReturn = pdTRUE;
 	}
 
+	pxContext->pxHelpListItem = pxCommand;
+
+	#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+	{
+		pxContext->uxNextStaticCommand = uxNextStaticCommand;
+	}
+	#endif
+
 	return xReturn;
 }
 /*-----------------------------------------------------------*/
@@ -347,4 +896,116 @@ BaseType_t xLastCharacterWasSpace = pdFALSE;
 	as the first word should be the command itself. */
 	return cParameters;
 }
+/*-----------------------------------------------------------*/
+
+#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+
+	static const CLI_Command_Definition_t *prvFindStaticCommand( const char *pcCommandInput, UBaseType_t *puxIndex )
+	{
+	const CLI_Command_Definition_t *pxCommand = NULL;
+	uint32_t ulHash = 2166136261UL ^ xCLIStaticCommandTable.ulSeed;
+	size_t xLength = 0;
+	uint8_t ucSlot;
+
+		/* Hash the first word, the command itself. */
+		while( ( pcCommandInput[ xLength ] != 0x00 ) && ( pcCommandInput[ xLength ] != ' ' ) )
+		{
+			ulHash = ( ulHash ^ ( uint8_t ) pcCommandInput[ xLength ] ) * 16777619UL;
+			xLength++;
+		}
+
+		ucSlot = xCLIStaticCommandTable.pucSlots[ ulHash & xCLIStaticCommandTable.ulMask ];
+
+		if( ucSlot != 0 )
+		{
+			/* The only command which can match, if the word is a command of
+			the table at all. */
+			pxCommand = xCLIStaticCommandTable.ppxCommands[ ucSlot - 1 ];
+			*puxIndex = ( UBaseType_t ) ucSlot - 1U;
+
+			if( ( strncmp( pcCommandInput, pxCommand->pcCommand, xLength ) != 0 ) || ( pxCommand->pcCommand[ xLength ] != 0x00 ) )
+			{
+				pxCommand = NULL;
+			}
+		}
+
+		return pxCommand;
+	}
+
+#endif /* configCLI_USE_STATIC_COMMAND_TABLE */
+/*-----------------------------------------------------------*/
+
+#if( configCLI_USE_PROFILING == 1 )
+
+	static void prvRecordCall( CLI_Command_Stats_t *pxStats, uint32_t ulCycles, uint32_t ulOutputBytes )
+	{
+	UBaseType_t uxBucket = 0;
+	uint32_t ulBucketCycles = ulCycles >> configCLI_PROFILING_HISTOGRAM_FIRST_BITS;
+
+		/* The log2 bucket of the call, the last one taking all the longer
+		calls. */
+		while( ( ulBucketCycles != 0UL ) && ( uxBucket < ( configCLI_PROFILING_HISTOGRAM_BUCKETS - 1 ) ) )
+		{
+			ulBucketCycles >>= configCLI_PROFILING_HISTOGRAM_STEP_BITS;
+			uxBucket++;
+		}
 
+		/* Several consoles may run the same command at the same time. */
+		taskENTER_CRITICAL();
+		{
+			pxStats->ulCalls++;
+			pxStats->ullTotalCycles += ulCycles;
+			pxStats->ulOutputBytes += ulOutputBytes;
+			pxStats->ulHistogram[ uxBucket ]++;
+
+			if( ulCycles > pxStats->ulMaxCycles )
+			{
+				pxStats->ulMaxCycles = ulCycles;
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t FreeRTOS_CLIGetCommandStats( UBaseType_t uxIndex, const CLI_Command_Definition_t **ppxCommand, CLI_Command_Stats_t *pxStats )
+	{
+	const CLI_Definition_List_Item_t *pxListItem = &xRegisteredCommands;
+	const CLI_Command_Stats_t *pxCommandStats = NULL;
+
+		/* The registered commands come first, as "help" lists them. */
+		while( ( pxListItem != NULL ) && ( uxIndex > 0 ) )
+		{
+			pxListItem = pxListItem->pxNext;
+			uxIndex--;
+		}
+
+		if( pxListItem != NULL )
+		{
+			*ppxCommand = pxListItem->pxCommandLineDefinition;
+			pxCommandStats = &( pxListItem->xStats );
+		}
+
+		#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+		{
+			if( ( pxListItem == NULL ) && ( uxIndex < xCLIStaticCommandTable.uxCommandCount ) )
+			{
+				*ppxCommand = xCLIStaticCommandTable.ppxCommands[ uxIndex ];
+				pxCommandStats = &( xCLIStaticCommandTable.pxStats[ uxIndex ] );
+			}
+		}
+		#endif
+
+		if( pxCommandStats != NULL )
+		{
+			taskENTER_CRITICAL();
+			{
+				*pxStats = *pxCommandStats;
+			}
+			taskEXIT_CRITICAL();
+		}
+
+		return ( pxCommandStats != NULL ) ? pdTRUE : pdFALSE;
+	}
+
+#endif /* configCLI_USE_PROFILING */
+/*-----------------------------------------------------------*/
@@ -40,6 +40,36 @@ the pcWriteBuffer buffer, and pcCommandString is the entire string as input by
 the user (from which parameters can be extracted).*/
 typedef BaseType_t (*pdCOMMAND_LINE_CALLBACK)( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
 
+/* The prototype of the callback functions that take the command line as an
+argument vector, which is split once by the command interpreter rather than by
+each call to FreeRTOS_CLIGetParameter().  ppcArgv[ 0 ] is the command itself and
+ppcArgv[ 1 ] to ppcArgv[ xArgc - 1 ] are its parameters, each a NUL terminated
+string with its quotes removed. */
+typedef BaseType_t (*pdCOMMAND_LINE_ARGV_CALLBACK)( char *pcWriteBuffer, size_t xWriteBufferLen, BaseType_t xArgc, const char * const *ppcArgv );
+
+/* A writer the output of a command is streamed to.  The output is written
+straight into the chunk pcBuffer, and when the chunk is full pxFlush is called
+to hand its xLength bytes over to the owner of the writer.  pxFlush then sets
+pcBuffer and xBufferLength to the next chunk, with an xBufferLength of 0 if
+there is none.  A writer with a NULL pxFlush only has one chunk.  Output which
+does not fit is dropped, and xTruncated is set.  A writer is set up with
+FreeRTOS_CLIInitWriter(). */
+typedef struct xCLI_WRITER
+{
+	char *pcBuffer;										/* The chunk being written. */
+	size_t xBufferLength;								/* The size, in bytes, of pcBuffer. */
+	size_t xLength;										/* The number of bytes written in pcBuffer so far. */
+	void ( *pxFlush )( struct xCLI_WRITER *pxWriter );	/* Hands the chunk over and sets the next one, may be NULL. */
+	void *pvOwner;										/* Free for the owner of the writer. */
+	BaseType_t xTruncated;								/* Set once output has been dropped. */
+	uint32_t ulFlushedLength;							/* The number of bytes handed over by pxFlush so far. */
+} CLI_Writer_t;
+
+/* The prototype of the callback functions that write their whole output to a
+writer in one call, so the output is not limited by configCOMMAND_INT_MAX_OUTPUT_SIZE.
+The parameters are those of pdCOMMAND_LINE_ARGV_CALLBACK. */
+typedef void (*pdCOMMAND_LINE_WRITER_CALLBACK)( CLI_Writer_t *pxWriter, BaseType_t xArgc, const char * const *ppcArgv );
+
 /* The structure that defines command line commands.  A command line command
 should be defined by declaring a const structure of this type. */
 typedef struct xCOMMAND_LINE_INPUT
@@ -48,16 +78,127 @@ typedef struct xCOMMAND_LINE_INPUT
 	const char * const pcHelpString;			/* String that describes how to use the command.  Should start with the command itself, and end with "\r\n".  For example "help: Returns a list of all the commands\r\n". */
 	const pdCOMMAND_LINE_CALLBACK pxCommandInterpreter;	/* A pointer to the callback function that will return the output generated by the command. */
 	int8_t cExpectedNumberOfParameters;			/* Commands expect a fixed number of parameters, which may be zero. */
+	const pdCOMMAND_LINE_ARGV_CALLBACK pxArgvCommandInterpreter;	/* Called with the argument vector of the command when pxCommandInterpreter is NULL, NULL otherwise. */
+	const pdCOMMAND_LINE_WRITER_CALLBACK pxWriterCommandInterpreter;	/* Called with a writer when the two callbacks above are NULL, NULL otherwise. */
 } CLI_Command_Definition_t;
 
 /* For backward compatibility. */
 #define xCommandLineInput CLI_Command_Definition_t
 
+/* Set configCLI_USE_PROFILING to 1 in FreeRTOSConfig.h to keep, for every
+command, the statistics below of the calls made to it by the command
+interpreter.  configCLI_PROFILING_GET_CYCLES() must then return a free running
+32-bit cycle count, for example the DWT cycle counter of a Cortex-M, and a
+call is measured from the start to the end of the FreeRTOS_CLIProcessCommand()
+call that makes it.  A call longer than a wrap of the counter is not measured
+correctly.
+
+The latency histogram has configCLI_PROFILING_HISTOGRAM_BUCKETS buckets.  The
+first one counts the calls shorter than 2 ^ configCLI_PROFILING_HISTOGRAM_FIRST_BITS
+cycles, each following one the calls up to 2 ^ configCLI_PROFILING_HISTOGRAM_STEP_BITS
+times longer than those of the bucket before it, and the last one all the
+longer calls. */
+#ifndef configCLI_USE_PROFILING
+	#define configCLI_USE_PROFILING 0
+#endif
+
+#ifndef configCLI_PROFILING_HISTOGRAM_BUCKETS
+	#define configCLI_PROFILING_HISTOGRAM_BUCKETS 8
+#endif
+
+#ifndef configCLI_PROFILING_HISTOGRAM_FIRST_BITS
+	#define configCLI_PROFILING_HISTOGRAM_FIRST_BITS 10
+#endif
+
+#ifndef configCLI_PROFILING_HISTOGRAM_STEP_BITS
+	#define configCLI_PROFILING_HISTOGRAM_STEP_BITS 2
+#endif
+
+#if( ( configCLI_USE_PROFILING == 1 ) && !defined( configCLI_PROFILING_GET_CYCLES ) )
+	#error configCLI_PROFILING_GET_CYCLES() must be defined in FreeRTOSConfig.h when configCLI_USE_PROFILING is 1
+#endif
+
+/* The statistics of one command.  A command which writes its output over
+several calls, returning pdTRUE, counts one call for each of them. */
+typedef struct xCLI_COMMAND_STATS
+{
+	uint32_t ulCalls;							/* Number of calls made to the command. */
+	uint64_t ullTotalCycles;					/* Cycles spent in all the calls. */
+	uint32_t ulMaxCycles;						/* Cycles spent in the longest call. */
+	uint32_t ulOutputBytes;						/* Bytes of output written by all the calls. */
+	uint32_t ulHistogram[ configCLI_PROFILING_HISTOGRAM_BUCKETS ];	/* Number of calls in each latency bucket. */
+} CLI_Command_Stats_t;
+
+/* Set configCLI_USE_STATIC_COMMAND_TABLE to 1 in FreeRTOSConfig.h to look the
+commands up in a const table built with the application, as well as in the
+list of registered commands.  The application then defines the table with the
+following name, usually generated at build time:
+	const CLI_Static_Command_Table_t xCLIStaticCommandTable;
+A command of the table is found with a single probe of a perfect hash, and
+registering it does not allocate.  Commands outside the table are registered
+and looked up as usual.
+
+The hash of a command is the 32-bit FNV-1a hash of its characters, starting
+from 2166136261 XOR ulSeed.  The slot of a command is its hash AND ulMask, and
+ulSeed is chosen so that no two commands of the table share a slot. */
+#ifndef configCLI_USE_STATIC_COMMAND_TABLE
+	#define configCLI_USE_STATIC_COMMAND_TABLE 0
+#endif
+
+typedef struct xCLI_STATIC_COMMAND_TABLE
+{
+	const CLI_Command_Definition_t * const * ppxCommands;	/* The commands, in the order "help" lists them. */
+	UBaseType_t uxCommandCount;					/* Number of entries in ppxCommands. */
+	const uint8_t * pucSlots;					/* For each slot, one more than the index in ppxCommands of the command hashing to it, 0 if none. */
+	uint32_t ulMask;							/* Number of slots minus one, the number of slots being a power of two. */
+	uint32_t ulSeed;							/* Seed of the hash. */
+	CLI_Command_Stats_t * pxStats;				/* The statistics of the commands, in the order of ppxCommands.  NULL if configCLI_USE_PROFILING is 0. */
+} CLI_Static_Command_Table_t;
+
+#if( configCLI_USE_STATIC_COMMAND_TABLE == 1 )
+	extern const CLI_Static_Command_Table_t xCLIStaticCommandTable;
+#endif
+
+/* The command line of a command with an argument vector callback is split into
+at most configCLI_MAX_ARGUMENTS words, the command included, which are copied
+with their NUL terminators into a buffer of configCLI_ARGUMENT_BUFFER_SIZE
+bytes.  Words are separated by spaces, and a double quoted part of a word may
+contain spaces.  A command line which does not fit gets the "Incorrect command
+parameter(s)" response. */
+#ifndef configCLI_MAX_ARGUMENTS
+	#define configCLI_MAX_ARGUMENTS 8
+#endif
+
+#ifndef configCLI_ARGUMENT_BUFFER_SIZE
+	#define configCLI_ARGUMENT_BUFFER_SIZE 128
+#endif
+
+/* The state of the command interpreter for one command console.  Each console
+that can run a command at the same time as another one, for example a UART and
+a network console, runs its commands in its own context.  The members are
+private to the command interpreter, a context is set up with
+FreeRTOS_CLIInitContext(). */
+typedef struct xCLI_CONTEXT
+{
+	const CLI_Command_Definition_t *pxCommand;			/* The command that returned pdTRUE and so is still in progress, NULL if none. */
+	const struct xCOMMAND_INPUT_LIST *pxHelpListItem;	/* The next registered command listed by an in progress "help". */
+	UBaseType_t uxNextStaticCommand;					/* One more than the index of the next static command listed by "help", 0 if none. */
+	char *pcOutputBuffer;								/* The buffer returned by FreeRTOS_CLIGetContextOutputBuffer(), may be NULL. */
+	size_t xOutputBufferLength;							/* The size, in bytes, of pcOutputBuffer. */
+	BaseType_t xArgc;									/* Number of words in pcArgv while an argument vector command is in progress. */
+	const char *pcArgv[ configCLI_MAX_ARGUMENTS ];		/* The words of the command in progress, pointing into cArgumentBuffer. */
+	char cArgumentBuffer[ configCLI_ARGUMENT_BUFFER_SIZE ];
+	#if( configCLI_USE_PROFILING == 1 )
+		CLI_Command_Stats_t *pxStats;					/* The statistics of pxCommand. */
+	#endif
+} CLI_Context_t;
+
 /*
  * Register the command passed in using the pxCommandToRegister parameter.
  * Registering a command adds the command to the list of commands that are
  * handled by the command interpreter.  Once a command has been registered it
- * can be executed from the command line.
+ * can be executed from the command line.  A command of the static command
+ * table is already handled, registering it does nothing.
  */
 BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister );
 
@@ -69,31 +210,120 @@ BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const p
  *
  * FreeRTOS_CLIProcessCommand should be called repeatedly until it returns pdFALSE.
  *
- * pcCmdIntProcessCommand is not reentrant.  It must not be called from more
- * than one task - or at least - by more than one task at a time.
+ * FreeRTOS_CLIProcessCommand runs the command in the default context of the
+ * command interpreter.  It must not be called from more than one task - or at
+ * least - by more than one task at a time.
  */
 BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  );
 
+/*
+ * Set up pxContext, with no command in progress.  pcOutputBuffer, which may be
+ * NULL, is the xOutputBufferLength bytes buffer the console of the context
+ * writes the output of its commands into.
+ */
+void FreeRTOS_CLIInitContext( CLI_Context_t *pxContext, char *pcOutputBuffer, size_t xOutputBufferLength );
+
+/*
+ * As FreeRTOS_CLIProcessCommand(), but keeps the state of a command that
+ * returns pdTRUE in pxContext rather than in the default context.  Commands
+ * can then be in progress in several contexts at the same time, for example
+ * "help" on a UART console while another one lists it on a network console.
+ *
+ * A context must only be used by one task at a time.  The callback functions
+ * of the commands are shared by all the contexts, so a command with state of
+ * its own must still not be run in two contexts at the same time.
+ */
+BaseType_t FreeRTOS_CLIProcessCommandWithContext( CLI_Context_t *pxContext, const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen );
+
+/*
+ * As FreeRTOS_CLIProcessCommandWithContext(), but streams the output to
+ * pxWriter, and should also be called repeatedly until it returns pdFALSE.
+ * The callbacks with a writer write to pxWriter directly.  Any other output is
+ * written straight into the chunk of pxWriter when the output buffer of
+ * pxContext would fit in what is left of the chunk, and is otherwise written
+ * into the output buffer of pxContext and copied to pxWriter.  The output
+ * buffer of pxContext must not be NULL.
+ *
+ * The last chunk is not handed over, FreeRTOS_CLIWriterFlush() does it.
+ */
+BaseType_t FreeRTOS_CLIProcessCommandToWriter( CLI_Context_t *pxContext, const char * const pcCommandInput, CLI_Writer_t *pxWriter );
+
+/*
+ * Set up pxWriter to write into the xBufferLength bytes chunk pcBuffer.
+ */
+void FreeRTOS_CLIInitWriter( CLI_Writer_t *pxWriter, char *pcBuffer, size_t xBufferLength, void ( *pxFlush )( CLI_Writer_t *pxWriter ), void *pvOwner );
+
+/*
+ * Write the xLength bytes of pcData, flushing the chunks they fill.
+ */
+void FreeRTOS_CLIWrite( CLI_Writer_t *pxWriter, const char *pcData, size_t xLength );
+
+/*
+ * Write formatted output as snprintf() does, without the NUL terminator.  A
+ * formatted output which does not fit in what is left of the chunk is
+ * formatted again in the next chunk, so it is never split across two chunks.
+ * One which does not fit in a whole chunk is truncated.
+ */
+void FreeRTOS_CLIPrintf( CLI_Writer_t *pxWriter, const char *pcFormat, ... );
+
+/*
+ * Return the part of the chunk that is left, and its size in *pxSpaceLength,
+ * for output produced by a function that writes into a buffer.  The bytes
+ * written there are then added with FreeRTOS_CLIWriterCommit().
+ */
+char *FreeRTOS_CLIWriterGetSpace( CLI_Writer_t *pxWriter, size_t *pxSpaceLength );
+void FreeRTOS_CLIWriterCommit( CLI_Writer_t *pxWriter, size_t xLength );
+
+/*
+ * Hand the bytes written in the current chunk over.
+ */
+void FreeRTOS_CLIWriterFlush( CLI_Writer_t *pxWriter );
+
+#if( configCLI_USE_PROFILING == 1 )
+
+	/*
+	 * Copy the statistics of the command of index uxIndex, in the order "help"
+	 * lists the commands, into *pxStats, and set *ppxCommand to the command.
+	 * Returns pdFALSE if there are not that many commands.
+	 */
+	BaseType_t FreeRTOS_CLIGetCommandStats( UBaseType_t uxIndex, const CLI_Command_Definition_t **ppxCommand, CLI_Command_Stats_t *pxStats );
+
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
  * A buffer into which command outputs can be written is declared in the
  * main command interpreter, rather than in the command console implementation,
  * to allow application that provide access to the command console via multiple
- * interfaces to share a buffer, and therefore save RAM.  Note, however, that
- * the command interpreter itself is not re-entrant, so only one command
- * console interface can be used at any one time.  For that reason, no attempt
- * is made to provide any mutual exclusion mechanism on the output buffer.
+ * interfaces to share a buffer, and therefore save RAM.  It is the output
+ * buffer of the default context, so only the command console interfaces that
+ * use FreeRTOS_CLIProcessCommand() share it.  No attempt is made to provide any
+ * mutual exclusion mechanism on the output buffer.
  *
  * FreeRTOS_CLIGetOutputBuffer() returns the address of the output buffer.
  */
 char *FreeRTOS_CLIGetOutputBuffer( void );
 
+/*
+ * Return the output buffer given to FreeRTOS_CLIInitContext() for pxContext.
+ */
+char *FreeRTOS_CLIGetContextOutputBuffer( CLI_Context_t *pxContext );
+
 /*
  * Return a pointer to the xParameterNumber'th word in pcCommandString.
  */
 const char *FreeRTOS_CLIGetParameter( const char *pcCommandString, UBaseType_t uxWantedParameter, BaseType_t *pxParameterStringLength );
 
+/*
+ * Split pcCommandString in one pass into at most xMaxArguments words, as the
+ * command interpreter does for an argument vector callback.  The words are
+ * copied into the xBufferLength bytes pcBuffer, and ppcArgv is set to point to
+ * them.  Returns the number of words, or -1 if pcCommandString has too many
+ * words, does not fit in pcBuffer or has an unterminated quote.
+ */
+BaseType_t FreeRTOS_CLITokenize( const char *pcCommandString, char *pcBuffer, size_t xBufferLength, const char **ppcArgv, BaseType_t xMaxArguments );
+
 /* *INDENT-OFF* */
 #ifdef __cplusplus
     }
@@ -0,0 +1,152 @@
+/*
+ * FreeRTOS kernel configuration of the demo built for Linux on the FreeRTOS
+ * POSIX port. The application settings match ST_Code/Core/Inc/FreeRTOSConfig.h
+ * so that the CLI server behaves as on the board.
+ *
+ * See http://www.freertos.org/a00110.html
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <stdint.h>
+
+#define configUSE_PREEMPTION                      1
+#define configSUPPORT_STATIC_ALLOCATION           1
+#define configSUPPORT_DYNAMIC_ALLOCATION          1
+#define configUSE_IDLE_HOOK                       0
+#define configUSE_TICK_HOOK                       0
+#define configUSE_MALLOC_FAILED_HOOK              1
+#define configTICK_RATE_HZ                        ( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES                      ( 56 )
+
+/* Every task runs on its own thread, whose stack is taken from the task stack
+ * in the POSIX port, so the smallest stack must hold PTHREAD_STACK_MIN bytes
+ * and the frames of the C library of the host. Stack sizes are in words. */
+#define configMINIMAL_STACK_SIZE                  ( ( uint16_t ) 4096 )
+#define configTOTAL_HEAP_SIZE                     ( ( size_t ) ( 16 * 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN                   ( 16 )
+#define configUSE_16_BIT_TICKS                    0
+#define configUSE_MUTEXES                         1
+#define configQUEUE_REGISTRY_SIZE                 8
+#define configUSE_RECURSIVE_MUTEXES               1
+#define configUSE_COUNTING_SEMAPHORES             1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION   0
+#define configMESSAGE_BUFFER_LENGTH_TYPE          size_t
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES                     0
+#define configMAX_CO_ROUTINE_PRIORITIES           ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS                          1
+#define configTIMER_TASK_PRIORITY                 ( 2 )
+#define configTIMER_QUEUE_LENGTH                  10
+#define configTIMER_TASK_STACK_DEPTH              ( configMINIMAL_STACK_SIZE * 2 )
+
+/* The C library of the host is thread safe. */
+#define configUSE_NEWLIB_REENTRANT                0
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet                  1
+#define INCLUDE_uxTaskPriorityGet                 1
+#define INCLUDE_vTaskDelete                       1
+#define INCLUDE_vTaskCleanUpResources             0
+#define INCLUDE_vTaskSuspend                      1
+#define INCLUDE_vTaskDelayUntil                   1
+#define INCLUDE_vTaskDelay                        1
+#define INCLUDE_xTaskGetSchedulerState            1
+#define INCLUDE_xTimerPendFunctionCall            1
+#define INCLUDE_xQueueGetMutexHolder              1
+#define INCLUDE_uxTaskGetStackHighWaterMark       1
+#define INCLUDE_xTaskGetCurrentTaskHandle         1
+#define INCLUDE_eTaskGetState                     1
+
+/* Normal assert() semantics without relying on the provision of an assert.h
+header file. */
+extern void vAssertCalled( const char * pcFile,
+                           uint32_t ulLine );
+#define configASSERT( x )    if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+/* Network configuration. The host reaches the demo through the interface
+selected below, see Posix_Code/Makefile. */
+#ifndef configNETWORK_INTERFACE_TO_USE
+    #define configNETWORK_INTERFACE_TO_USE      1L
+#endif
+
+#define configMAC_ADDR0                         0x00
+#define configMAC_ADDR1                         0x11
+#define configMAC_ADDR2                         0x22
+#define configMAC_ADDR3                         0x33
+#define configMAC_ADDR4                         0x44
+#define configMAC_ADDR5                         0x46
+
+/* Static IP address configuration, the host build does not use DHCP. */
+#define configIP_ADDR0                          192
+#define configIP_ADDR1                          168
+#define configIP_ADDR2                          100
+#define configIP_ADDR3                          2
+
+#define configGATEWAY_ADDR0                     192
+#define configGATEWAY_ADDR1                     168
+#define configGATEWAY_ADDR2                     100
+#define configGATEWAY_ADDR3                     1
+
+#define configDNS_SERVER_ADDR0                  192
+#define configDNS_SERVER_ADDR1                  168
+#define configDNS_SERVER_ADDR2                  100
+#define configDNS_SERVER_ADDR3                  1
+
+#define configNET_MASK0                         255
+#define configNET_MASK1                         255
+#define configNET_MASK2                         255
+#define configNET_MASK3                         0
+
+#define configECHO_SERVER_ADDR0                 192
+#define configECHO_SERVER_ADDR1                 168
+#define configECHO_SERVER_ADDR2                 100
+#define configECHO_SERVER_ADDR3                 1
+
+/* Logging related configuration. */
+extern void vLoggingPrintf( const char * pcFormat, ... );
+extern void vPrintStringToUart( const char *str );
+
+#define configPRINTF( x )                       vLoggingPrintf x
+#define configPRINT_STRING( x )                 vPrintStringToUart( x )
+#define configLOGGING_MAX_MESSAGE_LENGTH        128
+
+/* CLI related configurations. */
+#define configCLI_SERVER_PORT                   1234
+#define configMAX_COMMAND_INPUT_SIZE            128
+#define configCOMMAND_INT_MAX_OUTPUT_SIZE       1024
+
+/* The commands of Demo/commands are looked up in the table generated by
+Demo/commands/cli_command_table.py. */
+#define configCLI_USE_STATIC_COMMAND_TABLE      1
+
+/* Any command line that fits in the input buffer of the CLI server can be split
+into an argument vector. */
+#define configCLI_ARGUMENT_BUFFER_SIZE          ( configMAX_COMMAND_INPUT_SIZE + 1 )
+
+/* Every command is profiled, for cli-stats, with the cycle count the host
+derives from its monotonic clock in place of the DWT cycle counter. */
+extern uint32_t ulHostGetCycleCount( void );
+#define configCLI_USE_PROFILING                 1
+#define configCLI_PROFILING_GET_CYCLES()        ulHostGetCycleCount()
+
+/* Kernel stats related. There is no TIM7 on the host, the 10 kHz run time
+counter is derived from the monotonic clock instead. */
+extern uint32_t ulHostGetTim7Tick( void );
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        ulHostGetTim7Tick()
+
+/* Trace related configs. */
+#define configUSE_TRACE_FACILITY                1
+#define configTD_LOGGER_BUFFER_SIZE             1024
+#define FREERTOS_TD_GET_TIME()                  ulHostGetTim7Tick()
+#include "FreeRTOS_TD_Logger.h"
+
+#endif /* FREERTOS_CONFIG_H */
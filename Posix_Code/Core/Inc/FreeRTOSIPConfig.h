@@ -0,0 +1,41 @@
+/*
+ * FreeRTOS+TCP configuration of the demo built for Linux on the FreeRTOS POSIX
+ * port.
+ *
+ * The board configuration in ST_Code/Core/Inc/FreeRTOSIPConfig.h is used as
+ * is, except for the settings which depend on the STM32H7 Ethernet MAC: the
+ * Linux and the loopback drivers neither compute checksums, nor filter frames,
+ * nor support zero copy.
+ */
+
+#ifndef POSIX_FREERTOS_IP_CONFIG_H
+#define POSIX_FREERTOS_IP_CONFIG_H
+
+#include_next "FreeRTOSIPConfig.h"
+
+#undef ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM
+#undef ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM
+#define ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM          ( 0 )
+#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM          ( 0 )
+
+#undef ipconfigZERO_COPY_RX_DRIVER
+#undef ipconfigZERO_COPY_TX_DRIVER
+#define ipconfigZERO_COPY_RX_DRIVER                     ( 0 )
+#define ipconfigZERO_COPY_TX_DRIVER                     ( 0 )
+
+#undef ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES
+#undef ipconfigETHERNET_DRIVER_FILTERS_PACKETS
+#define ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES     0
+#define ipconfigETHERNET_DRIVER_FILTERS_PACKETS         ( 0 )
+
+/* The address given in FreeRTOSConfig.h is used, there is no DHCP server on
+ * the host interface. */
+#undef ipconfigUSE_DHCP
+#define ipconfigUSE_DHCP                                0
+
+/* Running out of network buffers is not fatal on the host, where the Linux
+ * driver may receive bursts of unrelated traffic. */
+#undef iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER
+#define iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER()
+
+#endif /* POSIX_FREERTOS_IP_CONFIG_H */
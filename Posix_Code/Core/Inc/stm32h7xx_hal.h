@@ -0,0 +1,89 @@
+/*
+ * Stand-in for the STM32H7 HAL in the demo built for Linux on the FreeRTOS
+ * POSIX port.
+ *
+ * Only the part of the HAL used by the Demo sources is declared. The functions
+ * are implemented in Posix_Code/Core/Src/hal_stubs.c on top of the host:
+ * - UART3 writes to the standard output.
+ * - RNG reads the random number generator of the host.
+ * - The MPU configuration has no effect.
+ * - NVIC_SystemReset() exits the process.
+ */
+
+#ifndef STM32H7XX_HAL_H
+#define STM32H7XX_HAL_H
+
+/* Standard includes. */
+#include <stdint.h>
+
+/*-----------------------------------------------------------*/
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    void * Instance;
+} UART_HandleTypeDef;
+
+typedef struct
+{
+    void * Instance;
+} RNG_HandleTypeDef;
+
+typedef struct
+{
+    uint8_t Enable;
+    uint8_t Number;
+    uint32_t BaseAddress;
+    uint8_t Size;
+    uint8_t SubRegionDisable;
+    uint8_t TypeExtField;
+    uint8_t AccessPermission;
+    uint8_t DisableExec;
+    uint8_t IsShareable;
+    uint8_t IsCacheable;
+    uint8_t IsBufferable;
+} MPU_Region_InitTypeDef;
+
+/*-----------------------------------------------------------*/
+
+#define MPU_REGION_ENABLE                ( ( uint8_t ) 0x01 )
+#define MPU_REGION_SIZE_256KB            ( ( uint8_t ) 0x11 )
+#define MPU_REGION_FULL_ACCESS           ( ( uint8_t ) 0x03 )
+#define MPU_ACCESS_NOT_BUFFERABLE        ( ( uint8_t ) 0x00 )
+#define MPU_ACCESS_NOT_CACHEABLE         ( ( uint8_t ) 0x00 )
+#define MPU_ACCESS_SHAREABLE             ( ( uint8_t ) 0x01 )
+#define MPU_REGION_NUMBER0               ( ( uint8_t ) 0x00 )
+#define MPU_TEX_LEVEL1                   ( ( uint8_t ) 0x01 )
+#define MPU_INSTRUCTION_ACCESS_ENABLE    ( ( uint8_t ) 0x00 )
+#define MPU_PRIVILEGED_DEFAULT           ( ( uint32_t ) 0x04 )
+
+/*-----------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_UART_Transmit( UART_HandleTypeDef * huart,
+                                     const uint8_t * pData,
+                                     uint16_t Size,
+                                     uint32_t Timeout );
+
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber( RNG_HandleTypeDef * hrng,
+                                                uint32_t * random32bit );
+
+void HAL_MPU_Disable( void );
+
+void HAL_MPU_Enable( uint32_t MPU_Control );
+
+void HAL_MPU_ConfigRegion( MPU_Region_InitTypeDef * MPU_Init );
+
+uint32_t HAL_GetTick( void );
+
+void NVIC_SystemReset( void );
+
+/*-----------------------------------------------------------*/
+
+#endif /* STM32H7XX_HAL_H */
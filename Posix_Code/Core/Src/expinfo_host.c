@@ -0,0 +1,115 @@
+/*
+ * Exception info of the demo built for Linux on the FreeRTOS POSIX port.
+ *
+ * The board stores a dump of the registers and of the RAM in flash. There is
+ * no such dump to take on the host, so ExpInfo_StoreInfo() stores nothing and
+ * the "flash" is a file instead: a dump read from a board and saved as
+ * expinfoHOST_FILE is served by the coredump commands, which allows testing
+ * the transfer and the coredump parser without a board.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Interface includes. */
+#include "expinfo.h"
+
+/* File holding the exception info. */
+#ifndef expinfoHOST_FILE
+    #define expinfoHOST_FILE    "expinfo.bin"
+#endif
+
+/*-----------------------------------------------------------*/
+
+static uint8_t * pucInfo = NULL;
+static uint32_t ulInfoLength = 0;
+
+/*-----------------------------------------------------------*/
+
+static void prvLoadInfo( void );
+
+/*-----------------------------------------------------------*/
+
+static void prvLoadInfo( void )
+{
+    FILE * pxFile;
+    long lLength;
+
+    if( pucInfo == NULL )
+    {
+        pxFile = fopen( expinfoHOST_FILE, "rb" );
+
+        if( pxFile != NULL )
+        {
+            if( ( fseek( pxFile, 0, SEEK_END ) == 0 ) &&
+                ( ( lLength = ftell( pxFile ) ) > 0 ) &&
+                ( fseek( pxFile, 0, SEEK_SET ) == 0 ) )
+            {
+                pucInfo = malloc( ( size_t ) lLength );
+
+                if( ( pucInfo != NULL ) &&
+                    ( fread( pucInfo, 1, ( size_t ) lLength, pxFile ) == ( size_t ) lLength ) )
+                {
+                    ulInfoLength = ( uint32_t ) lLength;
+                }
+                else
+                {
+                    free( pucInfo );
+                    pucInfo = NULL;
+                }
+            }
+
+            ( void ) fclose( pxFile );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t ExpInfo_StoreInfo( void )
+{
+    /* There are no registers nor RAM sections to dump on the host. */
+    return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t ExpInfo_GetInfo( const uint8_t ** pxExceptionInfo,
+                            uint32_t * pxExceptionInfoLength )
+{
+    BaseType_t xResult = pdFALSE;
+
+    prvLoadInfo();
+
+    if( ( pxExceptionInfo != NULL ) && ( pxExceptionInfoLength != NULL ) && ( pucInfo != NULL ) )
+    {
+        *pxExceptionInfo = pucInfo;
+        *pxExceptionInfoLength = ulInfoLength;
+        xResult = pdTRUE;
+    }
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+void ExpInfo_CleanInfo( void )
+{
+    free( pucInfo );
+    pucInfo = NULL;
+    ulInfoLength = 0;
+
+    ( void ) remove( expinfoHOST_FILE );
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t ExpInfo_InfoExist( void )
+{
+    prvLoadInfo();
+
+    return ( pucInfo != NULL ) ? pdTRUE : pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,133 @@
+/*
+ * Host implementation of the STM32H7 HAL functions and of the TIM7 and DWT
+ * counters used by the Demo sources, for the demo built for Linux on the
+ * FreeRTOS POSIX port.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
+
+/* STM includes. */
+#include "stm32h7xx_hal.h"
+
+/* Netstat includes. */
+#include "netstat_capture.h"
+
+/*-----------------------------------------------------------*/
+
+UART_HandleTypeDef huart3;
+
+RNG_HandleTypeDef hrng;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetMonotonicNs( void );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetMonotonicNs( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &( xNow ) );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_UART_Transmit( UART_HandleTypeDef * huart,
+                                     const uint8_t * pData,
+                                     uint16_t Size,
+                                     uint32_t Timeout )
+{
+    ( void ) huart;
+    ( void ) Timeout;
+
+    ( void ) fwrite( pData, 1, Size, stdout );
+    ( void ) fflush( stdout );
+
+    return HAL_OK;
+}
+
+/*-----------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber( RNG_HandleTypeDef * hrng,
+                                                uint32_t * random32bit )
+{
+    HAL_StatusTypeDef xStatus = HAL_ERROR;
+
+    ( void ) hrng;
+
+    if( getrandom( random32bit, sizeof( *random32bit ), 0 ) == ( ssize_t ) sizeof( *random32bit ) )
+    {
+        xStatus = HAL_OK;
+    }
+
+    return xStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+void HAL_MPU_Disable( void )
+{
+}
+
+/*-----------------------------------------------------------*/
+
+void HAL_MPU_Enable( uint32_t MPU_Control )
+{
+    ( void ) MPU_Control;
+}
+
+/*-----------------------------------------------------------*/
+
+void HAL_MPU_ConfigRegion( MPU_Region_InitTypeDef * MPU_Init )
+{
+    ( void ) MPU_Init;
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t HAL_GetTick( void )
+{
+    return ( uint32_t ) ( prvGetMonotonicNs() / 1000000ULL );
+}
+
+/*-----------------------------------------------------------*/
+
+void NVIC_SystemReset( void )
+{
+    /* There is nothing to reset, exit and let the user start the demo again. */
+    ( void ) fflush( stdout );
+    _exit( EXIT_FAILURE );
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t ulHostGetTim7Tick( void )
+{
+    /* TIM7 ticks at 10 kHz on the board. */
+    return ( uint32_t ) ( prvGetMonotonicNs() / 100000ULL );
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t ulHostGetCycleCount( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &( xNow ) );
+
+    /* The DWT cycle counter runs at CLOCK_SPEED_HTZ on the board. The seconds
+     * and the nanoseconds are scaled apart to stay within 64 bits. */
+    return ( uint32_t ) ( ( ( uint64_t ) xNow.tv_sec * CLOCK_SPEED_HTZ ) +
+                          ( ( ( uint64_t ) xNow.tv_nsec * CLOCK_SPEED_HTZ ) / 1000000000ULL ) );
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,20 @@
+/*
+ * Entry point of the demo built for Linux on the FreeRTOS POSIX port.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    extern void app_main( void );
+
+    /* app_main() starts the scheduler and does not return. */
+    app_main();
+
+    return EXIT_FAILURE;
+}
+
+/*-----------------------------------------------------------*/
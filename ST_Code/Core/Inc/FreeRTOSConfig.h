@@ -65,6 +65,7 @@
 #define configUSE_IDLE_HOOK                       0
 #define configUSE_TICK_HOOK                       0
 #define configUSE_MALLOC_FAILED_HOOK              1
+#define configCHECK_FOR_STACK_OVERFLOW            2
 #define configCPU_CLOCK_HZ                        ( SystemCoreClock )
 #define configTICK_RATE_HZ                        ( ( TickType_t )1000 )
 #define configMAX_PRIORITIES                      ( 56 )
@@ -229,6 +230,20 @@ extern void vPrintStringToUart( const char *str );
 #define configMAX_COMMAND_INPUT_SIZE            128
 #define configCOMMAND_INT_MAX_OUTPUT_SIZE       1024
 
+/* The commands of Demo/commands are looked up in the table generated by
+Demo/commands/cli_command_table.py. */
+#define configCLI_USE_STATIC_COMMAND_TABLE      1
+
+/* Any command line that fits in the input buffer of the CLI server can be split
+into an argument vector. */
+#define configCLI_ARGUMENT_BUFFER_SIZE          ( configMAX_COMMAND_INPUT_SIZE + 1 )
+
+/* Every command is profiled, for cli-stats, with the DWT cycle counter started
+by app_main(). */
+extern uint32_t ulGetCycleCount( void );
+#define configCLI_USE_PROFILING                 1
+#define configCLI_PROFILING_GET_CYCLES()        ulGetCycleCount()
+
 /* Kernel stats related. */
 extern uint32_t ulGetTim7Tick( void );
 #define configGENERATE_RUN_TIME_STATS           1